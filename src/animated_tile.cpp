@@ -17,6 +17,9 @@
 #include "date_func.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 
+#include <array>
+#include <vector>
+
 #include INCLUDE_FOR_PREFETCH_NTA
 
 #include "safeguards.h"
@@ -24,6 +27,71 @@
 /** The table/list with animated tiles. */
 btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
 
+/**
+ * One slot of the animated tile timing wheel.
+ * A tile with animation speed S is animated on every tick which is a multiple of 2^S,
+ * so all tiles of the same speed share the same next animation tick, and there is one slot per speed.
+ * Entries are not removed when a tile is deleted or changes speed, these stale entries are
+ * dropped when the slot is next due, or earlier if they make up most of the slot.
+ */
+struct AnimatedTileWheelSlot {
+	std::vector<TileIndex> tiles; ///< Tiles of this speed, may contain stale or duplicate entries
+	uint stale = 0;               ///< Number of entries which may be stale
+	bool sorted = true;           ///< Whether tiles is sorted and free of duplicates
+};
+
+static const uint ANIMATED_TILE_WHEEL_SLOTS = 33; ///< Speeds 0 to 32, tiles with higher speeds are never animated
+static std::array<AnimatedTileWheelSlot, ANIMATED_TILE_WHEEL_SLOTS> _animated_tile_wheel;
+static std::vector<TileIndex> _animated_tiles_due; ///< Tiles which are due in the current tick, in tile order
+static uint32_t _animated_tile_changes = 0;        ///< Incremented whenever a tile is deleted or changes speed
+
+/**
+ * Drop stale and duplicate entries from a slot of the animated tile timing wheel, and sort it.
+ * @param speed Speed of the slot.
+ */
+static void CompactAnimatedTileWheelSlot(uint8_t speed)
+{
+	AnimatedTileWheelSlot &slot = _animated_tile_wheel[speed];
+	if (!slot.sorted) {
+		std::sort(slot.tiles.begin(), slot.tiles.end());
+		slot.tiles.erase(std::unique(slot.tiles.begin(), slot.tiles.end()), slot.tiles.end());
+		slot.sorted = true;
+	}
+	if (slot.stale > 0) {
+		slot.tiles.erase(std::remove_if(slot.tiles.begin(), slot.tiles.end(), [speed](TileIndex tile) {
+			const auto iter = _animated_tiles.find(tile);
+			return iter == _animated_tiles.end() || iter->second.speed != speed;
+		}), slot.tiles.end());
+		slot.stale = 0;
+	}
+}
+
+static void AddToAnimatedTileWheel(TileIndex tile, uint8_t speed)
+{
+	if (speed >= ANIMATED_TILE_WHEEL_SLOTS) return;
+
+	AnimatedTileWheelSlot &slot = _animated_tile_wheel[speed];
+	if (slot.sorted && !slot.tiles.empty() && slot.tiles.back() >= tile) slot.sorted = false;
+	slot.tiles.push_back(tile);
+}
+
+static void MarkAnimatedTileWheelStale(uint8_t speed)
+{
+	_animated_tile_changes++;
+	if (speed >= ANIMATED_TILE_WHEEL_SLOTS) return;
+
+	AnimatedTileWheelSlot &slot = _animated_tile_wheel[speed];
+	slot.stale++;
+	if (slot.stale > 64 && slot.stale > slot.tiles.size() / 2) CompactAnimatedTileWheelSlot(speed);
+}
+
+static void ClearAnimatedTileWheel()
+{
+	for (AnimatedTileWheelSlot &slot : _animated_tile_wheel) {
+		slot = {};
+	}
+}
+
 /**
  * Removes the given tile from the animated tile table.
  * @param tile the tile to remove
@@ -31,8 +99,9 @@ btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
 void DeleteAnimatedTile(TileIndex tile)
 {
 	auto to_remove = _animated_tiles.find(tile);
-	if (to_remove != _animated_tiles.end() && !to_remove->second.pending_deletion) {
-		to_remove->second.pending_deletion = true;
+	if (to_remove != _animated_tiles.end()) {
+		MarkAnimatedTileWheelStale(to_remove->second.speed);
+		_animated_tiles.erase(to_remove);
 		MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE);
 	}
 }
@@ -75,15 +144,21 @@ static void UpdateAnimatedTileSpeed(TileIndex tile, AnimatedTileInfo &info)
 void AddAnimatedTile(TileIndex tile, bool mark_dirty)
 {
 	if (mark_dirty) MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE);
-	AnimatedTileInfo &info = _animated_tiles[tile];
-	UpdateAnimatedTileSpeed(tile, info);
-	info.pending_deletion = false;
+	auto [iter, inserted] = _animated_tiles.insert({ tile, AnimatedTileInfo{} });
+	const uint8_t old_speed = iter->second.speed;
+	UpdateAnimatedTileSpeed(tile, iter->second);
+	if (inserted) {
+		AddToAnimatedTileWheel(tile, iter->second.speed);
+	} else if (iter->second.speed != old_speed) {
+		MarkAnimatedTileWheelStale(old_speed);
+		AddToAnimatedTileWheel(tile, iter->second.speed);
+	}
 }
 
 int GetAnimatedTileSpeed(TileIndex tile)
 {
 	const auto iter = _animated_tiles.find(tile);
-	if (iter != _animated_tiles.end() && !iter->second.pending_deletion) {
+	if (iter != _animated_tiles.end()) {
 		return iter->second.speed;
 	}
 	return -1;
@@ -99,61 +174,68 @@ void AnimateAnimatedTiles()
 	extern void AnimateTile_Industry(TileIndex tile);
 	extern void AnimateTile_Object(TileIndex tile);
 
-	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	PerformanceAccumulator framerate(PFE_GL_ANIMATED_TILES);
 
 	const uint32_t ticks = (uint) _scaled_tick_counter;
 	const uint8_t max_speed = (ticks == 0) ? 32 : FindFirstBit(ticks);
 
-	auto iter = _animated_tiles.begin();
-	while (iter != _animated_tiles.end()) {
-		if (iter->second.pending_deletion) {
-			iter = _animated_tiles.erase(iter);
-			continue;
-		}
+	/* Only the slots of the speeds which are due in this tick are visited, merge them into tile order. */
+	_animated_tiles_due.clear();
+	for (uint8_t speed = 0; speed <= max_speed; speed++) {
+		AnimatedTileWheelSlot &slot = _animated_tile_wheel[speed];
+		if (!slot.sorted || slot.stale > 0) CompactAnimatedTileWheelSlot(speed);
+		if (slot.tiles.empty()) continue;
+
+		const size_t mid = _animated_tiles_due.size();
+		_animated_tiles_due.insert(_animated_tiles_due.end(), slot.tiles.begin(), slot.tiles.end());
+		std::inplace_merge(_animated_tiles_due.begin(), _animated_tiles_due.begin() + mid, _animated_tiles_due.end());
+	}
 
-		auto next = iter;
-		++next;
-		if (next != _animated_tiles.end()) {
-			PREFETCH_NTA(&(next->second));
+	const uint32_t changes = _animated_tile_changes;
+	const size_t count = _animated_tiles_due.size();
+	for (size_t i = 0; i < count; i++) {
+		const TileIndex curr = _animated_tiles_due[i];
+		if (i + 1 < count) PREFETCH_NTA(&_m[_animated_tiles_due[i + 1]]);
+
+		if (_animated_tile_changes != changes) {
+			/* An earlier tile in this tick deleted or changed the speed of other tiles, check that this one is still due. */
+			const auto iter = _animated_tiles.find(curr);
+			if (iter == _animated_tiles.end() || iter->second.speed > max_speed) continue;
 		}
 
-		if (iter->second.speed <= max_speed) {
-			const TileIndex curr = iter->first;
-			switch (GetTileType(curr)) {
-				case MP_HOUSE:
-					AnimateTile_Town(curr);
-					break;
+		switch (GetTileType(curr)) {
+			case MP_HOUSE:
+				AnimateTile_Town(curr);
+				break;
 
-				case MP_STATION:
-					AnimateTile_Station(curr);
-					break;
+			case MP_STATION:
+				AnimateTile_Station(curr);
+				break;
 
-				case MP_INDUSTRY:
-					AnimateTile_Industry(curr);
-					break;
+			case MP_INDUSTRY:
+				AnimateTile_Industry(curr);
+				break;
 
-				case MP_OBJECT:
-					AnimateTile_Object(curr);
-					break;
+			case MP_OBJECT:
+				AnimateTile_Object(curr);
+				break;
 
-				default:
-					NOT_REACHED();
-			}
+			default:
+				NOT_REACHED();
 		}
-		iter = next;
 	}
 }
 
+/**
+ * Update the speeds of all animated tiles, and rebuild the animated tile timing wheel.
+ * This must be called after the animated tile table has been changed directly, such as when loading.
+ */
 void UpdateAllAnimatedTileSpeeds()
 {
-	auto iter = _animated_tiles.begin();
-	while (iter != _animated_tiles.end()) {
-		if (iter->second.pending_deletion) {
-			iter = _animated_tiles.erase(iter);
-			continue;
-		}
-		UpdateAnimatedTileSpeed(iter->first, iter->second);
-		++iter;
+	ClearAnimatedTileWheel();
+	for (auto &it : _animated_tiles) {
+		UpdateAnimatedTileSpeed(it.first, it.second);
+		AddToAnimatedTileWheel(it.first, it.second.speed);
 	}
 }
 
@@ -163,4 +245,5 @@ void UpdateAllAnimatedTileSpeeds()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.clear();
+	ClearAnimatedTileWheel();
 }
@@ -15,7 +15,6 @@
 
 struct AnimatedTileInfo {
 	uint8_t speed = 0;
-	bool pending_deletion = false;
 };
 
 extern btree::btree_map<TileIndex, AnimatedTileInfo> _animated_tiles;
@@ -93,6 +93,7 @@ inline int GetBridgePixelHeight(TileIndex tile)
 inline void ClearSingleBridgeMiddle(TileIndex t, Axis a)
 {
 	ClrBit(_m[t].type, 2 + a);
+	_ms[t].type = _m[t].type;
 }
 
 /**
@@ -113,6 +114,7 @@ inline void ClearBridgeMiddle(TileIndex t)
 inline void SetBridgeMiddle(TileIndex t, Axis a)
 {
 	SetBit(_m[t].type, 2 + a);
+	_ms[t].type = _m[t].type;
 }
 
 /**
@@ -381,6 +381,23 @@ static void TileLoop_Clear(TileIndex tile)
 	MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE_NON_VEG);
 }
 
+static bool TileLoopIdle_Clear(TileIndex tile)
+{
+	/* Desert and snow depend on neighbouring tiles */
+	if (_settings_game.game_creation.landscape == LT_TROPIC || _settings_game.game_creation.landscape == LT_ARCTIC) return false;
+
+	switch (GetClearGround(tile)) {
+		case CLEAR_GRASS:
+			return GetClearDensity(tile) == 3;
+
+		case CLEAR_FIELDS:
+			return false;
+
+		default:
+			return true;
+	}
+}
+
 void GenerateClearTile()
 {
 	uint i, gi;
@@ -474,4 +491,5 @@ extern const TileTypeProcs _tile_type_clear_procs = {
 	nullptr,                     ///< vehicle_enter_tile_proc
 	GetFoundation_Clear,      ///< get_foundation_proc
 	TerraformTile_Clear,      ///< terraform_tile_proc
+	TileLoopIdle_Clear,       ///< tile_loop_idle_proc
 };
@@ -34,6 +34,7 @@
 #include "debug_settings.h"
 #include "debug_desync.h"
 #include "order_backup.h"
+#include "tracerestrict_memo.h"
 #include "core/ring_buffer.hpp"
 #include "core/checksum_func.hpp"
 #include "3rdparty/nlohmann/json.hpp"
@@ -876,7 +877,10 @@ CommandCost DoCommandEx(TileIndex tile, uint32_t p1, uint32_t p2, uint64_t p3, D
 	/* Execute the command here. All cost-relevant functions set the expenses type
 	 * themselves to the cost object at some point */
 	if (_docommand_recursive == 1) _cleared_object_areas.clear();
-	res = command.Execute(tile, flags, p1, p2, p3, text, aux_data);
+	{
+		TraceRestrictMemoSuspendScope memo_suspend;
+		res = command.Execute(tile, flags, p1, p2, p3, text, aux_data);
+	}
 	if (res.Failed()) {
 error:
 		_docommand_recursive--;
@@ -1077,6 +1081,15 @@ void ClearCommandQueue()
 	_command_queue.clear();
 }
 
+/**
+ * Is a command being tested or executed?
+ * @return true if inside a command
+ */
+bool IsCommandExecuting()
+{
+	return _docommand_recursive > 0;
+}
+
 void EnqueueDoCommandP(CommandContainer cmd)
 {
 	if (_docommand_recursive == 0) {
@@ -1234,6 +1247,7 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32_t p1, uint32_t p2, uint64_
 	 * use the construction one */
 	_cleared_object_areas.clear();
 	BasePersistentStorageArray::SwitchMode(PSM_ENTER_COMMAND);
+	TraceRestrictMemoSuspendScope memo_suspend;
 	CommandCost res2 = command.Execute(tile, flags | DC_EXEC, p1, p2, p3, text, aux_data);
 	BasePersistentStorageArray::SwitchMode(PSM_LEAVE_COMMAND);
 
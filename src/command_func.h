@@ -84,6 +84,7 @@ inline DoCommandFlag CommandFlagsToDCFlags(CommandFlags cmd_flags)
 void ExecuteCommandQueue();
 void ClearCommandQueue();
 void EnqueueDoCommandP(CommandContainer cmd);
+bool IsCommandExecuting();
 
 /*** All command callbacks that exist ***/
 
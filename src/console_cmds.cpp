@@ -55,6 +55,8 @@
 #include "industry.h"
 #include "string_func_extra.h"
 #include "linkgraph/linkgraphjob.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/yapf/yapf_query_log.h"
 #include "base_media_base.h"
 #include "debug_settings.h"
 #include "walltime_func.h"
@@ -65,6 +67,8 @@
 #include "object_base.h"
 #include "newgrf_newsignals.h"
 #include "roadstop_base.h"
+#include "tracerestrict.h"
+#include "tracerestrict_memo.h"
 #include <time.h>
 
 #include "3rdparty/cpp-btree/btree_set.h"
@@ -2896,6 +2900,162 @@ DEF_CONSOLE_CMD(ConDumpLinkgraphJobs)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConBenchmarkLinkGraph)
+{
+	if (argc == 0) {
+		IConsoleHelp("Benchmark link graph path searches on synthetic graphs. Usage: 'benchmark_linkgraph [<nodes> [<links per node> [<searches>]]]'");
+		IConsoleHelp("Without a node count, graphs of 1000, 2000, 5000 and 10000 nodes are used.");
+		return true;
+	}
+
+	std::vector<uint> sizes = { 1000, 2000, 5000, 10000 };
+	uint links = 4;
+	uint searches = 64;
+	if (argc > 1) sizes = { (uint)atoi(argv[1]) };
+	if (argc > 2) links = atoi(argv[2]);
+	if (argc > 3) searches = atoi(argv[3]);
+
+	for (uint size : sizes) {
+		LinkGraphBenchmarkResult result = BenchmarkLinkGraphPathSearch(size, links, searches);
+		if (result.nodes == 0) {
+			IConsolePrint(CC_ERROR, "Link graph pools are full.");
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Nodes: %u, edges: %u, init: " OTTD_PRINTF64U " us, %u searches: " OTTD_PRINTF64U " us (" OTTD_PRINTF64U " us per search), batched: " OTTD_PRINTF64U " us",
+				result.nodes, result.edges, result.init_us, result.searches, result.search_us, result.search_us / result.searches, result.batch_search_us);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConCompareLinkGraphMCF)
+{
+	if (argc == 0) {
+		IConsoleHelp("Compare link graph jobs with serial and batched MCF path searches on a synthetic graph. Usage: 'compare_linkgraph_mcf [<nodes> [<links per node>]]'");
+		return true;
+	}
+
+	uint nodes = 500;
+	uint links = 4;
+	if (argc > 1) nodes = atoi(argv[1]);
+	if (argc > 2) links = atoi(argv[2]);
+
+	LinkGraphMCFComparison result = CompareLinkGraphMCFBatching(nodes, links, _settings_game.linkgraph);
+	if (result.nodes == 0) {
+		IConsolePrint(CC_ERROR, "Link graph pools are full.");
+		return true;
+	}
+	IConsolePrintF(CC_DEFAULT, "Nodes: %u, edges: %u, serial: " OTTD_PRINTF64U " us, batched: " OTTD_PRINTF64U " us",
+			result.nodes, result.edges, result.serial_us, result.batched_us);
+	IConsolePrintF(result.differing_edges == 0 ? CC_DEFAULT : CC_ERROR, "Total flow: serial: " OTTD_PRINTF64U ", batched: " OTTD_PRINTF64U ", %u edges differ by " OTTD_PRINTF64U " in total",
+			result.serial_flow, result.batched_flow, result.differing_edges, result.flow_difference);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkTraceRestrict)
+{
+	if (argc == 0) {
+		IConsoleHelp("Benchmark interpreted and compiled execution of the routefinding restriction programs of the current game, for all trains, without changing any state. Usage: 'benchmark_tracerestrict [<iterations>]'");
+		return true;
+	}
+
+	uint iterations = 10;
+	if (argc > 1) iterations = std::max(1, atoi(argv[1]));
+
+	TraceRestrictBenchmarkResult result = BenchmarkTraceRestrictPrograms(iterations);
+	if (result.programs == 0 || result.trains == 0) {
+		IConsolePrint(CC_DEFAULT, "No programs or no trains.");
+		return true;
+	}
+
+	const uint64_t executions = (uint64_t)result.programs * result.trains * result.iterations;
+	auto ns_per_execution = [&](uint64_t us) -> uint64_t {
+		return (us * 1000) / executions;
+	};
+	IConsolePrintF(CC_DEFAULT, "Programs: %u, trains: %u, iterations: %u", result.programs, result.trains, result.iterations);
+	IConsolePrintF(CC_DEFAULT, "  Interpreted: " OTTD_PRINTF64U " us, " OTTD_PRINTF64U " ns per execution", result.interpreted_us, ns_per_execution(result.interpreted_us));
+	IConsolePrintF(CC_DEFAULT, "  Compiled:    " OTTD_PRINTF64U " us, " OTTD_PRINTF64U " ns per execution", result.compiled_us, ns_per_execution(result.compiled_us));
+	if (result.mismatches > 0) {
+		IConsolePrintF(CC_ERROR, "  Results differ for %u executions", result.mismatches);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConTraceRestrictMemoStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the statistics of the per-tick memo of routefinding restriction program results. Usage: 'tracerestrict_memo_stats [reset]'");
+		return true;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+		ResetTraceRestrictMemoStats();
+		IConsolePrint(CC_DEFAULT, "Statistics reset.");
+		return true;
+	}
+
+	const TraceRestrictMemoStats &stats = GetTraceRestrictMemoStats();
+	const uint64_t memoisable = stats.hits + stats.misses;
+	const uint64_t total = memoisable + stats.bypassed;
+	IConsolePrintF(CC_DEFAULT, "Memo hits: " OTTD_PRINTF64U ", misses: " OTTD_PRINTF64U ", hit rate: %u%%",
+			stats.hits, stats.misses, memoisable > 0 ? (uint)((stats.hits * 100) / memoisable) : 0);
+	IConsolePrintF(CC_DEFAULT, "Not memoisable: " OTTD_PRINTF64U ", executions saved: %u%%, invalidations: " OTTD_PRINTF64U,
+			stats.bypassed, total > 0 ? (uint)((stats.hits * 100) / total) : 0, stats.invalidations);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConYapfCacheStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the statistics of the YAPF rail and road segment cost caches. Usage: 'yapf_cache_stats [reset]'");
+		return true;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+		ResetYapfSegmentCacheStats();
+		ResetYapfRoadSegmentCacheStats();
+		IConsolePrint(CC_DEFAULT, "Statistics reset.");
+		return true;
+	}
+
+	auto print_stats = [](const char *name, const YapfSegmentCacheStats &stats) {
+		const uint64_t total = stats.hits + stats.misses;
+		IConsolePrintF(CC_DEFAULT, "%s segment hits: " OTTD_PRINTF64U ", misses: " OTTD_PRINTF64U ", hit rate: %u%%",
+				name, stats.hits, stats.misses, total > 0 ? (uint)((stats.hits * 100) / total) : 0);
+		IConsolePrintF(CC_DEFAULT, "%s tile changes applied: " OTTD_PRINTF64U ", segments invalidated: " OTTD_PRINTF64U ", full flushes: " OTTD_PRINTF64U,
+				name, stats.changed_tiles, stats.invalidated_segments, stats.flushes);
+	};
+	print_stats("Rail", GetYapfSegmentCacheStats());
+	print_stats("Road", GetYapfRoadSegmentCacheStats());
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConYapfQueryLog)
+{
+	if (argc == 0) {
+		IConsoleHelp("Record the pathfinder queries of the game to a file, or compare them with an earlier recording of the same savegame. Usage: 'yapf_query_log [record <file> | replay <file> | stop]'");
+		IConsoleHelp("  Without arguments, shows what the query log has done so far.");
+		return true;
+	}
+
+	if (argc == 3 && (strcmp(argv[1], "record") == 0 || strcmp(argv[1], "replay") == 0)) {
+		if (!YapfQueryLogStart(strcmp(argv[1], "record") == 0 ? YQLM_RECORD : YQLM_REPLAY, argv[2])) {
+			IConsolePrintF(CC_ERROR, "Failed to open: %s", argv[2]);
+		}
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+		IConsolePrint(CC_DEFAULT, YapfQueryLogStatus().c_str());
+		YapfQueryLogStop();
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	IConsolePrint(CC_DEFAULT, YapfQueryLogStatus().c_str());
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConDumpRoadTypes)
 {
 	if (argc == 0) {
@@ -3510,6 +3670,7 @@ DEF_CONSOLE_CMD(ConMiscDebug)
 		IConsoleHelp("Debug: misc flags.  Usage: 'misc_debug [<flags>]'");
 		IConsoleHelp("  1: MDF_OVERHEAT_BREAKDOWN_OPEN_WIN");
 		IConsoleHelp("  2: MDF_ZONING_DEBUG_MODES");
+		IConsoleHelp("  8: MDF_SERIAL_TILE_LOOP");
 		IConsoleHelp(" 10: MDF_NEWGRF_SG_SAVE_RAW");
 		IConsoleHelp(" 20: MDF_SPECIAL_CMDS");
 		return true;
@@ -4183,6 +4344,12 @@ void IConsoleStdLibRegister()
 	IConsole::CmdRegister("dump_load_debug_log",     ConDumpLoadDebugLog, nullptr, true);
 	IConsole::CmdRegister("dump_load_debug_config",  ConDumpLoadDebugConfig, nullptr, true);
 	IConsole::CmdRegister("dump_linkgraph_jobs",     ConDumpLinkgraphJobs, nullptr, true);
+	IConsole::CmdRegister("benchmark_linkgraph",     ConBenchmarkLinkGraph, nullptr, true);
+	IConsole::CmdRegister("compare_linkgraph_mcf",   ConCompareLinkGraphMCF, nullptr, true);
+	IConsole::CmdRegister("benchmark_tracerestrict", ConBenchmarkTraceRestrict, nullptr, true);
+	IConsole::CmdRegister("tracerestrict_memo_stats", ConTraceRestrictMemoStats, nullptr, true);
+	IConsole::CmdRegister("yapf_cache_stats",        ConYapfCacheStats, nullptr, true);
+	IConsole::CmdRegister("yapf_query_log",          ConYapfQueryLog, nullptr, true);
 	IConsole::CmdRegister("dump_road_types",         ConDumpRoadTypes,    nullptr, true);
 	IConsole::CmdRegister("dump_rail_types",         ConDumpRailTypes,    nullptr, true);
 	IConsole::CmdRegister("dump_bridge_types",       ConDumpBridgeTypes,  nullptr, true);
@@ -23,6 +23,8 @@ enum ChickenBitFlags {
 	DCBF_CMD_NO_TEST_ALL               = 6,
 	DCBF_WATER_REGION_CLEAR            = 7,
 	DCBF_WATER_REGION_INIT_ALL         = 8,
+	DCBF_LINKGRAPH_NO_WARM_START       = 10,
+	DCBF_RAIL_REGION_NO_CORRIDOR       = 11,
 };
 
 inline bool HasChickenBit(ChickenBitFlags flag)
@@ -51,7 +53,7 @@ enum MiscDebugFlags {
 	MDF_OVERHEAT_BREAKDOWN_OPEN_WIN,
 	MDF_ZONING_DEBUG_MODES,
 	MDF_UNUSED1,
-	MDF_UNUSED2,
+	MDF_SERIAL_TILE_LOOP,
 	MDF_NEWGRF_SG_SAVE_RAW,
 	MDF_SPECIAL_CMDS,
 };
@@ -389,6 +389,20 @@ bool FioRenameFile(const std::string &oldname, const std::string &newname)
 #endif
 }
 
+/**
+ * Remove a file.
+ * @param filename file name to remove
+ * @return true iff the operation succeeded
+ */
+bool FioRemove(const std::string &filename)
+{
+#if defined(_WIN32)
+	return _wunlink(OTTD2FS(filename).c_str()) == 0;
+#else
+	return unlink(filename.c_str()) == 0;
+#endif
+}
+
 /**
  * Appends, if necessary, the path separator character to the end of the string.
  * It does not add the path separator to zero-sized strings.
@@ -23,6 +23,7 @@ std::string FioGetDirectory(Searchpath sp, Subdirectory subdir);
 std::string FioFindDirectory(Subdirectory subdir);
 void FioCreateDirectory(const std::string &name);
 bool FioRenameFile(const std::string &oldname, const std::string &newname);
+bool FioRemove(const std::string &filename);
 
 const char *FiosGetScreenshotDir();
 
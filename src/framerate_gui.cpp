@@ -23,6 +23,7 @@
 #include "ai/ai_instance.hpp"
 #include "game/game.hpp"
 #include "game/game_instance.hpp"
+#include "worker_thread.h"
 
 #include "widgets/framerate_widget.h"
 
@@ -193,6 +194,7 @@ namespace {
 		PerformanceData(1),                     // PFE_ACC_GL_SHIPS
 		PerformanceData(1),                     // PFE_ACC_GL_AIRCRAFT
 		PerformanceData(1),                     // PFE_GL_LANDSCAPE
+		PerformanceData(1),                     // PFE_GL_ANIMATED_TILES
 		PerformanceData(1),                     // PFE_GL_LINKGRAPH
 		PerformanceData(1000.0 / 30),           // PFE_DRAWING
 		PerformanceData(1),                     // PFE_ACC_DRAWWORLD
@@ -332,6 +334,7 @@ static const PerformanceElement DISPLAY_ORDER_PFE[PFE_MAX] = {
 	PFE_GL_SHIPS,
 	PFE_GL_AIRCRAFT,
 	PFE_GL_LANDSCAPE,
+	PFE_GL_ANIMATED_TILES,
 	PFE_ALLSCRIPTS,
 	PFE_GAMESCRIPT,
 	PFE_AI0,
@@ -1052,6 +1055,7 @@ void ConPrintFramerate()
 		"  GL ship ticks",
 		"  GL aircraft ticks",
 		"  GL landscape ticks",
+		"  GL animated tiles",
 		"  GL link graph delays",
 		"Drawing",
 		"  Viewport drawing",
@@ -1094,6 +1098,27 @@ void ConPrintFramerate()
 		printed_anything = true;
 	}
 
+	if (_general_worker_pool.GetWorkerCount() > 0) {
+		static const char *WORKER_TASK_CLASS_NAMES[WTC_END] = {
+			"other",
+			"viewport drawing",
+			"vehicle ticks",
+			"tile loop",
+			"link graph",
+			"saving/loading",
+			"NewGRF MD5",
+		};
+
+		IConsolePrintF(TC_SILVER, "Worker threads: %u", _general_worker_pool.GetWorkerCount());
+		for (WorkerTaskClass c = WTC_OTHER; c < WTC_END; c = (WorkerTaskClass)(c + 1)) {
+			WorkerTaskStats stats = _general_worker_pool.GetTaskStats(c);
+			if (stats.jobs == 0) continue;
+			IConsolePrintF(TC_LIGHT_BLUE, "  Worker %s jobs: " OTTD_PRINTF64U ", avg: %.3fms, total: %.2fms, stolen: " OTTD_PRINTF64U,
+					WORKER_TASK_CLASS_NAMES[c], stats.jobs, (double)stats.busy_us / stats.jobs / 1000, (double)stats.busy_us / 1000, stats.stolen);
+			printed_anything = true;
+		}
+	}
+
 	if (!printed_anything) {
 		IConsoleWarning("No performance measurements have been taken yet");
 	}
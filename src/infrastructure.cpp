@@ -230,6 +230,7 @@ static void FixAllReservations()
 bool CheckSharingChangePossible(VehicleType type, bool new_value)
 {
 	if (type != VEH_AIRCRAFT) YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	if (type == VEH_ROAD) YapfNotifyRoadLayoutChange(INVALID_TILE);
 	/* Only do something when sharing is being disabled */
 	if (!_settings_game.economy.infrastructure_sharing[type] || new_value) return true;
 
@@ -310,6 +311,7 @@ bool CheckSharingChangePossible(VehicleType type, bool new_value)
 void HandleSharingCompanyDeletion(Owner owner)
 {
 	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
 
 	Vehicle *si_v = nullptr;
 	SCOPE_INFO_FMT([&si_v], "HandleSharingCompanyDeletion: veh: %s", scope_dumper().VehicleInfo(si_v));
@@ -37,6 +37,9 @@
 #include "scope_info.h"
 #include "core/ring_buffer.hpp"
 #include "network/network_sync.h"
+#include "newgrf_generic.h"
+#include "worker_thread.h"
+#include "debug_settings.h"
 #include <array>
 #include <list>
 #include <set>
@@ -742,6 +745,67 @@ void SetupTileLoopCounts()
 	if (accumulator > 0) _tile_loop_counts[0]++;
 }
 
+/** Minimum number of tiles per tick for the tile loop to be run in batched mode. */
+static const uint TILE_LOOP_BATCH_MIN_COUNT = 1 << 12;
+/** Maximum number of tiles per job of the batched tile loop. */
+static const uint TILE_LOOP_BATCH_GRAIN = 1 << 10;
+
+/** Tile of the batched tile loop, with a snapshot of the tile if its tile loop was found to be idle. */
+struct TileLoopBatchEntry {
+	TileIndex tile;
+	bool idle;
+	Tile m;
+	TileExtended me;
+};
+
+static std::vector<TileLoopBatchEntry> _tile_loop_batch;
+
+/**
+ * Run a tick of the tile loop in batched mode.
+ * The tile set of the tick is generated up front and each tile is checked on the worker pool for whether its tile loop proc would be idle.
+ * The tile loop procs are then run in LFSR order as in the serial loop, idle tiles only get their ambient sound effect.
+ * An idle check only depends on the tile itself, so it is still valid if the tile has not been changed by an earlier tile loop proc in the same tick,
+ * otherwise the tile loop proc is run as normal. The result is therefore identical to the serial loop.
+ * @param tile First tile in LFSR order, this is set to the current tile while running, and to the next tile in LFSR order on return.
+ * @param count Number of tiles.
+ * @param feedback LFSR feedback.
+ */
+static void RunTileLoopBatched(TileIndex &tile, uint count, uint32_t feedback)
+{
+	TileIndex next = tile;
+	_tile_loop_batch.resize(count);
+	for (TileLoopBatchEntry &entry : _tile_loop_batch) {
+		entry.tile = next;
+		next = (next >> 1) ^ (-(int32_t)(next & 1) & feedback);
+	}
+
+	{
+		WorkerTaskGroup group(WTC_LANDSCAPE, WJP_HIGH);
+		group.ParallelFor(0, count, TILE_LOOP_BATCH_GRAIN, [](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				TileLoopBatchEntry &entry = _tile_loop_batch[i];
+				TileLoopIdleProc *proc = _tile_type_procs[GetTileTypeShadow(entry.tile)]->tile_loop_idle_proc;
+				entry.idle = (proc != nullptr) && proc(entry.tile);
+				if (entry.idle) {
+					entry.m = _m[entry.tile];
+					entry.me = _me[entry.tile];
+				}
+			}
+		});
+	}
+
+	for (const TileLoopBatchEntry &entry : _tile_loop_batch) {
+		tile = entry.tile;
+		if (entry.idle && MemCmpT(&entry.m, &_m[tile]) == 0 && MemCmpT(&entry.me, &_me[tile]) == 0) {
+			AmbientSoundEffect(tile);
+		} else {
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		}
+	}
+
+	tile = next;
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
@@ -772,16 +836,21 @@ void RunTileLoop(bool apply_day_length)
 		count--;
 	}
 
-	while (count--) {
-		/* Get the next tile in sequence using a Galois LFSR. */
-		TileIndex next = (tile >> 1) ^ (-(int32_t)(tile & 1) & feedback);
-		if (count > 0) {
-			PREFETCH_NTA(&_m[next]);
-		}
+	if (count >= TILE_LOOP_BATCH_MIN_COUNT && _general_worker_pool.GetWorkerCount() > 0 && !HasBit(_misc_debug_flags, MDF_SERIAL_TILE_LOOP)) {
+		RunTileLoopBatched(tile, count, feedback);
+	} else {
+		while (count--) {
+			/* Get the next tile in sequence using a Galois LFSR. */
+			TileIndex next = (tile >> 1) ^ (-(int32_t)(tile & 1) & feedback);
+			if (count > 0) {
+				PREFETCH_NTA(&_ms[next]);
+				PREFETCH_NTA(&_m[next]);
+			}
 
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+			_tile_type_procs[GetTileTypeShadow(tile)]->tile_loop_proc(tile);
 
-		tile = next;
+			tile = next;
+		}
 	}
 
 	_cur_tileloop_tile = tile;
@@ -3,7 +3,9 @@
 #include "../stdafx.h"
 #include "demands.h"
 #include "../core/ring_buffer_queue.hpp"
+#include "../worker_thread.h"
 #include <algorithm>
+#include <queue>
 #include <tuple>
 
 #include "../safeguards.h"
@@ -387,20 +389,50 @@ void DemandCalculator::CalcMinimisedDistanceDemand(LinkGraphJob &job, const std:
 		NodeID from_id;
 		NodeID to_id;
 		uint distance;
+
+		bool operator<(const EdgeCandidate &other) const
+		{
+			return std::tie(this->distance, this->from_id, this->to_id) < std::tie(other.distance, other.from_id, other.to_id);
+		}
 	};
-	std::vector<EdgeCandidate> candidates;
-	candidates.reserve(supplies.size() * demands.size() - std::min(supplies.size(), demands.size()));
-	for (NodeID from_id : supplies) {
-		for (NodeID to_id : demands) {
-			if (from_id != to_id) {
-				candidates.push_back({ from_id, to_id, DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY()) });
+
+	/* Rank the candidates of each supply node concurrently, then merge the rows in order.
+	 * The comparison is a total order, so the merged order doesn't depend on the number of threads. */
+	std::vector<std::vector<EdgeCandidate>> rows(supplies.size());
+	WorkerTaskGroup group(WTC_LINKGRAPH);
+	group.ParallelFor(0, supplies.size(), 16, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const NodeID from_id = supplies[i];
+			const TileIndex from_xy = job[from_id].XY();
+			std::vector<EdgeCandidate> &row = rows[i];
+			row.reserve(demands.size());
+			for (NodeID to_id : demands) {
+				if (from_id != to_id) {
+					row.push_back({ from_id, to_id, DistanceMaxPlusManhattan(from_xy, job[to_id].XY()) });
+				}
 			}
+			std::sort(row.begin(), row.end());
 		}
-	}
-	std::sort(candidates.begin(), candidates.end(), [](const EdgeCandidate &a, const EdgeCandidate &b) {
-		return std::tie(a.distance, a.from_id, a.to_id) < std::tie(b.distance, b.from_id, b.to_id);
 	});
-	for (const EdgeCandidate &candidate : candidates) {
+
+	/* Heap of the next candidate of each row, the best candidate at the top. */
+	struct RowHead {
+		EdgeCandidate candidate;
+		uint row;
+		uint next;
+
+		bool operator<(const RowHead &other) const { return other.candidate < this->candidate; }
+	};
+	std::priority_queue<RowHead> heads;
+	for (uint i = 0; i < (uint)rows.size(); i++) {
+		if (!rows[i].empty()) heads.push({ rows[i][0], i, 1 });
+	}
+	while (!heads.empty()) {
+		RowHead head = heads.top();
+		heads.pop();
+		if (head.next < rows[head.row].size()) heads.push({ rows[head.row][head.next], head.row, head.next + 1 });
+
+		const EdgeCandidate &candidate = head.candidate;
 		if (job[candidate.from_id].UndeliveredSupply() == 0) continue;
 		if (!scaler.HasDemandLeft(job[candidate.to_id])) continue;
 
@@ -444,9 +476,9 @@ DemandCalculator::DemandCalculator(LinkGraphJob &job) :
 	};
 	std::vector<bool> symmetric_edges(se_index(0, size));
 
-	for (auto &it : job.Graph().GetEdges()) {
-		if (it.first.first != it.first.second) {
-			symmetric_edges[se_index(it.first.first, it.first.second)] = true;
+	for (NodeID from = 0; from < size; ++from) {
+		for (Edge edge : job[from].GetEdges()) {
+			symmetric_edges[se_index(from, edge.To())] = true;
 		}
 	}
 	uint first_unseen = 0;
@@ -115,6 +115,9 @@ void LinkGraph::RemoveNode(NodeID id)
 
 	NodeID last_node = this->Size() - 1;
 
+	/* Node IDs are about to change */
+	this->mcf_cache.reset();
+
 	for (auto iter = this->edges.begin(); iter != this->edges.end();) {
 		if (iter->first.first == id || iter->first.second == id) {
 			/* Erase this node */
@@ -149,12 +152,22 @@ void LinkGraph::RemoveNode(NodeID id)
 NodeID LinkGraph::AddNode(const Station *st)
 {
 	const GoodsEntry &good = st->goods[this->cargo];
+	return this->AddNode(st->xy, st->index, HasBit(good.status, GoodsEntry::GES_ACCEPTANCE));
+}
 
+/**
+ * Add a node to the component, without updating any station.
+ * @param xy Location of the node.
+ * @param st Station ID of the node.
+ * @param accepts If the node accepts the cargo.
+ * @return New node's ID.
+ */
+NodeID LinkGraph::AddNode(TileIndex xy, StationID st, bool accepts)
+{
 	NodeID new_node = this->Size();
 	this->nodes.emplace_back();
 
-	this->nodes[new_node].Init(st->xy, st->index,
-			HasBit(good.status, GoodsEntry::GES_ACCEPTANCE));
+	this->nodes[new_node].Init(xy, st, accepts);
 
 	return new_node;
 }
@@ -18,6 +18,7 @@
 #include "../sl/saveload_common.h"
 #include "linkgraph_type.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -91,6 +92,38 @@ public:
 	typedef std::vector<BaseNode> NodeVector;
 	typedef btree::btree_map<std::pair<NodeID, NodeID>, BaseEdge> EdgeMatrix;
 
+	/**
+	 * Flow assigned by the first MCF pass to the demands of one source node.
+	 * This is kept from one job to the next, so that sources whose demands and
+	 * links haven't changed significantly don't have to be solved again.
+	 */
+	struct MCFSourceResult {
+		struct Demand {
+			NodeID dest;      ///< Destination node.
+			uint demand;      ///< Demand towards the destination when the source was solved.
+			uint satisfied;   ///< Part of the demand which was assigned to the legs.
+		};
+
+		struct Leg {
+			NodeID from;      ///< Start node of the edge.
+			NodeID to;        ///< End node of the edge.
+			uint capacity;    ///< Capacity of the edge when the source was solved.
+			uint flow;        ///< Flow from the source assigned to the edge.
+		};
+
+		std::vector<Demand> demands; ///< Demands, sorted by destination.
+		std::vector<Leg> legs;       ///< Legs, sorted by edge.
+	};
+
+	/**
+	 * Results of the first MCF pass of the last job, used to warm-start the next job.
+	 * This is saved with the link graph, as the results of jobs depend on it.
+	 */
+	struct MCFResultCache {
+		std::vector<std::pair<NodeID, NodeID>> edges; ///< Edges the results were calculated on, sorted.
+		std::vector<MCFSourceResult> sources;         ///< Results, indexed by source node.
+	};
+
 	/**
 	 * Wrapper for an edge (const or not) allowing retrieval, but no modification.
 	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
@@ -369,6 +402,7 @@ public:
 	}
 
 	NodeID AddNode(const Station *st);
+	NodeID AddNode(TileIndex xy, StationID st, bool accepts);
 	void RemoveNode(NodeID id);
 
 	void UpdateEdge(NodeID from, NodeID to, uint capacity, uint usage, uint32_t time, EdgeUpdateMode mode);
@@ -398,10 +432,23 @@ protected:
 	ScaledTickCounter last_compression; ///< Last time the capacities and supplies were compressed.
 	NodeVector nodes;      ///< Nodes in the component.
 	EdgeMatrix edges;      ///< Edges in the component.
+	std::shared_ptr<const MCFResultCache> mcf_cache; ///< Results of the last job, shared with running jobs, or nullptr.
 
 public:
 	const EdgeMatrix &GetEdges() const { return this->edges; }
 
+	/**
+	 * Get the MCF results of the last job.
+	 * @return Results, or nullptr if they aren't available or not valid any more.
+	 */
+	const MCFResultCache *GetMCFResultCache() const { return this->mcf_cache.get(); }
+
+	/**
+	 * Set the MCF results to warm-start the next job with.
+	 * @param cache Results, or nullptr to clear.
+	 */
+	void SetMCFResultCache(std::shared_ptr<const MCFResultCache> cache) { this->mcf_cache = std::move(cache); }
+
 	const BaseEdge &GetBaseEdge(NodeID from, NodeID to) const
 	{
 		auto iter = this->edges.find(std::make_pair(from, to));
@@ -10,6 +10,7 @@
 #include "../stdafx.h"
 #include "../core/pool_func.hpp"
 #include "../window_func.h"
+#include "../debug_settings.h"
 #include "linkgraphjob.h"
 #include "linkgraphschedule.h"
 
@@ -39,10 +40,21 @@ static ScaledTickCounter GetLinkGraphJobJoinTick(uint duration_multiplier)
  * @param orig Original LinkGraph to be copied.
  */
 LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier) :
+		LinkGraphJob(orig, duration_multiplier, _settings_game.linkgraph)
+{
+}
+
+/**
+ * Create a link graph job from a link graph with the given settings instead of the game settings.
+ * Diagnostics which run the job directly use this to pass their own settings.
+ * @param orig Original LinkGraph to be copied.
+ * @param settings Settings to use.
+ */
+LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier, const LinkGraphSettings &settings) :
 		/* Copying the link graph here also copies its index member.
 		 * This is on purpose. */
 		link_graph(orig),
-		settings(_settings_game.linkgraph),
+		settings(settings),
 		join_tick(GetLinkGraphJobJoinTick(duration_multiplier)),
 		start_tick(_scaled_tick_counter),
 		job_completed(false),
@@ -101,6 +113,15 @@ void LinkGraphJob::FinaliseJob()
 	if (!LinkGraph::IsValidID(this->link_graph.index)) return;
 
 	uint16_t size = this->Size();
+
+	/* Keep the MCF results for the next job, if the node IDs they refer to are still the same. */
+	LinkGraph *orig = LinkGraph::Get(this->link_graph.index);
+	bool results_valid = this->mcf_result != nullptr && orig->Size() >= size && !HasChickenBit(DCBF_LINKGRAPH_NO_WARM_START);
+	for (NodeID node_id = 0; results_valid && node_id < size; ++node_id) {
+		if ((*orig)[node_id].Station() != (*this)[node_id].Station()) results_valid = false;
+	}
+	orig->SetMCFResultCache(results_valid ? std::move(this->mcf_result) : nullptr);
+	this->mcf_result.reset();
 	for (NodeID node_id = 0; node_id < size; ++node_id) {
 		Node from = (*this)[node_id];
 
@@ -123,7 +144,7 @@ void LinkGraphJob::FinaliseJob()
 		FlowStatMap &flows = from.Flows();
 		FlowStatMap &geflows = ge.CreateData().flows;
 
-		for (Edge &edge : from.GetEdges()) {
+		for (Edge edge : from.GetEdges()) {
 			if (edge.Flow() == 0) continue;
 			StationID to = (*this)[edge.To()].Station();
 			Station *st2 = Station::GetIfValid(to);
@@ -211,23 +232,19 @@ void LinkGraphJob::Init()
 		edge_count++;
 	}
 
-	this->edges.resize(edge_count);
-	size_t start_idx = 0;
-	size_t idx = 0;
-	NodeID last_from = INVALID_NODE;
-	auto flush = [&]() {
-		if (last_from == INVALID_NODE) return;
-		this->nodes[last_from].edges = { this->edges.data() + start_idx, idx - start_idx };
-	};
+	/* The edge matrix is sorted by (from, to), so the edges can be copied in order. */
+	EdgeArrays &edges = this->edges;
+	edges.offsets.assign(size + 1, 0);
+	edges.from.resize(edge_count + 1);
+	edges.to.resize(edge_count + 1);
+	edges.capacity.resize(edge_count + 1);
+	edges.distance_anno.resize(edge_count + 1);
+	edges.flow.assign(edge_count + 1, 0);
+
+	uint idx = 0;
 	for (auto &it : this->link_graph.GetEdges()) {
 		if (it.first.first == it.first.second) continue;
 
-		if (it.first.first != last_from) {
-			flush();
-			last_from = it.first.first;
-			start_idx = idx;
-		}
-
 		LinkGraph::ConstEdge edge(it.second);
 
 		auto calculate_distance = [&]() {
@@ -247,10 +264,22 @@ void LinkGraphJob::Init()
 			distance_anno /= 100;
 		}
 
-		this->edges[idx].InitEdge(it.first.first, it.first.second, edge.Capacity(), distance_anno);
+		edges.offsets[it.first.first + 1]++;
+		edges.from[idx] = it.first.first;
+		edges.to[idx] = it.first.second;
+		edges.capacity[idx] = edge.Capacity();
+		edges.distance_anno[idx] = distance_anno;
 		idx++;
 	}
-	flush();
+	for (uint i = 0; i < size; ++i) {
+		edges.offsets[i + 1] += edges.offsets[i];
+	}
+
+	/* Empty edge */
+	edges.from[idx] = INVALID_NODE;
+	edges.to[idx] = INVALID_NODE;
+	edges.capacity[idx] = 0;
+	edges.distance_anno[idx] = 0;
 }
 
 /**
@@ -297,7 +326,7 @@ void Path::Fork(Path *base, uint cap, int free_cap, uint dist)
 uint Path::AddFlow(uint new_flow, LinkGraphJob &job, uint max_saturation)
 {
 	if (this->GetParent() != nullptr) {
-		LinkGraphJob::Edge &edge = job[this->GetParent()->node].GetEdgeTo(this->node);
+		LinkGraphJob::Edge edge = job[this->GetParent()->node].GetEdgeTo(this->node);
 		if (max_saturation != UINT_MAX) {
 			uint usable_cap = edge.Capacity() * max_saturation / 100;
 			if (usable_cap > edge.Flow()) {
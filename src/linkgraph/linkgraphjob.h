@@ -13,6 +13,8 @@
 #include "../thread.h"
 #include "../core/dyn_arena_alloc.hpp"
 #include "linkgraph.h"
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -42,53 +44,83 @@ public:
 	};
 
 	/**
-	 * Annotation for a link graph flow edge.
+	 * Edges of the job in compressed sparse row layout. The outgoing edges of node n have the
+	 * IDs [offsets[n], offsets[n + 1]), sorted by target node. Each field is stored in its own
+	 * array indexed by edge ID, so that passes over the graph only load the fields they use.
+	 * One more entry is kept at the end of each array, which stands for a missing edge.
 	 */
-	struct Edge {
-	private:
-		NodeID from;             ///< From Node.
-		NodeID to;               ///< To Node.
-		uint capacity;           ///< Capacity of the link.
-		uint distance_anno;      ///< Pre-computed distance annotation.
+	struct EdgeArrays {
+		std::vector<uint> offsets;       ///< First edge ID of each node, followed by the number of edges.
+		std::vector<NodeID> from;        ///< From node of each edge.
+		std::vector<NodeID> to;          ///< To node of each edge.
+		std::vector<uint> capacity;      ///< Capacity of each edge.
+		std::vector<uint> distance_anno; ///< Pre-computed distance annotation of each edge.
+		std::vector<uint> flow;          ///< Planned flow over each edge.
+
+		/**
+		 * Get the ID of the entry standing for a missing edge.
+		 * @return Empty edge ID.
+		 */
+		uint EmptyEdge() const { return this->offsets.back(); }
+	};
 
-		uint flow;               ///< Planned flow over this edge.
+	/**
+	 * Annotation for a link graph flow edge. Refers to one edge in the job's #EdgeArrays.
+	 */
+	class Edge {
+	private:
+		EdgeArrays *arrays;      ///< Edge arrays of the job.
+		uint id;                 ///< ID of the edge in the arrays.
 
 	public:
+		/**
+		 * Constructor.
+		 * @param arrays Edge arrays of the job.
+		 * @param id ID of the edge.
+		 */
+		Edge(EdgeArrays &arrays, uint id) : arrays(&arrays), id(id) {}
+
+		/**
+		 * Get edge's ID.
+		 * @return ID in the edge arrays of the job.
+		 */
+		uint GetID() const { return this->id; }
+
 		/**
 		 * Get edge's from node.
 		 * @return from NodeID.
 		 */
-		NodeID From() const { return this->from; }
+		NodeID From() const { return this->arrays->from[this->id]; }
 
 		/**
 		 * Get edge's to node.
 		 * @return to NodeID.
 		 */
-		NodeID To() const { return this->to; }
+		NodeID To() const { return this->arrays->to[this->id]; }
 
 		/**
 		 * Get edge's capacity.
 		 * @return Capacity.
 		 */
-		uint Capacity() const { return this->capacity; }
+		uint Capacity() const { return this->arrays->capacity[this->id]; }
 
 		/**
 		 * Get edge's distance annotation.
 		 * @return Distance annotation.
 		 */
-		uint DistanceAnno() const { return this->distance_anno; }
+		uint DistanceAnno() const { return this->arrays->distance_anno[this->id]; }
 
 		/**
 		 * Get the total flow on the edge.
 		 * @return Flow.
 		 */
-		uint Flow() const { return this->flow; }
+		uint Flow() const { return this->arrays->flow[this->id]; }
 
 		/**
 		 * Add some flow.
 		 * @param flow Flow to be added.
 		 */
-		void AddFlow(uint flow) { this->flow += flow; }
+		void AddFlow(uint flow) { this->arrays->flow[this->id] += flow; }
 
 		/**
 		 * Remove some flow.
@@ -96,21 +128,47 @@ public:
 		 */
 		void RemoveFlow(uint flow)
 		{
-			dbg_assert(flow <= this->flow);
-			this->flow -= flow;
-		}
-
-		void InitEdge(NodeID from, NodeID to, uint capacity, uint distance_anno)
-		{
-			this->from = from;
-			this->to = to;
-			this->capacity = capacity;
-			this->distance_anno = distance_anno;
-			this->flow = 0;
+			dbg_assert(flow <= this->arrays->flow[this->id]);
+			this->arrays->flow[this->id] -= flow;
 		}
 	};
 
-	typedef std::vector<Edge> EdgeAnnotationVector;
+	/**
+	 * Range of the outgoing edges of a node.
+	 */
+	class EdgeRange {
+	private:
+		EdgeArrays *arrays;      ///< Edge arrays of the job.
+		uint first;              ///< ID of the first edge.
+		uint last;               ///< ID after the last edge.
+
+	public:
+		struct Iterator {
+			EdgeArrays *arrays;
+			uint id;
+
+			Edge operator*() const { return Edge(*this->arrays, this->id); }
+			Iterator &operator++() { this->id++; return *this; }
+			bool operator==(const Iterator &other) const { return this->id == other.id; }
+		};
+
+		EdgeRange(EdgeArrays &arrays, uint first, uint last) : arrays(&arrays), first(first), last(last) {}
+
+		Iterator begin() const { return { this->arrays, this->first }; }
+		Iterator end() const { return { this->arrays, this->last }; }
+
+		/**
+		 * Get the ID of the first edge.
+		 * @return First edge ID.
+		 */
+		uint FirstID() const { return this->first; }
+
+		/**
+		 * Get the ID after the last edge.
+		 * @return End edge ID.
+		 */
+		uint EndID() const { return this->last; }
+	};
 
 private:
 	/**
@@ -122,7 +180,6 @@ private:
 		PathList paths;          ///< Paths through this node, sorted so that those with flow == 0 are in the back.
 		FlowStatMap flows;       ///< Planned flows to other nodes.
 		std::span<DemandAnnotation> demands; ///< Demand annotations belonging to this node.
-		std::span<Edge> edges;               ///< Edges with annotations belonging to this node.
 		void Init(uint supply);
 	};
 
@@ -143,7 +200,7 @@ protected:
 	ScaledTickCounter join_tick;      ///< Tick when the job is to be joined.
 	ScaledTickCounter start_tick;     ///< Tick when the job was started.
 	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
-	EdgeAnnotationVector edges;       ///< Edge data necessary for link graph calculation.
+	EdgeArrays edges;                 ///< Edge data necessary for link graph calculation.
 	std::atomic<bool> job_completed;  ///< Is the job still running. This is accessed by multiple threads and reads may be stale.
 	std::atomic<bool> job_aborted;    ///< Has the job been aborted. This is accessed by multiple threads and reads may be stale.
 
@@ -156,8 +213,24 @@ public:
 	std::unique_ptr<uint[]> demand_matrix;                        ///< Demand matrix.
 	uint demand_matrix_count;                                     ///< Count of non-zero entries in demand_matrix.
 	std::vector<DemandAnnotation> demand_annotation_store;        ///< Demand annotation store.
+	std::shared_ptr<LinkGraph::MCFResultCache> mcf_result;       ///< Results of the first MCF pass, to warm-start the next job with.
+
+	/** Maximum number of path searches which are run concurrently by the MCF passes. */
+	static constexpr uint PATH_SEARCH_BATCH_SIZE = 16;
 
-	DynUniformArenaAllocator path_allocator; ///< Arena allocator used for paths
+	uint path_search_batch_size = PATH_SEARCH_BATCH_SIZE; ///< Number of path searches which are run concurrently by the MCF passes, at most PATH_SEARCH_BATCH_SIZE. This does not change the results.
+
+	std::array<DynUniformArenaAllocator, PATH_SEARCH_BATCH_SIZE> path_allocators; ///< Arena allocators used for paths, one for each concurrent path search
+
+	/**
+	 * Free all paths.
+	 */
+	void ResetPathAllocators()
+	{
+		for (DynUniformArenaAllocator &allocator : this->path_allocators) {
+			allocator.ResetArena();
+		}
+	}
 
 	/**
 	 * Link graph job node. Wraps a constant link graph node and a modifiable
@@ -166,6 +239,7 @@ public:
 	class Node : public LinkGraph::ConstNode {
 	private:
 		NodeAnnotation &node_anno;  ///< Annotation being wrapped.
+		EdgeArrays &edges;          ///< Edge arrays of the job.
 	public:
 
 		/**
@@ -175,7 +249,7 @@ public:
 		 */
 		Node (LinkGraphJob *lgj, NodeID node) :
 			LinkGraph::ConstNode(&lgj->link_graph, node),
-			node_anno(lgj->nodes[node])
+			node_anno(lgj->nodes[node]), edges(lgj->edges)
 		{}
 
 		/**
@@ -243,19 +317,27 @@ public:
 			this->node_anno.demands = demands;
 		}
 
-		Edge &GetEdgeTo(NodeID to)
+		/**
+		 * Get the edge from this node to another one.
+		 * @param to Target node.
+		 * @return The edge, or the empty edge if there is none.
+		 */
+		Edge GetEdgeTo(NodeID to)
 		{
-			for (Edge &edge : this->node_anno.edges) {
-				if (edge.To() == to) return edge;
-			}
-
-			static Edge empty_edge = {};
-			return empty_edge;
+			const NodeID *targets = this->edges.to.data();
+			const NodeID *first = targets + this->edges.offsets[this->index];
+			const NodeID *last = targets + this->edges.offsets[this->index + 1];
+			const NodeID *it = std::lower_bound(first, last, to);
+			return Edge(this->edges, (it != last && *it == to) ? (uint)(it - targets) : this->edges.EmptyEdge());
 		}
 
-		std::span<Edge> GetEdges()
+		/**
+		 * Get the outgoing edges of this node.
+		 * @return Edge range, sorted by target node.
+		 */
+		EdgeRange GetEdges()
 		{
-			return this->node_anno.edges;
+			return EdgeRange(this->edges, this->edges.offsets[this->index], this->edges.offsets[this->index + 1]);
 		}
 	};
 
@@ -267,6 +349,7 @@ public:
 			join_tick(0), start_tick(0), job_completed(false), job_aborted(false) {}
 
 	LinkGraphJob(const LinkGraph &orig, uint duration_multiplier);
+	LinkGraphJob(const LinkGraph &orig, uint duration_multiplier, const LinkGraphSettings &settings);
 	~LinkGraphJob();
 
 	void Init();
@@ -338,6 +421,12 @@ public:
 	 */
 	inline NodeID Size() const { return this->link_graph.Size(); }
 
+	/**
+	 * Get the number of edges of the job, see #EdgeArrays.
+	 * @return Number of edges, which is also the ID of the entry standing for a missing edge.
+	 */
+	inline uint EdgeCount() const { return this->edges.EmptyEdge(); }
+
 	/**
 	 * Get the cargo of the underlying link graph.
 	 * @return Cargo.
@@ -438,6 +527,19 @@ public:
 	uint AddFlow(uint f, LinkGraphJob &job, uint max_saturation);
 	void Fork(Path *base, uint cap, int free_cap, uint dist);
 
+	/**
+	 * Make this leg a child of the given base path, without changing capacity or distance.
+	 * This is used for legs restored from an earlier calculation, for which no complete path exists.
+	 * @param base Path to attach to.
+	 */
+	inline void AttachTo(Path *base)
+	{
+		this->Detach();
+		this->SetParent(base);
+		base->num_children++;
+		this->origin = base->origin;
+	}
+
 	inline bool GetAnnosSetFlag() const { return HasBit(this->parent_storage, 0); }
 	inline void SetAnnosSetFlag(bool flag) { SB(this->parent_storage, 0, 1, flag ? 1 : 0); }
 
@@ -473,4 +575,30 @@ inline bool IsLinkGraphCargoExpress(CargoID cargo)
 			IsCargoInClass(cargo, CC_EXPRESS);
 }
 
+/** Timings of a link graph path search benchmark. */
+struct LinkGraphBenchmarkResult {
+	uint nodes;          ///< Number of nodes in the synthetic graph.
+	uint edges;          ///< Number of edges in the synthetic graph.
+	uint searches;       ///< Number of path searches.
+	uint64_t init_us;    ///< Time to set up the job's edge arrays, in microseconds.
+	uint64_t search_us;  ///< Time for all path searches, in microseconds.
+	uint64_t batch_search_us; ///< Time for all path searches in concurrent batches, in microseconds.
+};
+
+LinkGraphBenchmarkResult BenchmarkLinkGraphPathSearch(uint nodes, uint links, uint searches);
+
+/** Comparison of complete link graph jobs with serial and batched MCF path searches, see LinkGraphJob::path_search_batch_size. */
+struct LinkGraphMCFComparison {
+	uint nodes;               ///< Number of nodes in the synthetic graph.
+	uint edges;               ///< Number of edges in the synthetic graph.
+	uint differing_edges;     ///< Number of edges whose flow differs.
+	uint64_t serial_flow;     ///< Total flow of all edges with serial path searches.
+	uint64_t batched_flow;    ///< Total flow of all edges with batched path searches.
+	uint64_t flow_difference; ///< Sum of the absolute flow differences of all edges.
+	uint64_t serial_us;       ///< Time for the job with serial path searches, in microseconds.
+	uint64_t batched_us;      ///< Time for the job with batched path searches, in microseconds.
+};
+
+LinkGraphMCFComparison CompareLinkGraphMCFBatching(uint nodes, uint links, const LinkGraphSettings &base_settings);
+
 #endif /* LINKGRAPHJOB_H */
@@ -2,8 +2,15 @@
 
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
+#include "../debug.h"
+#include "../core/random_func.hpp"
+#include "../map_func.h"
 #include "mcf.h"
+#include "linkgraphschedule.h"
+#include "../worker_thread.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
+#include <algorithm>
+#include <chrono>
 #include <set>
 
 #include "../safeguards.h"
@@ -49,6 +56,16 @@ public:
 	 */
 	inline uint GetAnnotation() const { return this->distance; }
 
+	/**
+	 * Check whether a change of the free capacity of an edge can change the result of a search.
+	 * Only whether free capacity is left is compared while searching, and afterwards the free capacity
+	 * of the paths is only compared with 0 and INT_MIN, so only changes between saturated and unsaturated matter.
+	 * @param old_free_cap Free capacity of the edge before the change.
+	 * @param new_free_cap Free capacity of the edge after the change.
+	 * @return True if a search which has read the edge would give a different result.
+	 */
+	static inline bool IsSearchAffected(int old_free_cap, int new_free_cap) { return (old_free_cap > 0) != (new_free_cap > 0); }
+
 	/**
 	 * Update the cached annotation value
 	 */
@@ -89,6 +106,14 @@ public:
 	 */
 	inline int GetAnnotation() const { return this->cached_annotation; }
 
+	/**
+	 * Check whether a change of the free capacity of an edge can change the result of a search.
+	 * @param old_free_cap Free capacity of the edge before the change.
+	 * @param new_free_cap Free capacity of the edge after the change.
+	 * @return True if a search which has read the edge would give a different result.
+	 */
+	static inline bool IsSearchAffected(int old_free_cap, int new_free_cap) { return old_free_cap != new_free_cap; }
+
 	/**
 	 * Update the cached annotation value
 	 */
@@ -106,16 +131,17 @@ public:
 };
 
 /**
- * Iterator class for getting the edges in the order of their next_edge
- * members.
+ * Iterator class for getting the outgoing edges of a node in the order of
+ * their target nodes.
  */
 class GraphEdgeIterator {
 private:
+	typedef LinkGraphJob::EdgeRange::Iterator EdgeIterator;
+
 	LinkGraphJob &job;    ///< Job being executed
-	const Edge *i;        ///< Iterator pointing to current edge.
-	const Edge *end;      ///< Iterator pointing beyond last edge.
-	NodeID node;          ///< Source node
-	const Edge *saved;    ///< Saved edge
+	EdgeIterator i;       ///< Iterator pointing to current edge.
+	EdgeIterator end;     ///< Iterator pointing beyond last edge.
+	EdgeIterator saved;   ///< Saved edge
 
 public:
 
@@ -123,8 +149,7 @@ public:
 	 * Construct a GraphEdgeIterator.
 	 * @param job Job to iterate on.
 	 */
-	GraphEdgeIterator(LinkGraphJob &job) : job(job),
-		i(nullptr), end(nullptr), node(INVALID_NODE), saved(nullptr)
+	GraphEdgeIterator(LinkGraphJob &job) : job(job), i(), end(), saved()
 	{}
 
 	/**
@@ -133,11 +158,9 @@ public:
 	 */
 	void SetNode(NodeID, NodeID node)
 	{
-		Node node_anno = this->job[node];
-		std::span<Edge> edges = node_anno.GetEdges();
-		this->i = edges.data();
-		this->end = edges.data() + edges.size();
-		this->node = node;
+		LinkGraphJob::EdgeRange edges = this->job[node].GetEdges();
+		this->i = edges.begin();
+		this->end = edges.end();
 	}
 
 	/**
@@ -147,15 +170,14 @@ public:
 	NodeID Next()
 	{
 		if (this->i == this->end) return INVALID_NODE;
-		NodeID to = this->i->To();
 		this->saved = this->i;
 		++this->i;
-		return to;
+		return (*this->saved).To();
 	}
 
 	bool SavedEdge() const { return true; }
 
-	const Edge &GetSavedEdge() { return *(this->saved); }
+	Edge GetSavedEdge() { return *(this->saved); }
 };
 
 /**
@@ -220,7 +242,7 @@ public:
 
 	bool SavedEdge() const { return false; }
 
-	const Edge &GetSavedEdge() { NOT_REACHED(); }
+	Edge GetSavedEdge() { NOT_REACHED(); }
 };
 
 /**
@@ -284,13 +306,15 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
  * A slightly modified Dijkstra algorithm. Grades the paths not necessarily by
  * distance, but by the value Tannotation computes. It uses the max_saturation
  * setting to artificially decrease capacities.
+ * This only reads the job's data, so that multiple searches can run concurrently.
  * @tparam Tannotation Annotation to be used.
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
  * @param source_node Node where the algorithm starts.
  * @param paths Container for the paths to be calculated.
+ * @param allocator Allocator for the paths, not used by any concurrent search.
  */
 template<class Tannotation, class Tedge_iterator>
-void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
+void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths, DynUniformArenaAllocator &allocator)
 {
 	typedef btree::btree_set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator> AnnoSet;
 	AnnoSet annos = AnnoSet(typename Tannotation::Comparator());
@@ -298,10 +322,10 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	uint size = this->job.Size();
 	paths.resize(size, nullptr);
 
-	this->job.path_allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
+	allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
 
 	for (NodeID node = 0; node < size; ++node) {
-		Tannotation *anno = new (this->job.path_allocator.Allocate()) Tannotation(node, node == source_node);
+		Tannotation *anno = new (allocator.Allocate()) Tannotation(node, node == source_node);
 		anno->UpdateAnnotation();
 		if (node == source_node) {
 			annos.insert(AnnoSetItem<Tannotation>(anno));
@@ -317,13 +341,8 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
 			if (to == from) continue; // Not a real edge but a consumption sign.
-			const Edge &edge = iter.SavedEdge() ? iter.GetSavedEdge() : this->job[from].GetEdgeTo(to);
-			uint capacity = edge.Capacity();
-			if (this->max_saturation != UINT_MAX) {
-				capacity *= this->max_saturation;
-				capacity /= 100;
-				if (capacity == 0) capacity = 1;
-			}
+			Edge edge = iter.SavedEdge() ? iter.GetSavedEdge() : this->job[from].GetEdgeTo(to);
+			uint capacity = this->GetSearchCapacity(edge);
 
 			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), edge.DistanceAnno())) {
@@ -337,12 +356,137 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	}
 }
 
+/**
+ * Get the capacity of an edge as seen by the path searches, reduced to max_saturation.
+ * @param edge Edge.
+ * @return Capacity.
+ */
+uint MultiCommodityFlow::GetSearchCapacity(const Edge &edge) const
+{
+	uint capacity = edge.Capacity();
+	if (this->max_saturation != UINT_MAX) {
+		capacity *= this->max_saturation;
+		capacity /= 100;
+		if (capacity == 0) capacity = 1;
+	}
+	return capacity;
+}
+
+/**
+ * Run the path searches for a batch of sources concurrently on the worker threads.
+ * All searches see the flow as it was before the batch. The caller assigns the flow of the sources in order,
+ * and has to check with IsSearchStale whether the flow assigned for the sources before each source changed its result.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param sources Sources to search from, at most LinkGraphJob::PATH_SEARCH_BATCH_SIZE.
+ * @param paths Containers for the paths of each source. The paths of sources[i] are allocated from path_allocators[i] of the job.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::SearchPaths(const std::vector<NodeID> &sources, std::vector<PathVector> &paths)
+{
+	assert(sources.size() <= LinkGraphJob::PATH_SEARCH_BATCH_SIZE);
+	paths.resize(LinkGraphJob::PATH_SEARCH_BATCH_SIZE);
+
+	if (sources.size() == 1) {
+		this->Dijkstra<Tannotation, Tedge_iterator>(sources[0], paths[0], this->job.path_allocators[0]);
+		return;
+	}
+
+	WorkerTaskGroup group(WTC_LINKGRAPH);
+	group.ParallelFor(0, sources.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			this->Dijkstra<Tannotation, Tedge_iterator>(sources[i], paths[i], this->job.path_allocators[i]);
+		}
+	});
+}
+
+/**
+ * Check whether the flow assigned since the searches of the current batch changes the result of the search of a source,
+ * so that the source has to be searched again to get the same result as a serial search.
+ * A search reads the outgoing edges of every node it reaches, all other edges do not affect its result.
+ * @tparam Tedge_iterator Iterator which was used for the search.
+ * @param source Source of the search.
+ * @param paths Paths found by the search.
+ * @return True if the search has read an edge marked by MarkChangedEdges.
+ */
+template<class Tedge_iterator>
+bool MultiCommodityFlow::IsSearchStale(NodeID source, const PathVector &paths)
+{
+	if (this->changed_edge_list.empty()) return false;
+
+	Tedge_iterator iter(this->job);
+	const NodeID size = this->job.Size();
+	for (NodeID from = 0; from < size; ++from) {
+		if (from != source && paths[from]->GetParent() == nullptr) continue; // not reached
+		iter.SetNode(source, from);
+		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
+			if (to == from) continue;
+			Edge edge = iter.SavedEdge() ? iter.GetSavedEdge() : this->job[from].GetEdgeTo(to);
+			if (this->changed_edges[edge.GetID()]) return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Mark the edges of a path whose change of flow can change the result of the searches of the current batch.
+ * @tparam Tannotation Annotation used for the searches.
+ * @param path End of the path the flow has been pushed on.
+ * @param flow Flow which has been added to every edge of the path.
+ */
+template<class Tannotation>
+void MultiCommodityFlow::MarkChangedEdges(Path *path, uint flow)
+{
+	if (flow == 0) return;
+	if (this->changed_edges.empty()) this->changed_edges.resize(this->job.EdgeCount() + 1);
+
+	for (Path *leg = path; leg->GetParent() != nullptr; leg = leg->GetParent()) {
+		Edge edge = this->job[leg->GetParent()->GetNode()].GetEdgeTo(leg->GetNode());
+		if (this->changed_edges[edge.GetID()]) continue;
+		const uint capacity = this->GetSearchCapacity(edge);
+		const int old_free_cap = capacity - (edge.Flow() - flow);
+		const int new_free_cap = capacity - edge.Flow();
+		if (Tannotation::IsSearchAffected(old_free_cap, new_free_cap)) {
+			this->changed_edges[edge.GetID()] = true;
+			this->changed_edge_list.push_back(edge.GetID());
+		}
+	}
+}
+
+/**
+ * Clear the changed edges, before assigning the flow of a new batch.
+ */
+void MultiCommodityFlow::ClearChangedEdges()
+{
+	for (uint id : this->changed_edge_list) {
+		this->changed_edges[id] = false;
+	}
+	this->changed_edge_list.clear();
+}
+
+/**
+ * Get the next batch of sources which haven't been finished yet.
+ * @param finished_sources Which sources have been finished.
+ * @param batch_size Maximum number of sources in the batch.
+ * @param next First source to consider, updated to the one after the batch.
+ * @param batch Output for the sources of the batch.
+ */
+static void GetNextSourceBatch(const std::vector<bool> &finished_sources, uint batch_size, NodeID &next, std::vector<NodeID> &batch)
+{
+	batch.clear();
+	const NodeID size = (NodeID)finished_sources.size();
+	for (; next < size && batch.size() < batch_size; ++next) {
+		if (!finished_sources[next]) batch.push_back(next);
+	}
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
  * @param paths Paths to be cleaned up.
+ * @param allocator Allocator the paths have been allocated from.
  */
-void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
+void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths, DynUniformArenaAllocator &allocator)
 {
 	Path *source = paths[source_id];
 	paths[source_id] = nullptr;
@@ -355,12 +499,12 @@ void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
 			path->Detach();
 			if (path->GetNumChildren() == 0) {
 				paths[path->GetNode()] = nullptr;
-				this->job.path_allocator.Free(path);
+				allocator.Free(path);
 			}
 			path = parent;
 		}
 	}
-	this->job.path_allocator.Free(source);
+	allocator.Free(source);
 	paths.clear();
 }
 
@@ -423,7 +567,7 @@ void MCF1stPass::EliminateCycle(PathVector &path, Path *cycle_begin, uint flow)
 			}
 		}
 		cycle_begin = path[prev];
-		Edge &edge = this->job[prev].GetEdgeTo(cycle_begin->GetNode());
+		Edge edge = this->job[prev].GetEdgeTo(cycle_begin->GetNode());
 		edge.RemoveFlow(flow);
 	} while (cycle_begin != cycle_end);
 }
@@ -529,6 +673,150 @@ bool MCF1stPass::EliminateCycles()
 	return cycles_found;
 }
 
+/**
+ * Maximum change of a demand or a link capacity, in percent of the value when
+ * the source was last solved, for which the previous flows of a source are reused.
+ */
+static const uint MCF_WARM_START_MAX_CHANGE = 10;
+
+/**
+ * Check if a value has changed little enough since a source was last solved to reuse its flows.
+ * @param solved Value when the source was solved.
+ * @param current Current value.
+ * @return True if the change is within #MCF_WARM_START_MAX_CHANGE.
+ */
+static bool IsWarmStartChangeSmall(uint solved, uint current)
+{
+	uint64_t diff = Delta(solved, current);
+	return diff * 100 <= static_cast<uint64_t>(std::max(solved, current)) * MCF_WARM_START_MAX_CHANGE;
+}
+
+/**
+ * Restore the flows of sources which are unchanged since the previous job, and
+ * mark them as reused so that they aren't solved again.
+ * @param reused_sources Output: which sources have been restored.
+ * @return Number of legs restored.
+ */
+uint MCF1stPass::RestoreCachedSources(std::vector<bool> &reused_sources)
+{
+	const LinkGraph::MCFResultCache *cache = this->job.Graph().GetMCFResultCache();
+	if (cache == nullptr) return 0;
+
+	/* New links may give better paths for any source, so solve everything again. */
+	auto cached_edge = cache->edges.begin();
+	for (const auto &it : this->job.Graph().GetEdges()) {
+		if (it.first.first == it.first.second) continue;
+		while (cached_edge != cache->edges.end() && *cached_edge < it.first) ++cached_edge;
+		if (cached_edge == cache->edges.end() || *cached_edge != it.first) return 0;
+	}
+
+	this->job.path_allocators[0].SetParameters(sizeof(DistanceAnnotation), (8192 - 32) / sizeof(DistanceAnnotation));
+
+	uint restored_legs = 0;
+	const NodeID size = std::min<NodeID>(this->job.Size(), static_cast<NodeID>(cache->sources.size()));
+	for (NodeID source = 0; source < size; ++source) {
+		const LinkGraph::MCFSourceResult &result = cache->sources[source];
+		if (result.demands.empty()) continue;
+
+		std::span<DemandAnnotation> demands = this->job[source].GetDemandAnnotations();
+		if (demands.size() != result.demands.size()) continue;
+		bool unchanged = true;
+		for (size_t i = 0; unchanged && i < demands.size(); i++) {
+			unchanged = (demands[i].dest == result.demands[i].dest) && IsWarmStartChangeSmall(result.demands[i].demand, demands[i].demand);
+		}
+		for (auto leg = result.legs.begin(); unchanged && leg != result.legs.end(); ++leg) {
+			if (leg->from >= this->job.Size() || leg->to >= this->job.Size()) {
+				unchanged = false;
+			} else {
+				uint capacity = this->job[leg->from].GetEdgeTo(leg->to).Capacity();
+				unchanged = (capacity > 0) && IsWarmStartChangeSmall(leg->capacity, capacity);
+			}
+		}
+		if (!unchanged) continue;
+
+		/* Legs are sorted by their start node, attach all legs starting at the same node to one common parent. */
+		Path *root = new (this->job.path_allocators[0].Allocate()) DistanceAnnotation(source, true);
+		Path *parent = root;
+		for (const LinkGraph::MCFSourceResult::Leg &leg : result.legs) {
+			if (parent->GetNode() != leg.from) {
+				parent = new (this->job.path_allocators[0].Allocate()) DistanceAnnotation(leg.from);
+				parent->AttachTo(root);
+			}
+			Path *path = new (this->job.path_allocators[0].Allocate()) DistanceAnnotation(leg.to);
+			path->AttachTo(parent);
+			path->AddFlow(leg.flow);
+			Node from = this->job[leg.from];
+			from.Paths().push_back(path);
+			from.GetEdgeTo(leg.to).AddFlow(leg.flow);
+		}
+		restored_legs += (uint)result.legs.size();
+
+		for (size_t i = 0; i < demands.size(); i++) {
+			demands[i].unsatisfied_demand = demands[i].demand - std::min(demands[i].demand, result.demands[i].satisfied);
+		}
+		reused_sources[source] = true;
+	}
+	return restored_legs;
+}
+
+/**
+ * Store the flows assigned in this pass, so that the next job can be warm-started from them.
+ * Restored sources keep the results from when they were actually solved, so that changes can't accumulate unnoticed.
+ * @param reused_sources Which sources have been restored from the previous job.
+ */
+void MCF1stPass::StoreResults(const std::vector<bool> &reused_sources)
+{
+	const LinkGraph::MCFResultCache *cache = this->job.Graph().GetMCFResultCache();
+	std::shared_ptr<LinkGraph::MCFResultCache> results = std::make_shared<LinkGraph::MCFResultCache>();
+	const NodeID size = this->job.Size();
+
+	for (const auto &it : this->job.Graph().GetEdges()) {
+		if (it.first.first != it.first.second) results->edges.push_back(it.first);
+	}
+
+	results->sources.resize(size);
+	for (NodeID source = 0; source < size; ++source) {
+		if (reused_sources[source]) {
+			results->sources[source] = cache->sources[source];
+			continue;
+		}
+		for (const DemandAnnotation &anno : this->job[source].GetDemandAnnotations()) {
+			results->sources[source].demands.push_back({ anno.dest, anno.demand, anno.demand - anno.unsatisfied_demand });
+		}
+	}
+
+	for (NodeID from = 0; from < size; ++from) {
+		Node node = this->job[from];
+		for (const Path *path : node.Paths()) {
+			if (path == nullptr || path->GetFlow() == 0) continue;
+			NodeID origin = path->GetOrigin();
+			if (reused_sources[origin]) continue;
+			NodeID to = path->GetNode();
+			results->sources[origin].legs.push_back({ from, to, node.GetEdgeTo(to).Capacity(), path->GetFlow() });
+		}
+	}
+
+	for (LinkGraph::MCFSourceResult &result : results->sources) {
+		if (result.legs.empty()) continue;
+
+		/* Sort by edge and merge legs of parallel paths. */
+		std::sort(result.legs.begin(), result.legs.end(), [](const LinkGraph::MCFSourceResult::Leg &a, const LinkGraph::MCFSourceResult::Leg &b) {
+			return std::make_pair(a.from, a.to) < std::make_pair(b.from, b.to);
+		});
+		auto last = result.legs.begin();
+		for (auto it = std::next(last); it != result.legs.end(); ++it) {
+			if (it->from == last->from && it->to == last->to) {
+				last->flow += it->flow;
+			} else {
+				*(++last) = *it;
+			}
+		}
+		result.legs.erase(std::next(last), result.legs.end());
+	}
+
+	this->job.mcf_result = std::move(results);
+}
+
 /**
  * Run the first pass of the MCF calculation.
  * @param job Link graph job to calculate.
@@ -560,39 +848,76 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 		accuracy = Clamp(IntSqrt((4 * accuracy * accuracy * size) / demand_count), CeilDiv(accuracy, 4), accuracy);
 	}
 
+	std::vector<bool> reused_sources(size);
+	uint restored_legs = this->RestoreCachedSources(reused_sources);
+	uint demand_sources = 0;
+	uint solved_sources = 0;
+	for (NodeID source = 0; source < size; ++source) {
+		if (job[source].GetDemandAnnotations().empty()) continue;
+		demand_sources++;
+		if (reused_sources[source]) {
+			finished_sources[source] = true;
+		} else {
+			solved_sources++;
+		}
+	}
+	DEBUG(linkgraph, 2, "MCF1stPass: link graph %u: solving %u of %u sources with demand (%u%%), %u legs restored",
+			job.LinkGraphIndex(), solved_sources, demand_sources, demand_sources > 0 ? (solved_sources * 100) / demand_sources : 0, restored_legs);
+
+	/* Sources are searched concurrently in batches, and flow is assigned serially in source order after each batch.
+	 * When the flow assigned for the sources before a source changes the result of its search, the next batch starts
+	 * at that source, so that each source gets the paths of a serial search after all sources before it. */
+	const uint batch_size = job.path_search_batch_size;
+	std::vector<NodeID> batch;
+	std::vector<PathVector> batch_paths;
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
+		NodeID next_source = 0;
+		for (GetNextSourceBatch(finished_sources, batch_size, next_source, batch); !batch.empty(); GetNextSourceBatch(finished_sources, batch_size, next_source, batch)) {
 			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
-			bool source_demand_left = false;
-			for (DemandAnnotation &anno : job[source].GetDemandAnnotations()) {
-				NodeID dest = anno.dest;
-				if (anno.unsatisfied_demand > 0) {
-					Path *path = paths[dest];
-					assert(path != nullptr);
-					/* Generally only allow paths that don't exceed the
-					 * available capacity. But if no demand has been assigned
-					 * yet, make an exception and allow any valid path *once*. */
-					if (path->GetFreeCapacity() > 0 && this->PushFlow(anno, path,
-							min_step_size, accuracy, this->max_saturation) > 0) {
-						/* If a path has been found there is a chance we can
-						 * find more. */
-						more_loops = more_loops || (anno.unsatisfied_demand > 0);
-					} else if (anno.unsatisfied_demand == anno.demand &&
-							path->GetFreeCapacity() > INT_MIN) {
-						this->PushFlow(anno, path, min_step_size, accuracy, UINT_MAX);
+			this->SearchPaths<DistanceAnnotation, GraphEdgeIterator>(batch, batch_paths);
+			this->ClearChangedEdges();
+
+			for (size_t i = 0; i < batch.size(); i++) {
+				const NodeID source = batch[i];
+				PathVector &paths = batch_paths[i];
+				if (this->IsSearchStale<GraphEdgeIterator>(source, paths)) {
+					for (size_t j = i; j < batch.size(); j++) {
+						this->CleanupPaths(batch[j], batch_paths[j], job.path_allocators[j]);
+					}
+					next_source = source;
+					break;
+				}
+				bool source_demand_left = false;
+				for (DemandAnnotation &anno : job[source].GetDemandAnnotations()) {
+					NodeID dest = anno.dest;
+					if (anno.unsatisfied_demand > 0) {
+						Path *path = paths[dest];
+						assert(path != nullptr);
+						/* Generally only allow paths that don't exceed the
+						 * available capacity. But if no demand has been assigned
+						 * yet, make an exception and allow any valid path *once*. */
+						uint flow = 0;
+						if (path->GetFreeCapacity() > 0) flow = this->PushFlow(anno, path, min_step_size, accuracy, this->max_saturation);
+						if (flow > 0) {
+							/* If a path has been found there is a chance we can
+							 * find more. */
+							more_loops = more_loops || (anno.unsatisfied_demand > 0);
+						} else if (anno.unsatisfied_demand == anno.demand &&
+								path->GetFreeCapacity() > INT_MIN) {
+							flow = this->PushFlow(anno, path, min_step_size, accuracy, UINT_MAX);
+						}
+						this->MarkChangedEdges<DistanceAnnotation>(path, flow);
+						if (anno.unsatisfied_demand > 0) source_demand_left = true;
 					}
-					if (anno.unsatisfied_demand > 0) source_demand_left = true;
 				}
+				if (!source_demand_left) finished_sources[source] = true;
+				this->CleanupPaths(source, paths, job.path_allocators[i]);
 			}
-			if (!source_demand_left) finished_sources[source] = true;
-			this->CleanupPaths(source, paths);
 		}
 	} while ((more_loops || this->EliminateCycles()) && !job.IsJobAborted());
+
+	if (!job.IsJobAborted()) this->StoreResults(reused_sources);
 }
 
 /**
@@ -603,36 +928,223 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
 	uint16_t size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
 	std::vector<bool> finished_sources(size);
+	const uint batch_size = job.path_search_batch_size;
+	std::vector<NodeID> batch;
+	std::vector<PathVector> batch_paths;
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-
-			bool source_demand_left = false;
-			for (DemandAnnotation &anno : this->job[source].GetDemandAnnotations()) {
-				if (anno.unsatisfied_demand == 0) continue;
-				Path *path = paths[anno.dest];
-				if (path->GetFreeCapacity() > INT_MIN) {
-					this->PushFlow(anno, path, 1, accuracy, UINT_MAX);
-					if (anno.unsatisfied_demand > 0) {
-						demand_left = true;
-						source_demand_left = true;
+		NodeID next_source = 0;
+		for (GetNextSourceBatch(finished_sources, batch_size, next_source, batch); !batch.empty(); GetNextSourceBatch(finished_sources, batch_size, next_source, batch)) {
+			/* See MCF1stPass */
+			this->SearchPaths<CapacityAnnotation, FlowEdgeIterator>(batch, batch_paths);
+			this->ClearChangedEdges();
+
+			for (size_t i = 0; i < batch.size(); i++) {
+				const NodeID source = batch[i];
+				PathVector &paths = batch_paths[i];
+				if (this->IsSearchStale<FlowEdgeIterator>(source, paths)) {
+					for (size_t j = i; j < batch.size(); j++) {
+						this->CleanupPaths(batch[j], batch_paths[j], this->job.path_allocators[j]);
+					}
+					next_source = source;
+					break;
+				}
+				bool source_demand_left = false;
+				for (DemandAnnotation &anno : this->job[source].GetDemandAnnotations()) {
+					if (anno.unsatisfied_demand == 0) continue;
+					Path *path = paths[anno.dest];
+					if (path->GetFreeCapacity() > INT_MIN) {
+						uint flow = this->PushFlow(anno, path, 1, accuracy, UINT_MAX);
+						this->MarkChangedEdges<CapacityAnnotation>(path, flow);
+						if (anno.unsatisfied_demand > 0) {
+							demand_left = true;
+							source_demand_left = true;
+						}
 					}
 				}
+				if (!source_demand_left) finished_sources[source] = true;
+				this->CleanupPaths(source, paths, this->job.path_allocators[i]);
 			}
-			if (!source_demand_left) finished_sources[source] = true;
-			this->CleanupPaths(source, paths);
 		}
 	}
 }
 
+/**
+ * Path searches of the first pass, without assigning any flow.
+ */
+class MCFBenchmark : public MultiCommodityFlow {
+public:
+	MCFBenchmark(LinkGraphJob &job) : MultiCommodityFlow(job) {}
+
+	/**
+	 * Find the shortest paths from a node to all others.
+	 * @param source Node to search from.
+	 */
+	void Search(NodeID source)
+	{
+		PathVector paths;
+		this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths, this->job.path_allocators[0]);
+		this->CleanupPaths(source, paths, this->job.path_allocators[0]);
+	}
+
+	/**
+	 * Find the shortest paths from a batch of nodes concurrently, as the MCF passes do.
+	 * @param sources Nodes to search from, at most LinkGraphJob::PATH_SEARCH_BATCH_SIZE.
+	 */
+	void SearchBatch(const std::vector<NodeID> &sources)
+	{
+		std::vector<PathVector> paths;
+		this->SearchPaths<DistanceAnnotation, GraphEdgeIterator>(sources, paths);
+		for (size_t i = 0; i < sources.size(); i++) {
+			this->CleanupPaths(sources[i], paths[i], this->job.path_allocators[i]);
+		}
+	}
+};
+
+/**
+ * Build a synthetic link graph for benchmarks and comparisons.
+ * Nodes are placed randomly on the map and linked in both directions to
+ * nearby nodes in ID order, so that the graph is connected.
+ * @param lg Empty link graph to fill.
+ * @param nodes Number of nodes.
+ * @param links Number of outgoing links per node.
+ */
+static void BuildSyntheticLinkGraph(LinkGraph &lg, uint nodes, uint links)
+{
+	Randomizer random;
+	random.SetSeed(nodes);
+
+	for (uint i = 0; i < nodes; i++) {
+		NodeID node = lg.AddNode(TileXY(random.Next(MapSizeX()), random.Next(MapSizeY())), (StationID)i, true);
+		lg[node].UpdateSupply(1 + random.Next(1000));
+	}
+	for (uint i = 0; i < nodes; i++) {
+		for (uint j = 0; j < links; j++) {
+			NodeID to = (NodeID)((i + 1 + (j == 0 ? 0 : random.Next(4 * links))) % nodes);
+			if (to == i) continue;
+			uint capacity = 10 + random.Next(500);
+			lg.UpdateEdge(i, to, capacity, 0, DAY_TICKS, EUM_UNRESTRICTED);
+			lg.UpdateEdge(to, i, capacity, 0, DAY_TICKS, EUM_UNRESTRICTED);
+		}
+	}
+}
+
+/**
+ * Time the path searches of the first MCF pass on a synthetic link graph, see BuildSyntheticLinkGraph.
+ * @param nodes Number of nodes.
+ * @param links Number of outgoing links per node.
+ * @param searches Number of path searches, from evenly spread nodes.
+ * @return Timings, or all zero if the link graph pools are full.
+ */
+LinkGraphBenchmarkResult BenchmarkLinkGraphPathSearch(uint nodes, uint links, uint searches)
+{
+	using namespace std::chrono;
+
+	nodes = Clamp<uint>(nodes, 2, INVALID_NODE);
+	links = Clamp<uint>(links, 1, nodes - 1);
+	searches = Clamp<uint>(searches, 1, nodes);
+
+	LinkGraphBenchmarkResult result{};
+	if (!LinkGraph::CanAllocateItem() || !LinkGraphJob::CanAllocateItem()) return result;
+
+	LinkGraph *lg = new LinkGraph(0);
+	BuildSyntheticLinkGraph(*lg, nodes, links);
+
+	result.nodes = nodes;
+	result.edges = (uint)lg->GetEdges().size();
+	result.searches = searches;
+
+	LinkGraphJob *job = new LinkGraphJob(*lg, 1);
+	auto start = steady_clock::now();
+	job->Init();
+	result.init_us = (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+	MCFBenchmark bench(*job);
+	start = steady_clock::now();
+	for (uint i = 0; i < searches; i++) {
+		bench.Search((NodeID)((i * nodes) / searches));
+	}
+	result.search_us = (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+	std::vector<NodeID> batch;
+	start = steady_clock::now();
+	for (uint i = 0; i < searches; i++) {
+		batch.push_back((NodeID)((i * nodes) / searches));
+		if (batch.size() == LinkGraphJob::PATH_SEARCH_BATCH_SIZE || i + 1 == searches) {
+			bench.SearchBatch(batch);
+			batch.clear();
+		}
+	}
+	result.batch_search_us = (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+	job->ResetPathAllocators();
+
+	delete job;
+	delete lg;
+	return result;
+}
+
+/**
+ * Run complete link graph jobs on a synthetic link graph with symmetric distribution, see BuildSyntheticLinkGraph,
+ * once with serial and once with batched path searches, and compare the resulting edge flows.
+ * The flows are expected to be identical.
+ * @param nodes Number of nodes.
+ * @param links Number of outgoing links per node.
+ * @param base_settings Link graph settings to run the jobs with, the distribution type is replaced by symmetric.
+ * @return Comparison, or all zero if the link graph pools are full.
+ */
+LinkGraphMCFComparison CompareLinkGraphMCFBatching(uint nodes, uint links, const LinkGraphSettings &base_settings)
+{
+	using namespace std::chrono;
+
+	nodes = Clamp<uint>(nodes, 2, INVALID_NODE);
+	links = Clamp<uint>(links, 1, nodes - 1);
+
+	LinkGraphMCFComparison result{};
+	if (!LinkGraph::CanAllocateItem() || !LinkGraphJob::CanAllocateItem(2)) return result;
+
+	LinkGraph *lg = new LinkGraph(0);
+	BuildSyntheticLinkGraph(*lg, nodes, links);
+
+	result.nodes = nodes;
+	result.edges = (uint)lg->GetEdges().size();
+
+	LinkGraphSettings settings = base_settings;
+	settings.distribution_per_cargo[lg->Cargo()] = DT_SYMMETRIC;
+	LinkGraphJob *serial = new LinkGraphJob(*lg, 1, settings);
+	serial->path_search_batch_size = 1;
+	LinkGraphJob *batched = new LinkGraphJob(*lg, 1, settings);
+
+	auto start = steady_clock::now();
+	LinkGraphSchedule::Run(serial);
+	result.serial_us = (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+	start = steady_clock::now();
+	LinkGraphSchedule::Run(batched);
+	result.batched_us = (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+	for (NodeID from = 0; from < serial->Size(); from++) {
+		for (LinkGraphJob::Edge edge : (*serial)[from].GetEdges()) {
+			const uint serial_flow = edge.Flow();
+			const uint batched_flow = (*batched)[from].GetEdgeTo(edge.To()).Flow();
+			result.serial_flow += serial_flow;
+			result.batched_flow += batched_flow;
+			if (serial_flow != batched_flow) {
+				result.differing_edges++;
+				result.flow_difference += Delta(serial_flow, batched_flow);
+			}
+		}
+	}
+
+	delete batched;
+	delete serial;
+	delete lg;
+	return result;
+}
+
 /**
  * Relation that creates a weak order without duplicates.
  * Avoid accidentally deleting different paths of the same capacity/distance in
@@ -22,14 +22,30 @@ protected:
 	{}
 
 	template<class Tannotation, class Tedge_iterator>
-	void Dijkstra(NodeID from, PathVector &paths);
+	void Dijkstra(NodeID from, PathVector &paths, DynUniformArenaAllocator &allocator);
+
+	template<class Tannotation, class Tedge_iterator>
+	void SearchPaths(const std::vector<NodeID> &sources, std::vector<PathVector> &paths);
+
+	template<class Tedge_iterator>
+	bool IsSearchStale(NodeID source, const PathVector &paths);
+
+	template<class Tannotation>
+	void MarkChangedEdges(Path *path, uint flow);
+
+	void ClearChangedEdges();
+
+	uint GetSearchCapacity(const Edge &edge) const;
 
 	uint PushFlow(DemandAnnotation &anno, Path *path, uint min_step_size, uint accuracy, uint max_saturation);
 
-	void CleanupPaths(NodeID source, PathVector &paths);
+	void CleanupPaths(NodeID source, PathVector &paths, DynUniformArenaAllocator &allocator);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
+
+	std::vector<bool> changed_edges;       ///< Edges whose flow changed since the searches of the current batch in a way that changes their result.
+	std::vector<uint> changed_edge_list;   ///< IDs of the edges set in changed_edges.
 };
 
 /**
@@ -46,6 +62,9 @@ protected:
  *   time it will take.
  * - You can increase the recalculation interval to allow for longer running
  *   times without creating lags.
+ * The pass is warm-started from the results of the previous job: sources whose
+ * demands and used links haven't changed by more than a few percent since they
+ * were last solved get their previous flows back, instead of being solved again.
  */
 class MCF1stPass : public MultiCommodityFlow {
 private:
@@ -53,6 +72,8 @@ private:
 	bool EliminateCycles(PathVector &path, NodeID origin_id, NodeID next_id);
 	void EliminateCycle(PathVector &path, Path *cycle_begin, uint flow);
 	uint FindCycleFlow(const PathVector &path, const Path *cycle_begin);
+	uint RestoreCachedSources(std::vector<bool> &reused_sources);
+	void StoreResults(const std::vector<bool> &reused_sources);
 public:
 	MCF1stPass(LinkGraphJob &job);
 };
@@ -15,6 +15,7 @@
 #include "rail_map.h"
 #include "tunnelbridge_map.h"
 #include "pathfinder/water_regions.h"
+#include "pathfinder/rail_regions.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 #include "core/ring_buffer.hpp"
 #include <array>
@@ -35,6 +36,7 @@ uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
 Tile *_m = nullptr;          ///< Tiles of the map
 TileExtended *_me = nullptr; ///< Extended Tiles of the map
+TileShadow *_ms = nullptr;   ///< Compact copy of the type and height of the tiles of the map
 
 #if defined(__linux__) && defined(MADV_HUGEPAGE)
 static size_t _munmap_size = 0;
@@ -91,7 +93,7 @@ void AllocateMap(uint size_x, uint size_y)
 
 	free(_m);
 
-	const size_t total_size = (sizeof(Tile) + sizeof(TileExtended)) * _map_size;
+	const size_t total_size = (sizeof(Tile) + sizeof(TileExtended) + sizeof(TileShadow)) * _map_size;
 
 	byte *buf = nullptr;
 #if defined(__linux__) && defined(MADV_HUGEPAGE)
@@ -129,8 +131,23 @@ void AllocateMap(uint size_x, uint size_y)
 
 	_m = reinterpret_cast<Tile *>(buf);
 	_me = reinterpret_cast<TileExtended *>(buf + (_map_size * sizeof(Tile)));
+	_ms = reinterpret_cast<TileShadow *>(buf + (_map_size * (sizeof(Tile) + sizeof(TileExtended))));
 
 	InitializeWaterRegions();
+	InitializeRailRegions();
+}
+
+/**
+ * Rebuild the whole tile shadow array from the tile array.
+ * This is required after the tile array has been written directly instead of via the map accessors, e.g. when loading a savegame.
+ */
+void RebuildTileShadow()
+{
+	const uint size = MapSize();
+	for (uint i = 0; i < size; i++) {
+		_ms[i].type = _m[i].type;
+		_ms[i].height = _m[i].height;
+	}
 }
 
 
@@ -41,8 +41,17 @@ extern Tile *_m;
  */
 extern TileExtended *_me;
 
+/**
+ * Pointer to the tile shadow array.
+ *
+ * This variable points to the compact copy of the type and height
+ * of the tiles of the map, see #TileShadow.
+ */
+extern TileShadow *_ms;
+
 bool ValidateMapSize(uint size_x, uint size_y);
 void AllocateMap(uint size_x, uint size_y);
+void RebuildTileShadow();
 
 /**
  * Logarithm of the map size along the X side.
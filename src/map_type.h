@@ -36,6 +36,19 @@ struct TileExtended {
 	uint16_t m8; ///< General purpose
 };
 
+/**
+ * Compact copy of the most frequently read fields of #Tile.
+ * This is kept in sync by the map accessors, so that loops which only need the
+ * tile type or height touch a quarter of the memory of the full tile array.
+ * @see RebuildTileShadow
+ */
+struct TileShadow {
+	byte type;   ///< Copy of Tile::type
+	byte height; ///< Copy of Tile::height
+};
+
+static_assert(sizeof(TileShadow) == 2);
+
 /**
  * An offset value between two tiles.
  *
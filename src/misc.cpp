@@ -31,6 +31,7 @@
 #include "viewport_kdtree.h"
 #include "newgrf_profiling.h"
 #include "tracerestrict.h"
+#include "tracerestrict_memo.h"
 #include "programmable_signals.h"
 #include "viewport_func.h"
 #include "bridge_signal_map.h"
@@ -42,6 +43,8 @@
 #include "event_logs.h"
 #include "string_func.h"
 #include "plans_func.h"
+#include "sl/saveload.h"
+#include "pathfinder/yapf/yapf_cache.h"
 #include "core/format.hpp"
 #include "3rdparty/monocypher/monocypher.h"
 
@@ -123,6 +126,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	ClearCommandQueue();
 	ClearSpecialEventsLog();
 	ClearDesyncMsgLog();
+	ClearDeltaSaveBase();
 
 	_pause_mode = PM_UNPAUSED;
 	_pause_countdown = 0;
@@ -138,6 +142,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	_aux_tileloop_tile = 1;
 	_thd.redsq = INVALID_TILE;
 	_road_layout_change_counter = 0;
+	YapfNotifyRoadLayoutChange(INVALID_TILE);
 	_loaded_local_company = COMPANY_SPECTATOR;
 	_game_events_since_load = (GameEventFlags) 0;
 	_game_events_overall = (GameEventFlags) 0;
@@ -177,6 +182,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	UpdateCachedSnowLineBounds();
 
 	ClearTraceRestrictMapping();
+	InvalidateTraceRestrictMemo();
 	ClearBridgeSimulatedSignalMapping();
 	ClearBridgeSignalStyleMapping();
 	ClearCargoPacketDeferredPayments();
@@ -191,6 +197,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 
 	FreeSignalPrograms();
 	FreeSignalDependencies();
+	FlushSignalSegmentCache();
 
 	ClearAllSignalSpeedRestrictions();
 
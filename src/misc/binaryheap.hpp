@@ -290,6 +290,16 @@ public:
 		return 0;
 	}
 
+	/**
+	 * Remove the given item from the priority queue.
+	 *
+	 * @param item The reference to the item, which must be in the queue
+	 */
+	inline void Remove(T &item)
+	{
+		this->Remove(this->FindIndex(item));
+	}
+
 	/**
 	 * Make the priority queue empty.
 	 * All remaining items will remain untouched.
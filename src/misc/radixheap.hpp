@@ -0,0 +1,164 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file radixheap.hpp Radix heap priority queue for items with non-negative integer keys. */
+
+#ifndef RADIXHEAP_HPP
+#define RADIXHEAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+/**
+ * Radix heap, a priority queue for items with non-negative integer keys,
+ * which is cheapest when the smallest key only ever increases, as in an A* search
+ * with a consistent heuristic.
+ *
+ * The key of an item is item->GetCostEstimate(), and must not change while the item is in the queue.
+ *
+ * Items are held in buckets by the position of the highest bit in which their key differs from
+ * the last removed key, so only the items in the lowest non-empty bucket ever have to be looked at,
+ * and each item moves to a lower bucket at most 32 times.
+ * Inserting an item with a key lower than the last removed key is allowed, but all items are redistributed when this happens.
+ *
+ * The interface matches that of CBinaryHeapT, so that either can be used as the open list of a node list.
+ * Items with equal keys are not necessarily returned in the same order as by CBinaryHeapT.
+ */
+template <class T>
+class CRadixHeapT {
+private:
+	static constexpr uint BUCKET_COUNT = 33;
+
+	std::array<std::vector<T *>, BUCKET_COUNT> buckets; ///< Items, by the highest bit in which their key differs from last_key
+	uint32_t last_key = 0; ///< The lowest key in the queue, once bucket 0 is non-empty
+	uint items = 0;        ///< Number of items in the queue
+
+	static inline uint32_t GetKey(T *item)
+	{
+		const int key = item->GetCostEstimate();
+		dbg_assert(key >= 0);
+		return static_cast<uint32_t>(key);
+	}
+
+	inline uint GetBucket(uint32_t key) const
+	{
+		return std::bit_width(key ^ this->last_key);
+	}
+
+	/** Make bucket 0 hold the items with the lowest key, unless the queue is empty. */
+	inline void Refill()
+	{
+		if (!this->buckets[0].empty() || this->items == 0) return;
+
+		uint i = 1;
+		while (this->buckets[i].empty()) i++;
+
+		std::vector<T *> &bucket = this->buckets[i];
+		uint32_t min_key = UINT32_MAX;
+		for (T *item : bucket) {
+			min_key = std::min(min_key, GetKey(item));
+		}
+		this->last_key = min_key;
+
+		/* All items in the bucket now differ from last_key in a lower bit than i. */
+		for (T *item : bucket) {
+			this->buckets[this->GetBucket(GetKey(item))].push_back(item);
+		}
+		bucket.clear();
+	}
+
+	/** Redistribute all items after a key lower than last_key was inserted. */
+	void Rebase(uint32_t key)
+	{
+		std::vector<T *> all;
+		all.reserve(this->items);
+		for (std::vector<T *> &bucket : this->buckets) {
+			all.insert(all.end(), bucket.begin(), bucket.end());
+			bucket.clear();
+		}
+		this->last_key = key;
+		for (T *item : all) {
+			this->buckets[this->GetBucket(GetKey(item))].push_back(item);
+		}
+	}
+
+public:
+	/**
+	 * Create a radix heap.
+	 * @param max_items Unused, buckets grow as needed. Present for compatibility with CBinaryHeapT.
+	 */
+	explicit CRadixHeapT([[maybe_unused]] uint max_items = 0) {}
+
+	/** Get the number of items in the queue. */
+	inline uint Length() const { return this->items; }
+
+	/** Test if the queue is empty. */
+	inline bool IsEmpty() const { return this->items == 0; }
+
+	/**
+	 * Get the item with the lowest key.
+	 * @pre !IsEmpty()
+	 */
+	inline T *Begin()
+	{
+		dbg_assert(!this->IsEmpty());
+		this->Refill();
+		return this->buckets[0].back();
+	}
+
+	/**
+	 * Insert an item.
+	 * @param new_item The item to insert.
+	 */
+	inline void Include(T *new_item)
+	{
+		const uint32_t key = GetKey(new_item);
+		if (key < this->last_key) this->Rebase(key);
+		this->buckets[this->GetBucket(key)].push_back(new_item);
+		this->items++;
+	}
+
+	/**
+	 * Remove and return the item with the lowest key.
+	 * @pre !IsEmpty()
+	 */
+	inline T *Shift()
+	{
+		T *first = this->Begin();
+		this->buckets[0].pop_back();
+		this->items--;
+		return first;
+	}
+
+	/**
+	 * Remove an item from the queue.
+	 * @param item The item to remove, which must be in the queue with an unchanged key.
+	 */
+	inline void Remove(T &item)
+	{
+		std::vector<T *> &bucket = this->buckets[this->GetBucket(GetKey(&item))];
+		auto iter = std::find(bucket.begin(), bucket.end(), &item);
+		dbg_assert(iter != bucket.end());
+		*iter = bucket.back();
+		bucket.pop_back();
+		this->items--;
+	}
+
+	/** Remove all items. */
+	inline void Clear()
+	{
+		for (std::vector<T *> &bucket : this->buckets) {
+			bucket.clear();
+		}
+		this->last_key = 0;
+		this->items = 0;
+	}
+};
+
+#endif /* RADIXHEAP_HPP */
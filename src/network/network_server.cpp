@@ -34,7 +34,6 @@
 #include "../crashlog.h"
 #include "../3rdparty/monocypher/monocypher.h"
 #include <mutex>
-#include <condition_variable>
 #include <tuple>
 
 #include "../safeguards.h"
@@ -58,55 +57,37 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
-struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
-	size_t total_size;                  ///< Total size of the compressed savegame.
-	std::vector<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame; send these "slowly" to the client.
-	std::unique_ptr<Packet> map_size_packet; ///< Map size packet, fast tracked to the client
-	std::mutex mutex;                   ///< Mutex for making threaded saving safe.
-	std::condition_variable exit_sig;   ///< Signal for threaded destruction of this packet writer.
+/** Maximum amount of a map snapshot queued for sending to a client at once. */
+static const size_t MAP_SNAPSHOT_QUEUE_SIZE = 64 * 1024;
+
+/**
+ * Savegame of the map, which is written once and sent to all clients joining at the time.
+ * The savegame is only ever appended to, so every client keeps its own position in it.
+ */
+struct NetworkMapSnapshot : SaveFilter {
+	const uint32_t frame;   ///< Frame counter at which the snapshot was made.
+	const bool zstd;        ///< Whether the savegame may be compressed using zstd.
+	std::vector<byte> data; ///< The compressed savegame.
+	bool finished = false;  ///< Whether the savegame has been written completely.
+	bool cancelled = false; ///< Whether no client wants the savegame anymore.
+	std::mutex mutex;       ///< Mutex for making threaded saving safe.
 
 	/**
-	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
+	 * Create the snapshot.
+	 * @param frame The frame counter at which the snapshot is made.
+	 * @param zstd Whether all clients receiving the snapshot support zstd compression.
 	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), cs(cs), total_size(0)
+	NetworkMapSnapshot(uint32_t frame, bool zstd) : SaveFilter(nullptr), frame(frame), zstd(zstd)
 	{
 	}
 
-	/** Make sure everything is cleaned up. */
-	~PacketWriter()
-	{
-		std::unique_lock<std::mutex> lock(this->mutex);
-
-		if (this->cs != nullptr) this->exit_sig.wait(lock);
-
-		/* This must all wait until the Destroy function is called. */
-
-		this->packets.clear();
-		this->map_size_packet.reset();
-		this->current.reset();
-	}
-
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
-	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to nullptr, triggering the appending to fail due to
-	 * the connection problem and eventually triggering the destructor. In the
-	 * second case the destructor is already called, and it is waiting for our
-	 * signal which we will send. Only then the packets will be removed by the
-	 * destructor.
+	 * Stop the saving, as no client wants the map anymore.
 	 */
-	void Destroy()
+	void Cancel()
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
-
-		this->cs = nullptr;
-
-		this->exit_sig.notify_all();
+		this->cancelled = true;
 		lock.unlock();
 
 		/* Make sure the saving is completely cancelled. Yes,
@@ -116,71 +97,62 @@ struct PacketWriter : SaveFilter {
 	}
 
 	/**
-	 * Transfer all packets from here to the network's queue while holding
-	 * the lock on our mutex.
-	 * @return True iff the last packet of the map has been sent.
+	 * Queue packets of the next part of the savegame the client has not got yet,
+	 * while holding the lock on our mutex. At most #MAP_SNAPSHOT_QUEUE_SIZE bytes
+	 * are queued, and while the savegame is still being written only full packets.
+	 * @param cs The socket handler to queue the packets for.
+	 * @return True iff the last packet of the map has been queued.
 	 */
-	bool TransferToNetworkQueue()
+	bool TransferToNetworkQueue(ServerNetworkGameSocketHandler *cs)
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		if (this->map_size_packet) {
-			/* Don't queue the PACKET_SERVER_MAP_SIZE before the corresponding PACKET_SERVER_MAP_BEGIN */
-			this->cs->SendPrependPacket(std::move(this->map_size_packet), PACKET_SERVER_MAP_BEGIN);
+		if (this->finished && !cs->map_snapshot_size_sent) {
+			/* Fast-track the size to the client, but don't queue it before the corresponding PACKET_SERVER_MAP_BEGIN. */
+			auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_SIZE, TCP_MTU);
+			p->Send_uint32((uint32_t)this->data.size());
+			cs->SendPrependPacket(std::move(p), PACKET_SERVER_MAP_BEGIN);
+			cs->map_snapshot_size_sent = true;
 		}
-		bool last_packet = false;
-		for (auto &p : this->packets) {
-			if (p->GetPacketType() == PACKET_SERVER_MAP_DONE) last_packet = true;
-			this->cs->SendPacket(std::move(p));
 
+		const size_t queue_end = std::min(this->data.size(), cs->map_snapshot_pos + MAP_SNAPSHOT_QUEUE_SIZE);
+		const byte *end = this->data.data() + this->data.size();
+		while (cs->map_snapshot_pos < queue_end && (this->finished || this->data.size() - cs->map_snapshot_pos >= TCP_MTU)) {
+			auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
+			cs->map_snapshot_pos += p->Send_binary_until_full(this->data.data() + cs->map_snapshot_pos, end);
+			cs->SendPacket(std::move(p));
 		}
-		this->packets.clear();
+		if (!this->finished || cs->map_snapshot_pos < this->data.size()) return false;
 
-		return last_packet;
+		/* Add a packet stating that this is the end to the queue. */
+		cs->SendPacket(std::make_unique<Packet>(PACKET_SERVER_MAP_DONE));
+		return true;
 	}
 
 	void Write(byte *buf, size_t size) override
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when no client wants the map anymore. */
+		if (this->cancelled) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-		if (this->current == nullptr) this->current = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
-
-		byte *bufe = buf + size;
-		while (buf != bufe) {
-			size_t written = this->current->Send_binary_until_full(buf, bufe);
-			buf += written;
-
-			if (!this->current->CanWriteToPacket(1)) {
-				this->packets.push_back(std::move(this->current));
-				if (buf != bufe) this->current = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
-			}
-		}
-
-		this->total_size += size;
+		this->data.insert(this->data.end(), buf, buf + size);
 	}
 
 	void Finish() override
 	{
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
-		/* Make sure the last packet is flushed. */
-		if (this->current != nullptr) this->packets.push_back(std::move(this->current));
-
-		/* Add a packet stating that this is the end to the queue. */
-		this->packets.push_back(std::make_unique<Packet>(PACKET_SERVER_MAP_DONE));
+		/* We want to abort the saving when no client wants the map anymore. */
+		if (this->cancelled) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-		/* Fast-track the size to the client. */
-		this->map_size_packet.reset(new Packet(PACKET_SERVER_MAP_SIZE, TCP_MTU));
-		this->map_size_packet->Send_uint32((uint32_t)this->total_size);
+		this->finished = true;
 	}
 };
 
+/** Maximum age in frames of a map snapshot for a client requesting the map to still get it, instead of waiting for the next snapshot. */
+static const uint32_t MAX_MAP_SNAPSHOT_JOIN_AGE = 5 * DAY_TICKS;
+
 
 /**
  * Create a new socket for the server side of the game connection.
@@ -211,10 +183,7 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 	extern void RemoveVirtualTrainsOfUser(uint32_t user);
 	RemoveVirtualTrainsOfUser(this->client_id);
 
-	if (this->savegame != nullptr) {
-		this->savegame->Destroy();
-		this->savegame = nullptr;
-	}
+	if (this->map_snapshot != nullptr) this->ReleaseMapSnapshot();
 }
 
 bool ServerNetworkGameSocketHandler::ParseKeyPasswordPacket(Packet &p, NetworkSharedSecrets &ss, const std::string &password, std::string *payload, size_t length)
@@ -317,9 +286,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 	/* If we were transfering a map to this client, stop the savegame creation
 	 * process and queue the next client to receive the map. */
 	if (this->status == STATUS_MAP) {
-		/* Ensure the saving of the game is stopped too. */
-		this->savegame->Destroy();
-		this->savegame = nullptr;
+		/* Ensure the saving of the game is stopped too, unless others still receive it. */
+		this->ReleaseMapSnapshot();
 
 		this->CheckNextClientToSendMap(this);
 	}
@@ -617,11 +585,13 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
 
 void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocket *ignore_cs)
 {
-	/* Find the best candidate for joining, i.e. the first joiner. */
+	/* Find the best candidate for joining, i.e. the first joiner; unless a map is still being sent,
+	 * in which case the next snapshot is made when that has finished. */
 	NetworkClientSocket *best = nullptr;
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-		if (ignore_cs == new_cs) continue;
+		if (ignore_cs == new_cs || new_cs->IsPendingDeletion()) continue;
 
+		if (new_cs->status == STATUS_MAP && new_cs->map_snapshot != nullptr) return;
 		if (new_cs->status == STATUS_MAP_WAIT) {
 			if (best == nullptr || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
 				best = new_cs;
@@ -629,17 +599,63 @@ void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocke
 		}
 	}
 
-	/* Is there someone else to join? */
+	/* Is there someone else to join? Then all waiting clients get the same snapshot. */
 	if (best != nullptr) {
-		/* Let the first start joining. */
 		best->status = STATUS_AUTHORIZED;
 		best->SendMap();
 
 		/* And update the rest. */
 		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-			if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
+			if (new_cs->status == STATUS_MAP_WAIT && !new_cs->IsPendingDeletion()) new_cs->SendWait();
+		}
+	}
+}
+
+/**
+ * Start sending a snapshot of the map to this client.
+ * @param snapshot The snapshot to send.
+ * @param source Client which is already receiving the snapshot, or nullptr if the snapshot is made right now.
+ */
+void ServerNetworkGameSocketHandler::BeginMapSnapshot(std::shared_ptr<NetworkMapSnapshot> snapshot, const NetworkClientSocket *source)
+{
+	this->map_snapshot = std::move(snapshot);
+	this->map_snapshot_pos = 0;
+	this->map_snapshot_size_sent = false;
+
+	/* Now send the frame counter of the snapshot */
+	auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_BEGIN, TCP_MTU);
+	p->Send_uint32(this->map_snapshot->frame);
+	this->SendPacket(std::move(p));
+
+	if (source == nullptr) {
+		NetworkSyncCommandQueue(this);
+	} else {
+		/* The source has gathered all commands after the frame of the snapshot, so those have to be sent to this client too. */
+		for (const CommandPacket &cp : source->outgoing_queue) {
+			CommandPacket &c = this->outgoing_queue.emplace_back(cp);
+			c.callback = nullptr;
+			c.my_cmd = false;
 		}
 	}
+	this->status = STATUS_MAP;
+	/* Mark the start of download */
+	this->last_frame = _frame_counter;
+	this->last_frame_server = _frame_counter;
+}
+
+/**
+ * Stop sending the snapshot of the map to this client.
+ * When no other client is receiving the snapshot, the saving of the game is stopped too.
+ */
+void ServerNetworkGameSocketHandler::ReleaseMapSnapshot()
+{
+	std::shared_ptr<NetworkMapSnapshot> snapshot = std::move(this->map_snapshot);
+	this->map_snapshot = nullptr;
+
+	for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+		if (cs != this && cs->map_snapshot == snapshot) return;
+	}
+	snapshot->Cancel();
 }
 
 /** This sends the map to the client */
@@ -652,38 +668,43 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 
 	if (this->status == STATUS_AUTHORIZED) {
 		WaitTillSaved();
-		this->savegame = std::make_shared<PacketWriter>(this);
 
-		/* Now send the _frame_counter and how many packets are coming */
-		auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_BEGIN, TCP_MTU);
-		p->Send_uint32(_frame_counter);
-		this->SendPacket(std::move(p));
+		/* All clients waiting for the map get the same snapshot, so it must be in a format all of them support. */
+		auto is_waiting = [](const NetworkClientSocket *cs) { return cs->status == STATUS_MAP_WAIT && !cs->IsPendingDeletion(); };
+		bool zstd = this->supports_zstd;
+		for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+			if (is_waiting(cs)) zstd &= cs->supports_zstd;
+		}
 
-		NetworkSyncCommandQueue(this);
-		this->status = STATUS_MAP;
-		/* Mark the start of download */
-		this->last_frame = _frame_counter;
-		this->last_frame_server = _frame_counter;
+		auto snapshot = std::make_shared<NetworkMapSnapshot>(_frame_counter, zstd);
+		for (NetworkClientSocket *cs : NetworkClientSocket::Iterate()) {
+			if (cs == this || is_waiting(cs)) cs->BeginMapSnapshot(snapshot, nullptr);
+		}
 
 		/* Make a dump of the current game */
 		SaveModeFlags flags = SMF_NET_SERVER;
-		if (this->supports_zstd) flags |= SMF_ZSTD_OK;
-		if (SaveWithFilter(this->savegame, true, flags) != SL_OK) usererror("network savedump failed");
+		if (zstd) flags |= SMF_ZSTD_OK;
+		if (SaveWithFilter(snapshot, true, flags) != SL_OK) usererror("network savedump failed");
 	}
 
-	if (this->status == STATUS_MAP) {
-		bool last_packet = this->savegame->TransferToNetworkQueue();
+	/* Only queue more of the map when everything queued before has been sent, so
+	 * the snapshot isn't copied into the send queues of all clients receiving it. */
+	while (this->status == STATUS_MAP && !this->HasSendQueue()) {
+		bool last_packet = this->map_snapshot->TransferToNetworkQueue(this);
 		if (last_packet) {
-			/* Done reading, make sure saving is done as well */
-			this->savegame->Destroy();
-			this->savegame = nullptr;
+			/* Done reading, the saving is done as well */
+			this->map_snapshot = nullptr;
 
 			/* Set the status to DONE_MAP, no we will wait for the client
 			 *  to send it is ready (maybe that happens like never ;)) */
 			this->status = STATUS_DONE_MAP;
 
 			this->CheckNextClientToSendMap();
+			break;
 		}
+
+		/* Stop when nothing more has been saved yet, or the socket doesn't take everything right now. */
+		if (!this->HasSendQueue() || this->SendPackets() != SPS_ALL_SENT) break;
 	}
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -1111,7 +1132,13 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet &
 
 	/* Check if someone else is receiving the map */
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-		if (new_cs->status == STATUS_MAP) {
+		if (new_cs->status == STATUS_MAP && new_cs->map_snapshot != nullptr && !new_cs->IsPendingDeletion()) {
+			/* Get the same snapshot when it is recent enough, as then catching up with the commands since is quick */
+			if (_frame_counter - new_cs->map_snapshot->frame <= MAX_MAP_SNAPSHOT_JOIN_AGE && (this->supports_zstd || !new_cs->map_snapshot->zstd)) {
+				this->BeginMapSnapshot(new_cs->map_snapshot, new_cs);
+				return this->SendMap();
+			}
+
 			/* Tell the new client to wait */
 			this->status = STATUS_MAP_WAIT;
 			return this->SendWait();
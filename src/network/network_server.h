@@ -85,7 +85,9 @@ public:
 	bool settings_authed = false;///< Authorised to control all game settings
 	bool supports_zstd = false;  ///< Client supports zstd compression
 
-	std::shared_ptr<struct PacketWriter> savegame; ///< Writer used to write the savegame.
+	std::shared_ptr<struct NetworkMapSnapshot> map_snapshot; ///< Snapshot of the map which is being sent to the client.
+	size_t map_snapshot_pos = 0;                             ///< Amount of the snapshot which has been queued for sending.
+	bool map_snapshot_size_sent = false;                     ///< Whether the size of the snapshot has been queued for sending.
 	NetworkAddress client_address; ///< IP-address of the client (so they can be banned)
 
 	std::string desync_log;
@@ -102,6 +104,8 @@ public:
 	void GetClientName(char *client_name, const char *last) const;
 
 	void CheckNextClientToSendMap(NetworkClientSocket *ignore_cs = nullptr);
+	void BeginMapSnapshot(std::shared_ptr<struct NetworkMapSnapshot> snapshot, const NetworkClientSocket *source);
+	void ReleaseMapSnapshot();
 
 	NetworkRecvStatus SendWait();
 	NetworkRecvStatus SendMap();
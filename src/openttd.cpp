@@ -90,6 +90,7 @@
 #include "worker_thread.h"
 #include "scope_info.h"
 #include "network/network_survey.h"
+#include "pathfinder/yapf/yapf_query_log.h"
 #include "timer/timer.h"
 #include "timer/timer_game_realtime.h"
 #include "timer/timer_game_tick.h"
@@ -307,6 +308,8 @@ static void ShowHelp()
 		"  -Q                  = Don't scan for/load NewGRF files on startup\n"
 		"  -QQ                 = Disable NewGRF scanning/loading entirely\n"
 		"  -Z                  = Write detailed version information and exit\n"
+		"  -y query_log        = Record all pathfinder queries of the game to 'query_log'\n"
+		"  -Y query_log        = Compare all pathfinder queries of the game with 'query_log'\n"
 		"\n",
 		lastof(buf)
 	);
@@ -479,6 +482,8 @@ static void ParseResolution(Dimension *res, const char *s)
  */
 static void ShutdownGame()
 {
+	YapfQueryLogStop();
+
 	IConsoleFree();
 
 	if (_network_available) NetworkShutDown(); // Shut down the network and close any open connections
@@ -757,6 +762,8 @@ static const OptionData _options[] = {
 	 GETOPT_SHORT_NOVAL('Q'),
 	 GETOPT_SHORT_VALUE('J'),
 	 GETOPT_SHORT_NOVAL('Z'),
+	 GETOPT_SHORT_VALUE('y'),
+	 GETOPT_SHORT_VALUE('Y'),
 	GETOPT_END()
 };
 
@@ -933,6 +940,14 @@ int openttd_main(int argc, char *argv[])
 			return ret;
 		}
 		case 'X': only_local_path = true; break;
+		case 'y':
+		case 'Y':
+			if (!YapfQueryLogStart(i == 'y' ? YQLM_RECORD : YQLM_REPLAY, mgo.opt)) {
+				fprintf(stderr, "Failed to open pathfinder query log: %s\n", mgo.opt);
+				ret = 1;
+				return ret;
+			}
+			break;
 		case 'h':
 			i = -2; // Force printing of help.
 			break;
@@ -1110,7 +1125,7 @@ int openttd_main(int argc, char *argv[])
 	/* ScanNewGRFFiles now has control over the scanner. */
 	RequestNewGRFScan(scanner.release());
 
-	_general_worker_pool.Start("ottd:worker", 8);
+	_general_worker_pool.Start("ottd:worker", std::thread::hardware_concurrency());
 
 	VideoDriver::GetInstance()->MainLoop();
 
@@ -2123,6 +2138,14 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 		} else {
 			CCLOG("Order destination refcount map not valid");
 		}
+
+		for (TileIndex t = 0; t < MapSize(); t++) {
+			if (_ms[t].type != _m[t].type || _ms[t].height != _m[t].height) {
+				CCLOG("Tile shadow mismatch: tile: 0x%X (%u x %u), type: 0x%X, 0x%X, height: %u, %u",
+						t, TileX(t), TileY(t), _ms[t].type, _m[t].type, _ms[t].height, _m[t].height);
+				break;
+			}
+		}
 	}
 
 	if (flags & CHECK_CACHE_WATER_REGIONS) {
@@ -2130,6 +2153,11 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log, CheckC
 		WaterRegionCheckCaches(log);
 	}
 
+	if (flags & CHECK_CACHE_RAIL_REGIONS) {
+		extern void RailRegionCheckCaches(std::function<void(const char *)> log);
+		RailRegionCheckCaches(log);
+	}
+
 	if ((flags & CHECK_CACHE_EMIT_LOG) && !saved_messages.empty()) {
 		InconsistencyExtraInfo info;
 		info.check_caches_result = std::move(saved_messages);
@@ -2182,6 +2210,7 @@ void StateGameLoop()
 		PerformanceMeasurer::Paused(PFE_GL_SHIPS);
 		PerformanceMeasurer::Paused(PFE_GL_AIRCRAFT);
 		PerformanceMeasurer::Paused(PFE_GL_LANDSCAPE);
+		PerformanceMeasurer::Paused(PFE_GL_ANIMATED_TILES);
 
 		if (!HasModalProgress()) UpdateLandscapingLimits();
 #ifndef DEBUG_DUMP_COMMANDS
@@ -2192,6 +2221,7 @@ void StateGameLoop()
 
 	PerformanceMeasurer framerate(PFE_GAMELOOP);
 	PerformanceAccumulator::Reset(PFE_GL_LANDSCAPE);
+	PerformanceAccumulator::Reset(PFE_GL_ANIMATED_TILES);
 
 	Layouter::ReduceLineCache();
 
@@ -0,0 +1,179 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file rail_regions.cpp Handles dividing the rail network in the map into square regions to assist hierarchical pathfinding. */
+
+#include "stdafx.h"
+#include "debug.h"
+#include "map_func.h"
+#include "rail_regions.h"
+#include "region_patches_graph.hpp"
+#include "track_func.h"
+#include "transport_type.h"
+#include "landscape.h"
+#include "rail_map.h"
+#include "tunnelbridge_map.h"
+
+#include "safeguards.h"
+
+static inline TrackdirBits GetRailTrackdirs(TileIndex tile) { return TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)); }
+
+/**
+ * Returns the tile which is reached when leaving a tile along a trackdir, if the track there connects to it.
+ * Signals, ownership, rail types and 90 degree turns are deliberately ignored, the connectivity is an
+ * undirected over-approximation of what any train could use. This keeps it symmetric between both tiles.
+ * @param tile The tile to leave.
+ * @param td The trackdir to leave the tile by, this must be present on the tile.
+ * @returns The connected tile, or INVALID_TILE if there is none.
+ */
+static TileIndex GetConnectedRailTile(TileIndex tile, Trackdir td)
+{
+	const DiagDirection exitdir = TrackdirToExitdir(td);
+
+	/* Rail depots can only be left through their entrance */
+	if (IsRailDepotTile(tile) && GetRailDepotDirection(tile) != exitdir) return INVALID_TILE;
+
+	/* Tunnels and bridges lead directly to their other end */
+	if (IsRailTunnelBridgeTile(tile) && GetTunnelBridgeDirection(tile) == exitdir) return GetOtherTunnelBridgeEnd(tile);
+
+	const TileIndex new_tile = TileAddByDiagDir(tile, exitdir);
+
+	if (IsRailTunnelBridgeTile(new_tile)) {
+		const DiagDirection tb_dir = GetTunnelBridgeDirection(new_tile);
+		if (IsTunnel(new_tile) ? tb_dir != exitdir : tb_dir == ReverseDiagDir(exitdir)) return INVALID_TILE;
+	}
+	if (IsRailDepotTile(new_tile) && ReverseDiagDir(GetRailDepotDirection(new_tile)) != exitdir) return INVALID_TILE;
+
+	if ((GetRailTrackdirs(new_tile) & DiagdirReachesTrackdirs(exitdir)) == TRACKDIR_BIT_NONE) return INVALID_TILE;
+	return new_tile;
+}
+
+static std::unique_ptr<PatchRegion[]> _rail_regions;
+
+/** Connectivity of rail tiles, for PatchRegionReferenceT. */
+struct RailRegionPolicy {
+	static inline PatchRegion &GetRegion(TRailRegionIndex index) { return _rail_regions[index]; }
+
+	static inline TrackdirBits GetTrackdirs(TileIndex tile) { return GetRailTrackdirs(tile); }
+
+	static inline TileIndex FollowTrackdir(TileIndex tile, Trackdir td, bool &is_link)
+	{
+		is_link = IsRailTunnelBridgeTile(tile) && GetTunnelBridgeDirection(tile) == TrackdirToExitdir(td);
+		return GetConnectedRailTile(tile, td);
+	}
+
+	static inline TileIndex GetLinkOtherEnd(TileIndex tile) { return IsRailTunnelBridgeTile(tile) ? GetOtherTunnelBridgeEnd(tile) : INVALID_TILE; }
+};
+
+/**
+ * Returns the index of the rail region containing the tile.
+ * @param tile The tile to return the region index for.
+ */
+TRailRegionIndex GetRailRegionIndex(TileIndex tile)
+{
+	return GetRegionIndex(tile);
+}
+
+/**
+ * Returns the index of the rail region of a rail region patch.
+ * @param rail_region_patch The rail region patch to return the region index for.
+ */
+TRailRegionIndex GetRailRegionIndex(const RailRegionPatchDesc &rail_region_patch)
+{
+	return GetRegionIndex(rail_region_patch.x, rail_region_patch.y);
+}
+
+/**
+ * Calculates a number that uniquely identifies the provided rail region patch.
+ * @param rail_region_patch The rail region patch to calculate the hash for.
+ */
+uint32_t CalculateRailRegionPatchHash(const RailRegionPatchDesc &rail_region_patch)
+{
+	return CalculateRegionPatchHash(rail_region_patch);
+}
+
+/**
+ * Returns rail region patch information for the provided tile, updating the region if necessary.
+ * @param tile The tile for which the information will be calculated.
+ */
+RailRegionPatchDesc GetRailRegionPatchInfo(TileIndex tile)
+{
+	return GetRegionPatchInfo<RailRegionPolicy>(tile);
+}
+
+/**
+ * Marks the rail region that the tile is part of as invalid.
+ * This must be called for every tile whose track connectivity changes, also when a change covers many tiles.
+ * @param tile Tile within the rail region that we wish to invalidate.
+ */
+void InvalidateRailRegion(TileIndex tile)
+{
+	if (tile >= MapSize() || _rail_regions == nullptr) return;
+
+	/* Edge traversability looks into the adjacent region, so changes to edge tiles also affect the neighbouring region. */
+	ForEachRegionAffectedByTile(tile, [](TRailRegionIndex region) {
+		_rail_regions[region].Invalidate();
+	});
+
+	/* The other end of a tunnel or bridge is connected directly to this tile. */
+	if (IsRailTunnelBridgeTile(tile)) _rail_regions[GetRegionIndex(GetOtherTunnelBridgeEnd(tile))].Invalidate();
+}
+
+/**
+ * Marks all rail regions as invalid.
+ */
+void InvalidateAllRailRegions()
+{
+	if (_rail_regions == nullptr) return;
+
+	const uint32_t count = GetRegionMapSizeX() * GetRegionMapSizeY();
+	for (uint32_t i = 0; i < count; i++) {
+		_rail_regions[i].Invalidate();
+	}
+}
+
+/**
+ * Calls the provided callback function on all accessible rail region patches in
+ * each cardinal direction, plus any others that are reachable via tunnels and bridges.
+ * @param rail_region_patch Rail patch within the rail region to start searching from
+ * @param callback The function that will be called for each accessible rail patch that is found
+ */
+void VisitRailRegionPatchNeighbors(const RailRegionPatchDesc &rail_region_patch, const TVisitRailRegionPatchCallBack &callback)
+{
+	VisitRegionPatchNeighbors<RailRegionPolicy>(rail_region_patch, callback);
+}
+
+/**
+ * Calls the provided callback function with the index of the region of the patch, and of each of the up to 8 regions surrounding it.
+ * @param rail_region_patch Rail patch at the centre of the neighbourhood
+ * @param callback The function that will be called for each region index
+ */
+void VisitRailRegionNeighborhood(const RailRegionPatchDesc &rail_region_patch, std::function<void(TRailRegionIndex)> callback)
+{
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			/* Unsigned underflow is allowed here, not UB */
+			const uint32_t nx = rail_region_patch.x + (uint32_t)dx;
+			const uint32_t ny = rail_region_patch.y + (uint32_t)dy;
+			if (nx >= GetRegionMapSizeX() || ny >= GetRegionMapSizeY()) continue;
+			callback(GetRegionIndex(nx, ny));
+		}
+	}
+}
+
+/**
+ * Initializes all rail regions. Regions are labelled lazily when first used by the pathfinder.
+ */
+void InitializeRailRegions()
+{
+	_rail_regions.reset(new PatchRegion[GetRegionMapSizeX() * GetRegionMapSizeY()]);
+}
+
+void RailRegionCheckCaches(std::function<void(const char *)> log)
+{
+	CheckPatchRegionCaches<RailRegionPolicy>("Rail region", log);
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file rail_regions.h Handles dividing the rail network in the map into regions to assist hierarchical pathfinding. */
+
+#ifndef RAIL_REGIONS_H
+#define RAIL_REGIONS_H
+
+#include "region_patches.h"
+
+using TRailRegionPatchLabel = TRegionPatchLabel;
+using TRailRegionIndex = TRegionIndex;
+
+constexpr uint32_t RAIL_REGION_EDGE_LENGTH = REGION_EDGE_LENGTH;
+
+constexpr TRailRegionPatchLabel INVALID_RAIL_REGION_PATCH = INVALID_REGION_PATCH;
+
+/**
+ * Describes a single interconnected patch of track within a particular rail region.
+ */
+using RailRegionPatchDesc = RegionPatchDesc;
+
+TRailRegionIndex GetRailRegionIndex(TileIndex tile);
+TRailRegionIndex GetRailRegionIndex(const RailRegionPatchDesc &rail_region_patch);
+
+uint32_t CalculateRailRegionPatchHash(const RailRegionPatchDesc &rail_region_patch);
+
+RailRegionPatchDesc GetRailRegionPatchInfo(TileIndex tile);
+
+void InvalidateRailRegion(TileIndex tile);
+void InvalidateAllRailRegions();
+
+using TVisitRailRegionPatchCallBack = TVisitRegionPatchCallBack;
+void VisitRailRegionPatchNeighbors(const RailRegionPatchDesc &rail_region_patch, const TVisitRailRegionPatchCallBack &callback);
+void VisitRailRegionNeighborhood(const RailRegionPatchDesc &rail_region_patch, std::function<void(TRailRegionIndex)> callback);
+
+void InitializeRailRegions();
+
+#endif /* RAIL_REGIONS_H */
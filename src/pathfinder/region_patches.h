@@ -0,0 +1,66 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file region_patches.h Types shared by the water and rail regions, which divide the map into square regions of interconnected patches. */
+
+#ifndef REGION_PATCHES_H
+#define REGION_PATCHES_H
+
+#include "tile_type.h"
+#include "map_func.h"
+
+#include <functional>
+
+using TRegionPatchLabel = uint8_t;
+using TRegionIndex = uint32_t;
+
+constexpr uint32_t REGION_EDGE_LENGTH = 16;
+constexpr uint32_t REGION_EDGE_LENGTH_LOG = 4;
+static_assert(1 << REGION_EDGE_LENGTH_LOG == REGION_EDGE_LENGTH);
+
+constexpr uint32_t REGION_EDGE_MASK = REGION_EDGE_LENGTH - 1;
+static_assert((REGION_EDGE_LENGTH & REGION_EDGE_MASK) == 0);
+
+constexpr uint32_t REGION_NUMBER_OF_TILES = REGION_EDGE_LENGTH * REGION_EDGE_LENGTH;
+
+constexpr TRegionPatchLabel INVALID_REGION_PATCH = 0;
+
+/**
+ * Describes a single interconnected patch within a particular region.
+ */
+struct RegionPatchDesc
+{
+	uint32_t x; ///< The X coordinate of the region, i.e. X=2 is the 3rd region along the X-axis
+	uint32_t y; ///< The Y coordinate of the region, i.e. Y=2 is the 3rd region along the Y-axis
+	TRegionPatchLabel label; ///< Unique label identifying the patch within the region
+
+	bool operator==(const RegionPatchDesc &other) const { return x == other.x && y == other.y && label == other.label; }
+	bool operator!=(const RegionPatchDesc &other) const { return !(*this == other); }
+};
+
+using TVisitRegionPatchCallBack = std::function<void(const RegionPatchDesc &)>;
+
+inline uint32_t GetRegionX(TileIndex tile) { return TileX(tile) / REGION_EDGE_LENGTH; }
+inline uint32_t GetRegionY(TileIndex tile) { return TileY(tile) / REGION_EDGE_LENGTH; }
+
+inline uint32_t GetRegionMapSizeX() { return MapSizeX() / REGION_EDGE_LENGTH; }
+inline uint32_t GetRegionMapSizeY() { return MapSizeY() / REGION_EDGE_LENGTH; }
+
+inline TRegionIndex GetRegionIndex(uint32_t region_x, uint32_t region_y) { return (region_y << (MapLogX() - REGION_EDGE_LENGTH_LOG)) + region_x; }
+inline TRegionIndex GetRegionIndex(TileIndex tile) { return GetRegionIndex(GetRegionX(tile), GetRegionY(tile)); }
+
+/**
+ * Calculates a number that uniquely identifies the provided region patch.
+ * @param region_patch The region patch to calculate the hash for.
+ */
+inline uint32_t CalculateRegionPatchHash(const RegionPatchDesc &region_patch)
+{
+	static_assert(sizeof(TRegionPatchLabel) == sizeof(byte));
+	return region_patch.label | GetRegionIndex(region_patch.x, region_patch.y) << 8;
+}
+
+#endif /* REGION_PATCHES_H */
@@ -0,0 +1,488 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file region_patches_graph.hpp Template functions for labelling the patches of square regions and visiting their neighbours, shared by the water and rail regions. */
+
+#ifndef REGION_PATCHES_GRAPH_HPP
+#define REGION_PATCHES_GRAPH_HPP
+
+#include "region_patches.h"
+#include "debug_fmt.h"
+#include "string_func.h"
+#include "track_func.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using TRegionTraversabilityBits = uint16_t;
+constexpr TRegionPatchLabel FIRST_REGION_LABEL = 1;
+constexpr TRegionPatchLabel LAST_REGION_LABEL = UINT8_MAX;
+
+static_assert(sizeof(TRegionTraversabilityBits) * 8 == REGION_EDGE_LENGTH);
+
+struct RegionTileIterator {
+	uint32_t x;
+	uint32_t y;
+
+	inline TileIndex operator *() const
+	{
+		return TileXY(this->x, this->y);
+	}
+
+	inline bool operator ==(const RegionTileIterator &other) const { return this->x == other.x && this->y == other.y; }
+	inline bool operator !=(const RegionTileIterator &other) const { return !(*this == other); }
+
+	RegionTileIterator& operator ++()
+	{
+		this->x++;
+		if ((this->x & REGION_EDGE_MASK) == 0)  {
+			/* reached end of row */
+			this->x -= REGION_EDGE_LENGTH;
+			this->y++;
+		}
+		return *this;
+	}
+};
+
+using TRegionPatchLabelArray = std::array<TRegionPatchLabel, REGION_NUMBER_OF_TILES>;
+
+/**
+ * Represents a square section of the map of a fixed size. Within this square individual unconnected patches are
+ * identified using a Connected Component Labeling (CCL) algorithm. Note that all information stored in this class applies
+ * only to tiles within the square section, there is no knowledge about the rest of the map. This makes it easy to invalidate
+ * and update a region if any changes are made to it, such as construction or terraforming.
+ */
+class PatchRegion
+{
+	template <class Tpolicy> friend class PatchRegionReferenceT;
+
+	std::array<TRegionTraversabilityBits, DIAGDIR_END> edge_traversability_bits{};
+	bool initialized = false;
+	bool has_cross_region_links = false;
+	TRegionPatchLabel number_of_patches = 0; // 0 = no patches, 1 = one single patch, etc...
+	std::unique_ptr<TRegionPatchLabelArray> tile_patch_labels;
+
+public:
+	void Invalidate() { this->initialized = false; }
+};
+
+/**
+ * Reference to a PatchRegion, together with its location.
+ * @tparam Tpolicy Provides the regions and decides which tiles are connected, with the static functions:
+ *   - PatchRegion &GetRegion(TRegionIndex index): the region with the given index.
+ *   - TrackdirBits GetTrackdirs(TileIndex tile): the trackdirs of the tile, tiles without any are not part of a patch.
+ *   - TileIndex FollowTrackdir(TileIndex tile, Trackdir td, bool &is_link): the tile reached by leaving the tile along
+ *     the trackdir, or INVALID_TILE. is_link is set when a bridge, tunnel or aqueduct leads directly to that tile.
+ *   - TileIndex GetLinkOtherEnd(TileIndex tile): the other end of the bridge, tunnel or aqueduct at the tile, or INVALID_TILE.
+ */
+template <class Tpolicy>
+class PatchRegionReferenceT {
+	static inline std::unique_ptr<TRegionPatchLabelArray> spare_labels;
+
+	const uint32_t tile_x;
+	const uint32_t tile_y;
+	PatchRegion &pr;
+
+	inline bool ContainsTile(TileIndex tile) const
+	{
+		const uint32_t x = TileX(tile);
+		const uint32_t y = TileY(tile);
+		return x >= this->tile_x && x < this->tile_x + REGION_EDGE_LENGTH
+				&& y >= this->tile_y && y < this->tile_y + REGION_EDGE_LENGTH;
+	}
+
+	/**
+	 * Returns the local index of the tile within the region. The N corner represents 0,
+	 * the x direction is positive in the SW direction, and Y is positive in the SE direction.
+	 * @param tile Tile within the region.
+	 * @returns The local index.
+	 */
+	inline int GetLocalIndex(TileIndex tile) const
+	{
+		dbg_assert(this->ContainsTile(tile));
+		return (TileX(tile) - this->tile_x) + REGION_EDGE_LENGTH * (TileY(tile) - this->tile_y);
+	}
+
+	inline bool HasNonMatchingPatchLabel(TRegionPatchLabel expected_label) const
+	{
+		for (TRegionPatchLabel label : *this->pr.tile_patch_labels) {
+			if (label != expected_label) return true;
+		}
+		return false;
+	}
+
+public:
+	PatchRegionReferenceT(uint32_t region_x, uint32_t region_y)
+		: tile_x(region_x * REGION_EDGE_LENGTH), tile_y(region_y * REGION_EDGE_LENGTH), pr(Tpolicy::GetRegion(GetRegionIndex(region_x, region_y)))
+	{}
+
+	RegionTileIterator begin() const { return { this->tile_x, this->tile_y }; }
+	RegionTileIterator end() const { return { this->tile_x, this->tile_y + REGION_EDGE_LENGTH }; }
+
+	bool IsInitialized() const { return this->pr.initialized; }
+
+	void Invalidate() { this->pr.initialized = false; }
+
+	/**
+	 * Returns a set of bits indicating whether an edge tile on a particular side is traversable or not. These
+	 * values can be used to determine whether a vehicle can enter/leave the region through a particular edge tile.
+	 * @see GetLocalIndex() for a description of the coordinate system used.
+	 * @param side Which side of the region we want to know the edge traversability of.
+	 * @returns A value holding the edge traversability bits.
+	 */
+	TRegionTraversabilityBits GetEdgeTraversabilityBits(DiagDirection side) const { return this->pr.edge_traversability_bits[side]; }
+
+	/**
+	 * @returns The amount of individual patches present within the region. A value of
+	 * 0 means there is nothing traversable in the region at all.
+	 */
+	int NumberOfPatches() const { return this->pr.number_of_patches; }
+
+	/**
+	 * @returns Whether the region contains bridges, tunnels or aqueducts that cross the region boundaries.
+	 */
+	bool HasCrossRegionLinks() const { return this->pr.has_cross_region_links; }
+
+	/**
+	 * Returns the patch label that was assigned to the tile.
+	 * @param tile The tile of which we want to retrieve the label.
+	 * @returns The label assigned to the tile.
+	 */
+	TRegionPatchLabel GetLabel(TileIndex tile) const
+	{
+		dbg_assert(this->ContainsTile(tile));
+		if (this->pr.tile_patch_labels == nullptr) {
+			return this->NumberOfPatches() == 0 ? INVALID_REGION_PATCH : FIRST_REGION_LABEL;
+		}
+		return (*this->pr.tile_patch_labels)[this->GetLocalIndex(tile)];
+	}
+
+	/**
+	 * Performs the connected component labeling and other data gathering.
+	 * @see PatchRegion
+	 */
+	void ForceUpdate()
+	{
+		this->pr.has_cross_region_links = false;
+
+		if (this->pr.tile_patch_labels == nullptr) {
+			if (spare_labels != nullptr) {
+				this->pr.tile_patch_labels = std::move(spare_labels);
+			} else {
+				this->pr.tile_patch_labels = std::make_unique<TRegionPatchLabelArray>();
+			}
+		}
+
+		this->pr.tile_patch_labels->fill(INVALID_REGION_PATCH);
+		this->pr.edge_traversability_bits.fill(0);
+
+		TRegionPatchLabel current_label = FIRST_REGION_LABEL;
+		TRegionPatchLabel highest_assigned_label = 0;
+
+		/* Perform connected component labeling. This uses a flooding algorithm that expands until no
+		 * additional tiles can be added. Only tiles inside the region are considered. */
+		for (const TileIndex start_tile : *this) {
+			static std::vector<TileIndex> tiles_to_check;
+			tiles_to_check.clear();
+			tiles_to_check.push_back(start_tile);
+
+			if (!this->pr.has_cross_region_links) {
+				const TileIndex other_end = Tpolicy::GetLinkOtherEnd(start_tile);
+				if (other_end != INVALID_TILE && !this->ContainsTile(other_end)) this->pr.has_cross_region_links = true;
+			}
+
+			bool increase_label = false;
+			while (!tiles_to_check.empty()) {
+				const TileIndex tile = tiles_to_check.back();
+				tiles_to_check.pop_back();
+
+				const TrackdirBits valid_dirs = Tpolicy::GetTrackdirs(tile);
+				if (valid_dirs == TRACKDIR_BIT_NONE) continue;
+
+				TRegionPatchLabel &tile_patch = (*this->pr.tile_patch_labels)[GetLocalIndex(tile)];
+				if (tile_patch != INVALID_REGION_PATCH) continue;
+
+				tile_patch = current_label;
+				highest_assigned_label = current_label;
+				increase_label = true;
+
+				for (const Trackdir dir : SetTrackdirBitIterator(valid_dirs)) {
+					bool is_link = false;
+					const TileIndex new_tile = Tpolicy::FollowTrackdir(tile, dir, is_link);
+					if (new_tile == INVALID_TILE) continue;
+
+					if (this->ContainsTile(new_tile)) {
+						tiles_to_check.push_back(new_tile);
+					} else if (!is_link) {
+						assert(DistanceManhattan(new_tile, tile) == 1);
+						const auto side = DiagdirBetweenTiles(tile, new_tile);
+						const int local_x_or_y = DiagDirToAxis(side) == AXIS_X ? TileY(tile) - this->tile_y : TileX(tile) - this->tile_x;
+						SetBit(this->pr.edge_traversability_bits[side], local_x_or_y);
+					} else {
+						this->pr.has_cross_region_links = true;
+					}
+				}
+			}
+
+			/* Labels are a byte, in the (unlikely) case of running out of labels the remaining patches share the last one. */
+			if (increase_label && current_label != LAST_REGION_LABEL) current_label++;
+		}
+
+		this->pr.number_of_patches = highest_assigned_label;
+		this->pr.initialized = true;
+
+		if (this->pr.number_of_patches == 0 || (this->pr.number_of_patches == 1 && !this->HasNonMatchingPatchLabel(FIRST_REGION_LABEL))) {
+			/* No need for patch storage: trivial cases */
+			spare_labels = std::move(this->pr.tile_patch_labels);
+		}
+	}
+
+	/**
+	 * Updates the patch labels and other data, but only if the region is not yet initialized.
+	 */
+	inline void UpdateIfNotInitialized()
+	{
+		if (!this->pr.initialized) this->ForceUpdate();
+	}
+
+	inline bool HasPatchStorage() const
+	{
+		return this->pr.tile_patch_labels != nullptr;
+	}
+
+	TRegionPatchLabelArray CopyPatchLabelArray() const
+	{
+		TRegionPatchLabelArray out;
+		if (this->HasPatchStorage()) {
+			out = *this->pr.tile_patch_labels;
+		} else {
+			out.fill(this->NumberOfPatches() == 0 ? INVALID_REGION_PATCH : FIRST_REGION_LABEL);
+		}
+		return out;
+	}
+
+	void PrintDebugInfo()
+	{
+		Debug(map, 9, "Region {},{} labels and edge traversability = ...", this->tile_x / REGION_EDGE_LENGTH, this->tile_y / REGION_EDGE_LENGTH);
+
+		const size_t max_element_width = std::to_string(this->pr.number_of_patches).size();
+
+		std::array<int, 16> traversability_NW{0};
+		for (auto bitIndex : SetBitIterator(GetEdgeTraversabilityBits(DIAGDIR_NW))) *(traversability_NW.rbegin() + bitIndex) = 1;
+		Debug(map, 9, "    {:{}}", fmt::join(traversability_NW, " "), max_element_width);
+		Debug(map, 9, "  +{:->{}}+", "", REGION_EDGE_LENGTH * (max_element_width + 1) + 1);
+
+		for (uint y = 0; y < REGION_EDGE_LENGTH; ++y) {
+			std::string line{};
+			for (uint x = 0; x < REGION_EDGE_LENGTH; ++x) {
+				const auto label = this->GetLabel(TileXY(this->tile_x + x, this->tile_y + y));
+				const std::string label_str = label == INVALID_REGION_PATCH ? "." : std::to_string(label);
+				line = fmt::format("{:{}}", label_str, max_element_width) + " " + line;
+			}
+			Debug(map, 9, "{} | {}| {}", GB(this->GetEdgeTraversabilityBits(DIAGDIR_SW), y, 1), line, GB(this->GetEdgeTraversabilityBits(DIAGDIR_NE), y, 1));
+		}
+
+		Debug(map, 9, "  +{:->{}}+", "", REGION_EDGE_LENGTH * (max_element_width + 1) + 1);
+		std::array<int, 16> traversability_SE{0};
+		for (auto bitIndex : SetBitIterator(this->GetEdgeTraversabilityBits(DIAGDIR_SE))) *(traversability_SE.rbegin() + bitIndex) = 1;
+		Debug(map, 9, "    {:{}}", fmt::join(traversability_SE, " "), max_element_width);
+	}
+};
+
+/**
+ * Returns a reference to the region, after updating it if it is not yet initialized.
+ * @param region_x The X coordinate of the region.
+ * @param region_y The Y coordinate of the region.
+ */
+template <class Tpolicy>
+PatchRegionReferenceT<Tpolicy> GetUpdatedPatchRegion(uint32_t region_x, uint32_t region_y)
+{
+	PatchRegionReferenceT<Tpolicy> ref(region_x, region_y);
+	ref.UpdateIfNotInitialized();
+	return ref;
+}
+
+/**
+ * Returns region patch information for the provided tile, updating the region if necessary.
+ * @param tile The tile for which the information will be calculated.
+ */
+template <class Tpolicy>
+RegionPatchDesc GetRegionPatchInfo(TileIndex tile)
+{
+	const uint32_t x = GetRegionX(tile);
+	const uint32_t y = GetRegionY(tile);
+	return RegionPatchDesc{ x, y, GetUpdatedPatchRegion<Tpolicy>(x, y).GetLabel(tile) };
+}
+
+inline TileIndex GetRegionEdgeTile(uint32_t region_x, uint32_t region_y, DiagDirection side, uint32_t x_or_y)
+{
+	assert(x_or_y < REGION_EDGE_LENGTH);
+	const uint32_t base_x = REGION_EDGE_LENGTH * region_x;
+	const uint32_t base_y = REGION_EDGE_LENGTH * region_y;
+	switch (side) {
+		case DIAGDIR_NE: return TileXY(base_x, base_y + x_or_y);
+		case DIAGDIR_SW: return TileXY(base_x + REGION_EDGE_MASK, base_y + x_or_y);
+		case DIAGDIR_NW: return TileXY(base_x + x_or_y, base_y);
+		case DIAGDIR_SE: return TileXY(base_x + x_or_y, base_y + REGION_EDGE_MASK);
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Calls the provided callback function for all region patches
+ * accessible from one particular side of the starting patch.
+ * @param region_patch Patch within the region to start searching from
+ * @param side Side of the region to look for neighbouring patches
+ * @param func The function that will be called for each neighbour that is found
+ */
+template <class Tpolicy>
+void VisitAdjacentRegionPatchNeighbors(const RegionPatchDesc &region_patch, DiagDirection side, const TVisitRegionPatchCallBack &func)
+{
+	const PatchRegionReferenceT<Tpolicy> current_region = GetUpdatedPatchRegion<Tpolicy>(region_patch.x, region_patch.y);
+
+	const TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+	/* Unsigned underflow is allowed here, not UB */
+	const uint32_t nx = region_patch.x + (uint32_t)offset.x;
+	const uint32_t ny = region_patch.y + (uint32_t)offset.y;
+
+	if (nx >= GetRegionMapSizeX() || ny >= GetRegionMapSizeY()) return;
+
+	const PatchRegionReferenceT<Tpolicy> neighboring_region = GetUpdatedPatchRegion<Tpolicy>(nx, ny);
+	const DiagDirection opposite_side = ReverseDiagDir(side);
+
+	/* Indicates via which local x or y coordinates (depends on the "side" parameter) we can cross over into the adjacent region. */
+	const TRegionTraversabilityBits traversability_bits = current_region.GetEdgeTraversabilityBits(side)
+		& neighboring_region.GetEdgeTraversabilityBits(opposite_side);
+	if (traversability_bits == 0) return;
+
+	if (current_region.NumberOfPatches() == 1 && neighboring_region.NumberOfPatches() == 1) {
+		func(RegionPatchDesc{ nx, ny, FIRST_REGION_LABEL }); // No further checks needed because we know there is just one patch for both adjacent regions
+		return;
+	}
+
+	/* Multiple patches can be reached from the current patch. Check each edge tile individually. */
+	static std::vector<TRegionPatchLabel> unique_labels; // static and vector-instead-of-map for performance reasons
+	unique_labels.clear();
+	for (uint32_t x_or_y = 0; x_or_y < REGION_EDGE_LENGTH; ++x_or_y) {
+		if (!HasBit(traversability_bits, x_or_y)) continue;
+
+		const TileIndex current_edge_tile = GetRegionEdgeTile(region_patch.x, region_patch.y, side, x_or_y);
+		if (current_region.GetLabel(current_edge_tile) != region_patch.label) continue;
+
+		const TileIndex neighbor_edge_tile = GetRegionEdgeTile(nx, ny, opposite_side, x_or_y);
+		const TRegionPatchLabel neighbor_label = neighboring_region.GetLabel(neighbor_edge_tile);
+		assert(neighbor_label != INVALID_REGION_PATCH);
+		if (std::find(unique_labels.begin(), unique_labels.end(), neighbor_label) == unique_labels.end()) unique_labels.push_back(neighbor_label);
+	}
+	for (TRegionPatchLabel unique_label : unique_labels) func(RegionPatchDesc{ nx, ny, unique_label });
+}
+
+/**
+ * Calls the provided callback function on all accessible region patches in
+ * each cardinal direction, plus any others that are reachable via bridges, tunnels or aqueducts.
+ * @param region_patch Patch within the region to start searching from
+ * @param callback The function that will be called for each accessible patch that is found
+ */
+template <class Tpolicy>
+void VisitRegionPatchNeighbors(const RegionPatchDesc &region_patch, const TVisitRegionPatchCallBack &callback)
+{
+	if (region_patch.label == INVALID_REGION_PATCH) return;
+
+	const PatchRegionReferenceT<Tpolicy> current_region = GetUpdatedPatchRegion<Tpolicy>(region_patch.x, region_patch.y);
+
+	/* Visit adjacent region patches in each cardinal direction */
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) VisitAdjacentRegionPatchNeighbors<Tpolicy>(region_patch, side, callback);
+
+	/* Visit neighbouring patches accessible via cross-region links */
+	if (current_region.HasCrossRegionLinks()) {
+		const TRegionIndex index = GetRegionIndex(region_patch.x, region_patch.y);
+		for (const TileIndex tile : current_region) {
+			const TileIndex other_end_tile = Tpolicy::GetLinkOtherEnd(tile);
+			if (other_end_tile == INVALID_TILE || current_region.GetLabel(tile) != region_patch.label) continue;
+			if (GetRegionIndex(other_end_tile) != index) callback(GetRegionPatchInfo<Tpolicy>(other_end_tile));
+		}
+	}
+}
+
+/**
+ * Calls the provided function with the index of the region containing the tile, and with the index of each
+ * adjacent region whose edge traversability depends on the tile. This is what has to be invalidated when the tile changes.
+ * @param tile The tile.
+ * @param func The function that will be called for each region index.
+ */
+template <class F>
+void ForEachRegionAffectedByTile(TileIndex tile, F func)
+{
+	const TRegionIndex region = GetRegionIndex(tile);
+	func(region);
+
+	/* When updating a region we look into the first tile of adjacent regions to determine edge traversability.
+	 * This means that if we invalidate any region edge tiles we might also change the traversability
+	 * of the adjacent region. */
+	const uint x = TileX(tile);
+	const uint y = TileY(tile);
+	if ((x & REGION_EDGE_MASK) ==                0 && x >         0) func(region - 1);
+	if ((x & REGION_EDGE_MASK) == REGION_EDGE_MASK && x < MapMaxX()) func(region + 1);
+	if ((y & REGION_EDGE_MASK) ==                0 && y >         0) func(region - GetRegionMapSizeX());
+	if ((y & REGION_EDGE_MASK) == REGION_EDGE_MASK && y < MapMaxY()) func(region + GetRegionMapSizeX());
+}
+
+/**
+ * Check that the data of all initialized regions matches the data of a new update.
+ * @param name Name of the kind of region, for the log.
+ * @param log Optional function to also send the log lines to.
+ */
+template <class Tpolicy>
+void CheckPatchRegionCaches(const char *name, std::function<void(const char *)> log)
+{
+	char cclog_buffer[1024];
+#define CCLOG(...) { \
+	char *cc_log_pos = cclog_buffer + seprintf(cclog_buffer, lastof(cclog_buffer), "%s: %u x %u to %u x %u: ", name, \
+			x * REGION_EDGE_LENGTH, y * REGION_EDGE_LENGTH, (x * REGION_EDGE_LENGTH) + REGION_EDGE_MASK, (y * REGION_EDGE_LENGTH) + REGION_EDGE_MASK); \
+	seprintf(cc_log_pos, lastof(cclog_buffer), __VA_ARGS__); \
+	DEBUG(desync, 0, "%s", cclog_buffer); \
+	if (log) log(cclog_buffer); \
+}
+
+	const uint32_t size_x = GetRegionMapSizeX();
+	const uint32_t size_y = GetRegionMapSizeY();
+	for (uint32_t y = 0; y < size_y; y++) {
+		for (uint32_t x = 0; x < size_x; x++) {
+			PatchRegionReferenceT<Tpolicy> pr(x, y);
+			if (!pr.IsInitialized()) continue;
+
+			const bool old_has_cross_region_links = pr.HasCrossRegionLinks();
+			const int old_number_of_patches = pr.NumberOfPatches();
+			const TRegionPatchLabelArray old_patch_labels = pr.CopyPatchLabelArray();
+			std::array<TRegionTraversabilityBits, DIAGDIR_END> old_edge_bits;
+			for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) old_edge_bits[side] = pr.GetEdgeTraversabilityBits(side);
+
+			pr.ForceUpdate();
+
+			if (old_has_cross_region_links != pr.HasCrossRegionLinks()) {
+				CCLOG("Has cross region links mismatch: %u -> %u", old_has_cross_region_links, pr.HasCrossRegionLinks());
+			}
+			if (old_number_of_patches != pr.NumberOfPatches()) {
+				CCLOG("Number of patches mismatch: %u -> %u", old_number_of_patches, pr.NumberOfPatches());
+			}
+			if (old_patch_labels != pr.CopyPatchLabelArray()) {
+				CCLOG("Patch label mismatch");
+			}
+			for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+				if (old_edge_bits[side] != pr.GetEdgeTraversabilityBits(side)) {
+					CCLOG("Edge traversability mismatch: side: %u, 0x%X -> 0x%X", side, old_edge_bits[side], pr.GetEdgeTraversabilityBits(side));
+				}
+			}
+		}
+	}
+#undef CCLOG
+}
+
+#endif /* REGION_PATCHES_GRAPH_HPP */
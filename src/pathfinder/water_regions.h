@@ -10,38 +10,22 @@
 #ifndef WATER_REGIONS_H
 #define WATER_REGIONS_H
 
-#include "tile_type.h"
-#include "map_func.h"
+#include "region_patches.h"
 
-#include <functional>
+using TWaterRegionPatchLabel = TRegionPatchLabel;
+using TWaterRegionIndex = TRegionIndex;
 
-using TWaterRegionPatchLabel = uint8_t;
-using TWaterRegionIndex = uint32_t;
+constexpr uint32_t WATER_REGION_EDGE_LENGTH = REGION_EDGE_LENGTH;
+constexpr uint32_t WATER_REGION_EDGE_LENGTH_LOG = REGION_EDGE_LENGTH_LOG;
+constexpr uint32_t WATER_REGION_EDGE_MASK = REGION_EDGE_MASK;
+constexpr uint32_t WATER_REGION_NUMBER_OF_TILES = REGION_NUMBER_OF_TILES;
 
-constexpr uint32_t WATER_REGION_EDGE_LENGTH = 16;
-constexpr uint32_t WATER_REGION_EDGE_LENGTH_LOG = 4;
-static_assert(1 << WATER_REGION_EDGE_LENGTH_LOG == WATER_REGION_EDGE_LENGTH);
-
-constexpr uint32_t WATER_REGION_EDGE_MASK = WATER_REGION_EDGE_LENGTH - 1;
-static_assert((WATER_REGION_EDGE_LENGTH & WATER_REGION_EDGE_MASK) == 0);
-
-constexpr uint32_t WATER_REGION_NUMBER_OF_TILES = WATER_REGION_EDGE_LENGTH * WATER_REGION_EDGE_LENGTH;
-
-constexpr TWaterRegionPatchLabel INVALID_WATER_REGION_PATCH = 0;
+constexpr TWaterRegionPatchLabel INVALID_WATER_REGION_PATCH = INVALID_REGION_PATCH;
 
 /**
  * Describes a single interconnected patch of water within a particular water region.
  */
-struct WaterRegionPatchDesc
-{
-	uint32_t x; ///< The X coordinate of the water region, i.e. X=2 is the 3rd water region along the X-axis
-	uint32_t y; ///< The Y coordinate of the water region, i.e. Y=2 is the 3rd water region along the Y-axis
-	TWaterRegionPatchLabel label; ///< Unique label identifying the patch within the region
-
-	bool operator==(const WaterRegionPatchDesc &other) const { return x == other.x && y == other.y && label == other.label; }
-	bool operator!=(const WaterRegionPatchDesc &other) const { return !(*this == other); }
-};
-
+using WaterRegionPatchDesc = RegionPatchDesc;
 
 /**
  * Describes a single square water region.
@@ -71,8 +55,8 @@ void InvalidateWaterRegion(TileIndex tile);
 void DebugInvalidateAllWaterRegions();
 void DebugInitAllWaterRegions();
 
-using TVisitWaterRegionPatchCallBack = std::function<void(const WaterRegionPatchDesc &)>;
-void VisitWaterRegionPatchNeighbors(const WaterRegionPatchDesc &water_region_patch, TVisitWaterRegionPatchCallBack &callback);
+using TVisitWaterRegionPatchCallBack = TVisitRegionPatchCallBack;
+void VisitWaterRegionPatchNeighbors(const WaterRegionPatchDesc &water_region_patch, const TVisitWaterRegionPatchCallBack &callback);
 
 void InitializeWaterRegions();
 
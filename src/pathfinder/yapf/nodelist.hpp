@@ -10,24 +10,128 @@
 #ifndef NODELIST_HPP
 #define NODELIST_HPP
 
-#include "../../misc/array.hpp"
 #include "../../misc/hashtable.hpp"
 #include "../../misc/binaryheap.hpp"
+#include "../../misc/radixheap.hpp"
+#include "../../string_func.h"
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Storage for the nodes of a single search.
+ *  Nodes are allocated in fixed size blocks, so that they never move.
+ *  When the arena is destroyed or cleared, its blocks are kept in a per-thread
+ *  pool for the next search, instead of being freed and allocated again for every search.
+ */
+template <class Titem_, uint Tblock_items_ = 1024>
+class CNodeArenaT {
+	/** Uninitialised storage for Tblock_items_ items. */
+	struct Block {
+		alignas(Titem_) std::byte data[sizeof(Titem_) * Tblock_items_];
+
+		inline Titem_ *At(uint index) { return reinterpret_cast<Titem_ *>(this->data) + index; }
+		inline const Titem_ *At(uint index) const { return reinterpret_cast<const Titem_ *>(this->data) + index; }
+	};
+
+	static constexpr size_t MAX_POOLED_BLOCKS = 16; ///< Maximum number of unused blocks kept per thread.
+
+	static inline thread_local std::vector<std::unique_ptr<Block>> s_free_blocks; ///< Unused blocks of this thread.
+
+	std::vector<std::unique_ptr<Block>> m_blocks; ///< Blocks in use, the last one may be partially filled.
+	uint m_count = 0;                             ///< Number of items constructed.
+
+public:
+	CNodeArenaT() = default;
+	CNodeArenaT(const CNodeArenaT &) = delete;
+	CNodeArenaT &operator=(const CNodeArenaT &) = delete;
+
+	~CNodeArenaT()
+	{
+		this->Clear();
+	}
+
+	/** Destroy all items, and return the blocks to the pool of this thread. */
+	void Clear()
+	{
+		if constexpr (!std::is_trivially_destructible_v<Titem_>) {
+			for (uint i = 0; i < m_count; i++) (*this)[i].~Titem_();
+		}
+		m_count = 0;
+		for (std::unique_ptr<Block> &block : m_blocks) {
+			if (s_free_blocks.size() >= MAX_POOLED_BLOCKS) break;
+			s_free_blocks.push_back(std::move(block));
+		}
+		m_blocks.clear();
+	}
+
+	/** Return number of items. */
+	inline uint Length() const
+	{
+		return m_count;
+	}
+
+	/** Allocate and construct a new item. */
+	inline Titem_ *AppendC()
+	{
+		const uint index = m_count % Tblock_items_;
+		if (index == 0) {
+			if (s_free_blocks.empty()) {
+				m_blocks.push_back(std::make_unique<Block>());
+			} else {
+				m_blocks.push_back(std::move(s_free_blocks.back()));
+				s_free_blocks.pop_back();
+			}
+		}
+		m_count++;
+		return new (m_blocks.back()->At(index)) Titem_();
+	}
+
+	/** indexed access (non-const) */
+	inline Titem_ &operator[](uint index)
+	{
+		return *m_blocks[index / Tblock_items_]->At(index % Tblock_items_);
+	}
+
+	/** indexed access (const) */
+	inline const Titem_ &operator[](uint index) const
+	{
+		return *m_blocks[index / Tblock_items_]->At(index % Tblock_items_);
+	}
+
+	/**
+	 * Helper for creating a human readable output of this data.
+	 * @param dmp The location to dump to.
+	 */
+	template <typename D> void Dump(D &dmp) const
+	{
+		dmp.WriteValue("num_items", m_count);
+		for (uint i = 0; i < m_count; i++) {
+			char name[32];
+			seprintf(name, lastof(name), "item[%d]", i);
+			dmp.WriteStructT(name, &(*this)[i]);
+		}
+	}
+};
 
 /**
  * Hash table based node list multi-container class.
  *  Implements open list, closed list and priority queue for A-star
  *  path finder.
+ *  The priority queue is CBinaryHeapT by default, CRadixHeapT may be used
+ *  for nodes with non-negative cost estimates.
  */
-template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
+template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_, template <class> class Tqueue_ = CBinaryHeapT>
 class CNodeList_HashTableT {
 public:
 	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
 	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
-	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
+	typedef CNodeArenaT<Titem_> CItemArray;                      ///< Type that we will use as item container.
 	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
 	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef Tqueue_<Titem_> CPriorityQueue;                      ///< How the priority queue will be managed.
 
 protected:
 	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
@@ -135,8 +239,7 @@ public:
 	inline Titem_ &PopOpenNode(const Key &key)
 	{
 		Titem_ &item = m_open.Pop(key);
-		uint idxPop = m_open_queue.FindIndex(item);
-		m_open_queue.Remove(idxPop);
+		m_open_queue.Remove(item);
 		return item;
 	}
 
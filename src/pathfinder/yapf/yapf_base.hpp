@@ -12,6 +12,7 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "yapf_query_log.h"
 
 /**
  * CYapfBaseT - A-star type path finder base class.
@@ -134,6 +135,7 @@ public:
 		}
 
 		const bool destination_found = (m_pBestDestNode != nullptr);
+		_yapf_search_steps += m_num_steps;
 
 		if (_debug_yapf_level >= 3) {
 			const UnitID veh_idx = (m_veh != nullptr) ? m_veh->unitnumber : 0;
@@ -237,9 +239,7 @@ public:
 
 		bool bValid = Yapf().PfCalcCost(n, &tf);
 
-		if (bCached) {
-			Yapf().PfNodeCacheFlush(n);
-		}
+		Yapf().PfNodeCacheFlush(n);
 
 		if (bValid) bValid = Yapf().PfCalcEstimate(n);
 
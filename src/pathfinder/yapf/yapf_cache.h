@@ -19,4 +19,24 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the road layout (or one-way state) of a tile has changed.
+ * @param tile the tile that is changed, or INVALID_TILE if the change is not localised
+ */
+void YapfNotifyRoadLayoutChange(TileIndex tile);
+
+/** Statistics of the segment cost caches, the rail ones are summed over all rail pathfinder types. */
+struct YapfSegmentCacheStats {
+	uint64_t hits;                 ///< Segments whose cost was reused from the cache
+	uint64_t misses;               ///< Segments whose cost had to be calculated
+	uint64_t changed_tiles;        ///< Track layout changes of single tiles which have been applied to a cache
+	uint64_t invalidated_segments; ///< Cached segments invalidated by single tile changes
+	uint64_t flushes;              ///< Times a whole cache was flushed
+};
+
+YapfSegmentCacheStats GetYapfSegmentCacheStats();
+void ResetYapfSegmentCacheStats();
+YapfSegmentCacheStats GetYapfRoadSegmentCacheStats();
+void ResetYapfRoadSegmentCacheStats();
+
 #endif /* YAPF_CACHE_H */
@@ -11,6 +11,10 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../3rdparty/robin_hood/robin_hood.h"
+#include "yapf_cache.h"
+
+#include <vector>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -91,19 +95,32 @@ public:
 
 
 /**
- * Base class for segment cost cache providers. Contains global counter
+ * Base class for segment cost cache providers. Contains the global log
  *  of track layout changes and static notification function called whenever
  *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function.
+ *  to be shared between all rail YAPF types (one shared log, one notification
+ *  function).
+ *  Changes of single tiles are applied to each cache the next time it is used,
+ *  changes which are not localised (or too many changes) flush all caches.
  */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	static const size_t MAX_CHANGED_TILES = 4096; ///< flush all caches instead of growing the change log any further
+
+	static int   s_rail_change_counter;              ///< incremented whenever all caches need to be flushed
+	static std::vector<TileIndex> s_changed_tiles;   ///< tiles changed since the last flush of all caches
+	static uint64_t s_changed_tiles_base;            ///< sequence number of the first entry of s_changed_tiles
+	static YapfSegmentCacheStats s_stats;
 
-	static void NotifyTrackLayoutChange(TileIndex, Track)
+	static void NotifyTrackLayoutChange(TileIndex tile, Track)
 	{
-		s_rail_change_counter++;
+		if (tile == INVALID_TILE || s_changed_tiles.size() >= MAX_CHANGED_TILES) {
+			s_rail_change_counter++;
+			s_changed_tiles_base += s_changed_tiles.size();
+			s_changed_tiles.clear();
+			if (tile == INVALID_TILE) return;
+		}
+		s_changed_tiles.push_back(tile);
 	}
 };
 
@@ -116,11 +133,15 @@ struct CSegmentCostCacheBase
  *  be always the same (TileIndex + DiagDirection) that represent the beginning
  *  of the segment (origin tile and exit-dir from this tile).
  *  Different CYapfCachedCostT types can share the same type of CSegmentCostCacheT.
- *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example
+ *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example.
+ *  Segments are also indexed by the tiles they cover, so that a track layout change
+ *  only invalidates the segments on or next to the changed tile. Invalidated segments
+ *  stay in the hash-map and are recalculated the next time they are used.
  */
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	static const uint C_MAX_SEGMENTS = 1 << 18; ///< flush instead of growing the heap any further
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
@@ -128,28 +149,101 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 
 	HashTable    m_map;
 	Heap         m_heap;
+	robin_hood::unordered_flat_map<TileIndex, std::vector<Tsegment *>> m_tile_index; ///< segments by covered tile, may contain already invalidated segments
+	size_t       m_tile_index_entries = 0;
+	int          m_last_change_counter = 0;
+	uint64_t     m_last_change_seq = 0;
+	bool         m_flush_pending = false; ///< the cache has grown too large, flush it before the next search
 
 	inline CSegmentCostCacheT() {}
 
-	/** flush (clear) the cache */
+	/**
+	 * Flush (clear) the cache.
+	 * This frees the segments, so it must not be called while any node refers to them, i.e. during a search.
+	 */
 	inline void Flush()
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_tile_index.clear();
+		m_tile_index_entries = 0;
+		m_flush_pending = false;
+		s_stats.flushes++;
 	}
 
 	inline Tsegment &Get(Key &key, bool *found)
 	{
 		Tsegment *item = m_map.Find(key);
 		if (item == nullptr) {
+			if (m_heap.Length() >= C_MAX_SEGMENTS) m_flush_pending = true;
 			*found = false;
 			item = new (m_heap.Append()) Tsegment(key);
 			m_map.Push(*item);
 		} else {
-			*found = true;
+			*found = item->HasCachedCost();
 		}
 		return *item;
 	}
+
+	/**
+	 * Add a newly calculated segment to the tile index.
+	 * @param segment The segment.
+	 * @param tiles The tiles covered by the segment.
+	 */
+	void RegisterSegmentTiles(Tsegment &segment, const std::vector<TileIndex> &tiles)
+	{
+		for (TileIndex tile : tiles) {
+			m_tile_index[tile].push_back(&segment);
+		}
+		m_tile_index_entries += tiles.size();
+
+		/* Repeatedly invalidated and recalculated segments leave stale entries behind, don't let them accumulate. */
+		if (m_tile_index_entries > std::max<size_t>(1 << 16, m_heap.Length() * 16)) m_flush_pending = true;
+	}
+
+	/** Invalidate all segments which cover the given tile. */
+	void InvalidateTile(TileIndex tile)
+	{
+		auto iter = m_tile_index.find(tile);
+		if (iter == m_tile_index.end()) return;
+
+		for (Tsegment *segment : iter->second) {
+			if (segment->HasCachedCost()) {
+				segment->Invalidate();
+				s_stats.invalidated_segments++;
+			}
+		}
+		m_tile_index_entries -= iter->second.size();
+		m_tile_index.erase(iter);
+	}
+
+	/**
+	 * Apply the track layout changes since the cache was last used, and do any pending flush.
+	 * This is called before a search, when no node refers to any segment.
+	 * The end of a segment depends on the tile following it, so the neighbours of each changed tile are invalidated too.
+	 */
+	void ApplyLayoutChanges()
+	{
+		const uint64_t change_seq_end = s_changed_tiles_base + s_changed_tiles.size();
+		if (m_last_change_counter != s_rail_change_counter || m_flush_pending) {
+			m_last_change_counter = s_rail_change_counter;
+			m_last_change_seq = change_seq_end;
+			Flush();
+			return;
+		}
+
+		for (uint64_t seq = m_last_change_seq; seq < change_seq_end; seq++) {
+			const TileIndex tile = s_changed_tiles[seq - s_changed_tiles_base];
+			s_stats.changed_tiles++;
+			if (m_tile_index.empty()) continue;
+			InvalidateTile(tile);
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				const TileIndex neighbour = tile + TileOffsByDiagDir(dir);
+				if (neighbour < MapSize()) InvalidateTile(neighbour);
+			}
+		}
+		m_last_change_seq = change_seq_end;
+	}
 };
 
 /**
@@ -170,6 +264,7 @@ public:
 
 protected:
 	Cache &m_global_cache;
+	CachedData *m_new_global_segment = nullptr; ///< global segment fetched without a cached cost, to be added to the tile index when flushed
 
 	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()) {};
 
@@ -181,14 +276,10 @@ protected:
 
 	inline static Cache &stGetGlobalCache()
 	{
-		static int last_rail_change_counter = 0;
 		static Cache C;
 
-		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
-		}
+		/* invalidate the parts of the cache affected by track layout changes */
+		C.ApplyLayoutChanges();
 		return C;
 	}
 
@@ -199,6 +290,7 @@ public:
 	 */
 	inline bool PfNodeCacheFetch(Node &n)
 	{
+		m_new_global_segment = nullptr;
 		if (!Yapf().CanUseGlobalCache(n)) {
 			return Tlocal::PfNodeCacheFetch(n);
 		}
@@ -206,15 +298,25 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (found) {
+			Cache::s_stats.hits++;
+		} else {
+			Cache::s_stats.misses++;
+			m_new_global_segment = &item;
+		}
 		return found;
 	}
 
 	/**
-	 * Called by YAPF to flush the cached segment cost data back into cache storage.
-	 *  Current cache implementation doesn't use that.
+	 * Called by YAPF after the cost of the node has been calculated.
+	 *  Newly calculated global segments are added to the tile index of the cache.
 	 */
-	inline void PfNodeCacheFlush(Node &)
+	inline void PfNodeCacheFlush(Node &n)
 	{
+		CachedData *segment = m_new_global_segment;
+		m_new_global_segment = nullptr;
+		if (segment == nullptr || segment != n.m_segment || !segment->HasCachedCost()) return;
+		m_global_cache.RegisterSegmentTiles(*segment, Yapf().GetSegmentTiles());
 	}
 };
 
@@ -58,6 +58,7 @@ protected:
 	int m_max_cost;
 	bool m_disable_cache;
 	std::vector<int> m_sig_look_ahead_costs;
+	std::vector<TileIndex> m_segment_tiles; ///< tiles covered by the segment calculated last, for the segment cost cache tile index
 
 public:
 	bool          m_stopped_on_first_two_way_signal;
@@ -520,7 +521,8 @@ public:
 
 		/* Do we already have a cached segment? */
 		CachedData &segment = *n.m_segment;
-		bool is_cached_segment = (segment.m_cost >= 0);
+		bool is_cached_segment = segment.HasCachedCost();
+		m_segment_tiles.clear();
 
 		int parent_cost = has_parent ? n.m_parent->m_cost : 0;
 
@@ -614,6 +616,17 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			m_segment_tiles.push_back(cur.tile);
+			if (tf->m_is_station && tf->m_tiles_skipped > 0) {
+				/* The skipped platform tiles determine the platform length. */
+				const TileIndexDiff diff = TileOffsByDiagDir(ReverseDiagDir(TrackdirToExitdir(cur.td)));
+				TileIndex skipped = cur.tile;
+				for (int i = 0; i < tf->m_tiles_skipped; i++) {
+					skipped += diff;
+					m_segment_tiles.push_back(skipped);
+				}
+			}
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -895,6 +908,12 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 	{
 		m_disable_cache = disable;
 	}
+
+	/** Tiles covered by the segment of the node whose cost was calculated last. */
+	inline const std::vector<TileIndex> &GetSegmentTiles() const
+	{
+		return m_segment_tiles;
+	}
 };
 
 #endif /* YAPF_COSTRAIL_HPP */
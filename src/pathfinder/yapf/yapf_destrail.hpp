@@ -173,6 +173,20 @@ public:
 		CYapfDestinationRailBase::SetDestination(v);
 	}
 
+	/**
+	 * Get the destination to use for the rail region corridor search.
+	 * @param[out] tile The destination tile.
+	 * @param[out] station The destination station or waypoint, or INVALID_STATION.
+	 * @return False if the destination is not a fixed location, such as the nearest depot.
+	 */
+	inline bool GetRegionCorridorDestination(TileIndex &tile, StationID &station) const
+	{
+		if (m_any_depot || m_destTile == INVALID_TILE) return false;
+		tile = m_destTile;
+		station = m_dest_station_id;
+		return true;
+	}
+
 	/** Called by YAPF to detect if node ends in the desired destination */
 	inline bool PfDetectDestination(Node &n)
 	{
@@ -92,6 +92,23 @@ struct CYapfRailSegment
 		return m_key.GetTile();
 	}
 
+	/** Has the cost of this segment been calculated? */
+	inline bool HasCachedCost() const
+	{
+		return m_cost >= 0;
+	}
+
+	/** Forget the calculated cost of this segment, it will be recalculated when next used. */
+	inline void Invalidate()
+	{
+		m_last_tile = INVALID_TILE;
+		m_last_td = INVALID_TRACKDIR;
+		m_cost = -1;
+		m_last_signal_tile = INVALID_TILE;
+		m_last_signal_td = INVALID_TRACKDIR;
+		m_end_segment_reason = ESRB_NONE;
+	}
+
 	inline CYapfRailSegment *GetHashNext()
 	{
 		return m_hash_next;
@@ -270,7 +287,7 @@ typedef CYapfRailNodeT<CYapfNodeKeyExitDir>  CYapfRailNodeExitDir;
 typedef CYapfRailNodeT<CYapfNodeKeyTrackDir> CYapfRailNodeTrackDir;
 
 /* Default NodeList types */
-typedef CNodeList_HashTableT<CYapfRailNodeExitDir , 8, 10> CRailNodeListExitDir;
-typedef CNodeList_HashTableT<CYapfRailNodeTrackDir, 8, 10> CRailNodeListTrackDir;
+typedef CNodeList_HashTableT<CYapfRailNodeExitDir , 8, 10, CRadixHeapT> CRailNodeListExitDir;
+typedef CNodeList_HashTableT<CYapfRailNodeTrackDir, 8, 10, CRadixHeapT> CRailNodeListTrackDir;
 
 #endif /* YAPF_NODE_RAIL_HPP */
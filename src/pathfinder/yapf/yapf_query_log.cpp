@@ -0,0 +1,253 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_query_log.cpp Recording and replaying of pathfinder queries, for measuring changes to the pathfinder. */
+
+#include "../../stdafx.h"
+#include "yapf_query_log.h"
+#include "../../core/endian_func.hpp"
+#include "../../date_func.h"
+#include "../../debug.h"
+#include "../../openttd.h"
+#include "../../string_func.h"
+#include "../../vehicle_base.h"
+
+#include "../../safeguards.h"
+
+YapfQueryLogMode _yapf_query_log_mode = YQLM_NONE; ///< What the query log is doing
+uint64_t _yapf_search_steps = 0;                   ///< Total number of steps of all YAPF searches, for the query log
+
+static const char YAPF_QUERY_LOG_MAGIC[8] = { 'Y', 'A', 'P', 'F', 'Q', 'L', 'O', 'G' };
+static const uint32_t YAPF_QUERY_LOG_VERSION = 1;
+
+/** A single track choice, as stored in the log. All fields are stored little endian, in this order. */
+struct YapfQueryLogRecord {
+	uint64_t state_ticks;
+	uint32_t vehicle;
+	uint32_t tile;
+	uint8_t type;
+	uint8_t enterdir;
+	uint8_t result;
+	uint8_t path_found;
+	uint32_t steps;
+	uint64_t wall_time_ns;
+
+	static constexpr size_t SIZE = 32;
+
+	/** Whether the query, not the result, is the same as another one. */
+	bool IsSameQuery(const YapfQueryLogRecord &other) const
+	{
+		return this->state_ticks == other.state_ticks && this->vehicle == other.vehicle && this->tile == other.tile &&
+				this->type == other.type && this->enterdir == other.enterdir;
+	}
+
+	void Write(uint8_t *buf) const
+	{
+		auto put = [&](auto value) {
+			for (size_t i = 0; i < sizeof(value); i++) *buf++ = (uint8_t)(value >> (i * 8));
+		};
+		put(this->state_ticks);
+		put(this->vehicle);
+		put(this->tile);
+		put(this->type);
+		put(this->enterdir);
+		put(this->result);
+		put(this->path_found);
+		put(this->steps);
+		put(this->wall_time_ns);
+	}
+
+	void Read(const uint8_t *buf)
+	{
+		auto get = [&](auto &value) {
+			value = 0;
+			for (size_t i = 0; i < sizeof(value); i++) value |= (std::remove_reference_t<decltype(value)>)(*buf++) << (i * 8);
+		};
+		get(this->state_ticks);
+		get(this->vehicle);
+		get(this->tile);
+		get(this->type);
+		get(this->enterdir);
+		get(this->result);
+		get(this->path_found);
+		get(this->steps);
+		get(this->wall_time_ns);
+	}
+};
+
+/** State of the active query log. */
+struct YapfQueryLogState {
+	FILE *file = nullptr;
+	std::string filename;
+
+	uint64_t queries = 0;          ///< Queries recorded or replayed
+	uint64_t steps = 0;            ///< Search steps of these queries
+	uint64_t wall_time_ns = 0;     ///< Time spent in these queries
+
+	/* Replay only */
+	uint64_t log_steps = 0;        ///< Search steps of the compared queries, as recorded
+	uint64_t log_wall_time_ns = 0; ///< Time spent in the compared queries, as recorded
+	uint64_t compared = 0;         ///< Queries compared with the log
+	uint64_t divergences = 0;      ///< Compared queries with a different result
+	bool stream_diverged = false;  ///< Whether the queries no longer match the log
+	bool log_ended = false;        ///< Whether the end of the log was reached
+	std::string first_divergence;  ///< Description of the first divergence
+};
+
+static YapfQueryLogState _yapf_query_log;
+
+/**
+ * Start recording or replaying pathfinder queries.
+ * @param mode YQLM_RECORD or YQLM_REPLAY.
+ * @param filename The log file.
+ * @return Whether the log file could be opened.
+ */
+bool YapfQueryLogStart(YapfQueryLogMode mode, const std::string &filename)
+{
+	YapfQueryLogStop();
+
+	FILE *f = fopen(filename.c_str(), mode == YQLM_RECORD ? "wb" : "rb");
+	if (f == nullptr) return false;
+
+	uint8_t header[sizeof(YAPF_QUERY_LOG_MAGIC) + 4] = {};
+	if (mode == YQLM_RECORD) {
+		memcpy(header, YAPF_QUERY_LOG_MAGIC, sizeof(YAPF_QUERY_LOG_MAGIC));
+		uint32_t version = TO_LE32(YAPF_QUERY_LOG_VERSION);
+		memcpy(header + sizeof(YAPF_QUERY_LOG_MAGIC), &version, 4);
+		if (fwrite(header, sizeof(header), 1, f) != 1) {
+			fclose(f);
+			return false;
+		}
+	} else {
+		uint32_t version = 0;
+		if (fread(header, sizeof(header), 1, f) == 1) memcpy(&version, header + sizeof(YAPF_QUERY_LOG_MAGIC), 4);
+		if (memcmp(header, YAPF_QUERY_LOG_MAGIC, sizeof(YAPF_QUERY_LOG_MAGIC)) != 0 || FROM_LE32(version) != YAPF_QUERY_LOG_VERSION) {
+			DEBUG(yapf, 0, "Query log: %s is not a query log of this version", filename.c_str());
+			fclose(f);
+			return false;
+		}
+	}
+
+	_yapf_query_log = {};
+	_yapf_query_log.file = f;
+	_yapf_query_log.filename = filename;
+	_yapf_query_log_mode = mode;
+	return true;
+}
+
+/**
+ * Get a description of what the query log did so far.
+ * @return The description.
+ */
+std::string YapfQueryLogStatus()
+{
+	const YapfQueryLogState &log = _yapf_query_log;
+	if (_yapf_query_log_mode == YQLM_NONE) return "Query log not active";
+
+	auto per_second = [](uint64_t queries, uint64_t ns) -> uint64_t {
+		return ns > 0 ? (queries * 1000000000) / ns : 0;
+	};
+
+	std::string out = stdstr_fmt("%s %s: " OTTD_PRINTF64U " queries, " OTTD_PRINTF64U " steps, " OTTD_PRINTF64U " us, " OTTD_PRINTF64U " queries/s",
+			_yapf_query_log_mode == YQLM_RECORD ? "Recording" : "Replaying", log.filename.c_str(),
+			log.queries, log.steps, log.wall_time_ns / 1000, per_second(log.queries, log.wall_time_ns));
+	if (_yapf_query_log_mode == YQLM_REPLAY) {
+		out += stdstr_fmt("\n  Compared: " OTTD_PRINTF64U " queries, recorded: " OTTD_PRINTF64U " steps, " OTTD_PRINTF64U " us, " OTTD_PRINTF64U " queries/s",
+				log.compared, log.log_steps, log.log_wall_time_ns / 1000, per_second(log.compared, log.log_wall_time_ns));
+		out += stdstr_fmt("\n  Divergent results: " OTTD_PRINTF64U "%s%s", log.divergences,
+				log.stream_diverged ? ", queries no longer match the log" : "", log.log_ended ? ", end of log reached" : "");
+		if (!log.first_divergence.empty()) out += "\n  First divergence: " + log.first_divergence;
+	}
+	return out;
+}
+
+/** Stop recording or replaying, and report what was done. */
+void YapfQueryLogStop()
+{
+	if (_yapf_query_log_mode == YQLM_NONE) return;
+
+	DEBUG(yapf, 0, "Query log: %s", YapfQueryLogStatus().c_str());
+	fclose(_yapf_query_log.file);
+	_yapf_query_log = {};
+	_yapf_query_log_mode = YQLM_NONE;
+}
+
+static std::string DescribeQuery(const YapfQueryLogRecord &rec)
+{
+	return stdstr_fmt("tick " OTTD_PRINTF64U ", vehicle %u (type %u), tile 0x%X, enter dir %u, result %u, path found %u",
+			rec.state_ticks, rec.vehicle, rec.type, rec.tile, rec.enterdir, rec.result, rec.path_found);
+}
+
+/**
+ * Add a query to the query log.
+ * @param v The vehicle.
+ * @param tile The tile the choice is made for.
+ * @param enterdir The direction the vehicle enters the tile in.
+ * @param result The chosen track or trackdir.
+ * @param path_found Whether a path to the destination was found.
+ * @param steps The number of search steps.
+ * @param wall_time The time taken by the query.
+ */
+void YapfQueryLogAdd(const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint8_t result, bool path_found, uint64_t steps, std::chrono::steady_clock::duration wall_time)
+{
+	/* Vehicles in the intro game are not of interest. */
+	if (_game_mode != GM_NORMAL) return;
+
+	YapfQueryLogState &log = _yapf_query_log;
+
+	YapfQueryLogRecord rec;
+	rec.state_ticks = _state_ticks.base();
+	rec.vehicle = v->index;
+	rec.tile = tile;
+	rec.type = v->type;
+	rec.enterdir = enterdir;
+	rec.result = result;
+	rec.path_found = path_found ? 1 : 0;
+	rec.steps = (uint32_t)std::min<uint64_t>(steps, UINT32_MAX);
+	rec.wall_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wall_time).count();
+
+	log.queries++;
+	log.steps += rec.steps;
+	log.wall_time_ns += rec.wall_time_ns;
+
+	uint8_t buf[YapfQueryLogRecord::SIZE];
+	if (_yapf_query_log_mode == YQLM_RECORD) {
+		rec.Write(buf);
+		if (fwrite(buf, sizeof(buf), 1, log.file) != 1) {
+			DEBUG(yapf, 0, "Query log: writing to %s failed", log.filename.c_str());
+			YapfQueryLogStop();
+		}
+		return;
+	}
+
+	if (log.stream_diverged || log.log_ended) return;
+
+	if (fread(buf, sizeof(buf), 1, log.file) != 1) {
+		log.log_ended = true;
+		DEBUG(yapf, 0, "Query log: end of log reached");
+		return;
+	}
+	YapfQueryLogRecord logged;
+	logged.Read(buf);
+
+	if (!rec.IsSameQuery(logged)) {
+		/* The game state has diverged from the recording, no later query can be compared. */
+		log.stream_diverged = true;
+		if (log.first_divergence.empty()) log.first_divergence = "query " + DescribeQuery(rec) + ", expected " + DescribeQuery(logged);
+		DEBUG(yapf, 0, "Query log: queries no longer match the log at query " OTTD_PRINTF64U, log.queries);
+		return;
+	}
+
+	log.compared++;
+	log.log_steps += logged.steps;
+	log.log_wall_time_ns += logged.wall_time_ns;
+	if (rec.result != logged.result || rec.path_found != logged.path_found) {
+		log.divergences++;
+		if (log.first_divergence.empty()) log.first_divergence = DescribeQuery(rec) + ", recorded result " + std::to_string(logged.result) + ", path found " + std::to_string(logged.path_found);
+		DEBUG(yapf, 1, "Query log: divergent result: %s, recorded result %u", DescribeQuery(rec).c_str(), logged.result);
+	}
+}
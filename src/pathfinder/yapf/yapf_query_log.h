@@ -0,0 +1,72 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_query_log.h Recording and replaying of pathfinder queries, for measuring changes to the pathfinder. */
+
+#ifndef YAPF_QUERY_LOG_H
+#define YAPF_QUERY_LOG_H
+
+#include "../../tile_type.h"
+#include "../../direction_type.h"
+#include "../../vehicle_type.h"
+
+#include <chrono>
+#include <string>
+
+/**
+ * What the query log is doing.
+ *
+ * When recording, every rail, road and ship track choice of a normal game is written to the log.
+ * When replaying, the same savegame is run again, and every track choice is compared with the next one in the log.
+ * As the game is deterministic, the queries are identical until a change to the pathfinder returns a different result.
+ */
+enum YapfQueryLogMode : uint8_t {
+	YQLM_NONE,   ///< Not active
+	YQLM_RECORD, ///< Writing queries to the log
+	YQLM_REPLAY, ///< Comparing queries with the log
+};
+
+extern YapfQueryLogMode _yapf_query_log_mode;
+extern uint64_t _yapf_search_steps;
+
+bool YapfQueryLogStart(YapfQueryLogMode mode, const std::string &filename);
+void YapfQueryLogStop();
+std::string YapfQueryLogStatus();
+
+void YapfQueryLogAdd(const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint8_t result, bool path_found, uint64_t steps, std::chrono::steady_clock::duration wall_time);
+
+/** Times a pathfinder query, and adds it to the query log when that is active. */
+class YapfQueryLogScope {
+	const Vehicle *v;
+	TileIndex tile;
+	DiagDirection enterdir;
+	uint64_t start_steps = 0;
+	std::chrono::steady_clock::time_point start_time;
+
+public:
+	YapfQueryLogScope(const Vehicle *v, TileIndex tile, DiagDirection enterdir) : v(v), tile(tile), enterdir(enterdir)
+	{
+		if (_yapf_query_log_mode != YQLM_NONE) {
+			this->start_steps = _yapf_search_steps;
+			this->start_time = std::chrono::steady_clock::now();
+		}
+	}
+
+	/**
+	 * Finish the query.
+	 * @param result The chosen track or trackdir.
+	 * @param path_found Whether a path to the destination was found.
+	 */
+	inline void Finish(uint8_t result, bool path_found)
+	{
+		if (_yapf_query_log_mode != YQLM_NONE) {
+			YapfQueryLogAdd(this->v, this->tile, this->enterdir, result, path_found, _yapf_search_steps - this->start_steps, std::chrono::steady_clock::now() - this->start_time);
+		}
+	}
+};
+
+#endif /* YAPF_QUERY_LOG_H */
@@ -14,13 +14,19 @@
 #include "yapf_node_rail.hpp"
 #include "yapf_costrail.hpp"
 #include "yapf_destrail.hpp"
+#include "yapf_rail_regions.h"
+#include "yapf_query_log.h"
+#include "../rail_regions.h"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
 #include "../../tracerestrict.h"
 #include "../../debug.h"
+#include "../../debug_settings.h"
 
 #include "../../safeguards.h"
 
+#include <optional>
+
 #if defined(UNIX) && defined(__GLIBC__)
 #include <unistd.h>
 #endif
@@ -206,9 +212,15 @@ public:
 		static std::vector<IntermediaryTraceRestrictSignalInfo> intermediary_restricted_signals;
 		intermediary_restricted_signals.clear();
 
+		/* Tiles whose reservation changed, to invalidate the cached segments over them once the reservation is complete. */
+		static std::vector<TileIndex> reserved_tiles;
+		reserved_tiles.clear();
+
 		for (Node *node = m_res_node; node->m_parent != nullptr; node = node->m_parent) {
 			const size_t intermediary_restricted_signals_current_size = intermediary_restricted_signals.size();
 			node->template IterateTiles<CYapfReserveTrack>(Yapf().GetVehicle(), Yapf(), [&](TileIndex tile, Trackdir td) -> bool {
+				reserved_tiles.push_back(tile);
+
 				/* Cheapest tests first */
 				if (IsTileType(tile, MP_RAILWAY) && HasSignals(tile) && IsRestrictedSignal(tile) && HasSignalOnTrack(tile, TrackdirToTrack(td))) {
 					const bool front_side = HasSignalOnTrackdir(tile, td);
@@ -290,7 +302,9 @@ public:
 		if (target != nullptr) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			for (TileIndex tile : reserved_tiles) {
+				CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, INVALID_TRACK);
+			}
 		}
 
 		return true;
@@ -540,13 +554,38 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	std::vector<TRailRegionIndex> m_region_corridor; ///< sorted rail regions the search is restricted to, if m_region_corridor_active
+	bool m_region_corridor_active = false;           ///< whether the search is restricted to m_region_corridor
+	bool m_region_corridor_allowed = true;           ///< whether a region corridor may be used for this search
+
 	/** to access inherited path finder */
 	inline Tpf &Yapf()
 	{
 		return *static_cast<Tpf *>(this);
 	}
 
+	/**
+	 * For long distance searches, find the region level path to the destination and restrict the search to the regions around it.
+	 * @param v The train.
+	 * @param origin_tile The tile the search starts from.
+	 */
+	void SetupRegionCorridor(const Train *v, TileIndex origin_tile)
+	{
+		m_region_corridor_active = false;
+		if (!m_region_corridor_allowed || HasChickenBit(DCBF_RAIL_REGION_NO_CORRIDOR)) return;
+
+		TileIndex dest_tile;
+		StationID dest_station;
+		if (!Yapf().GetRegionCorridorDestination(dest_tile, dest_station)) return;
+		if (DistanceManhattan(origin_tile, dest_tile) < RAIL_REGION_CORRIDOR_MIN_DISTANCE) return;
+
+		m_region_corridor_active = YapfRailFindRegionCorridor(v, origin_tile, dest_tile, dest_station, m_region_corridor);
+	}
+
 public:
+	inline bool IsRegionCorridorActive() const { return m_region_corridor_active; }
+	inline void DisallowRegionCorridor() { m_region_corridor_allowed = false; }
+
 	/**
 	 * Called by YAPF to move from the given node to the next tile. For each
 	 *  reachable trackdir on the new tile creates new node, initializes it
@@ -576,6 +615,7 @@ public:
 			}
 		}
 		if (F.Follow(old_node.GetLastTile(), old_node.GetLastTrackdir())) {
+			if (m_region_corridor_active && !IsTileInRailRegionCorridor(m_region_corridor, F.m_new_tile)) return;
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -586,24 +626,41 @@ public:
 		return 't';
 	}
 
+	/**
+	 * Choose a track using a new pathfinder instance.
+	 * If the search was restricted to a region corridor and did not find a path, it is repeated without the corridor.
+	 */
+	static Trackdir stChooseRailTrackWithFallback(std::optional<Tpf> &pf, bool disable_cache, const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest)
+	{
+		pf.emplace();
+		if (disable_cache) pf->DisableCache(true);
+		Trackdir result = pf->ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
+		if (!path_found && pf->IsRegionCorridorActive()) {
+			pf.emplace();
+			if (disable_cache) pf->DisableCache(true);
+			pf->DisallowRegionCorridor();
+			result = pf->ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
+		}
+		return result;
+	}
+
 	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest)
 	{
 		/* create pathfinder instance */
-		Tpf pf1;
+		std::optional<Tpf> pf1;
 		Trackdir result1;
 
 		if (_debug_yapfdesync_level < 1 && _debug_desync_level < 2) {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
+			result1 = stChooseRailTrackWithFallback(pf1, false, v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
 		} else {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, nullptr, nullptr);
-			Tpf pf2;
-			pf2.DisableCache(true);
-			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
+			result1 = stChooseRailTrackWithFallback(pf1, false, v, tile, enterdir, tracks, path_found, false, nullptr, nullptr);
+			std::optional<Tpf> pf2;
+			Trackdir result2 = stChooseRailTrackWithFallback(pf2, true, v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
 			if (result1 != result2) {
 				DEBUG(desync, 0, "CACHE ERROR: ChooseRailTrack() = [%d, %d]", result1, result2);
-				DumpState(pf1, pf2);
+				DumpState(*pf1, *pf2);
 			} else if (result1 != INVALID_TRACKDIR) {
-				CYapfFollowRailT::stDesyncCheck(pf1, pf2, "CACHE ERROR: ChooseRailTrack()", true);
+				CYapfFollowRailT::stDesyncCheck(*pf1, *pf2, "CACHE ERROR: ChooseRailTrack()", true);
 			}
 		}
 
@@ -619,6 +676,7 @@ public:
 		PBSTileInfo origin = FollowTrainReservation(v, nullptr, FTRF_OKAY_UNUSED);
 		Yapf().SetOrigin(origin.tile, origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
 		Yapf().SetDestination(v);
+		this->SetupRegionCorridor(v, origin.tile);
 
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
@@ -743,8 +801,11 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 		pfnChooseRailTrack = &CYapfRail2::stChooseRailTrack; // Trackdir, forbid 90-deg
 	}
 
+	YapfQueryLogScope log_scope(v, tile, enterdir);
 	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
-	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
+	Track track = (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
+	log_scope.Finish(track, path_found);
+	return track;
 }
 
 bool YapfTrainCheckReverse(const Train *v)
@@ -856,12 +917,32 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
+/** if the whole segment cost cache needs to be invalidated, this counter is incremented */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+/** tiles whose track layout changed, the segments over these are invalidated */
+std::vector<TileIndex> CSegmentCostCacheBase::s_changed_tiles;
+uint64_t CSegmentCostCacheBase::s_changed_tiles_base = 0;
+YapfSegmentCacheStats CSegmentCostCacheBase::s_stats = {};
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	FlushSignalSegmentCache();
+	if (tile == INVALID_TILE) {
+		InvalidateAllRailRegions();
+	} else {
+		InvalidateRailRegion(tile);
+	}
+}
+
+YapfSegmentCacheStats GetYapfSegmentCacheStats()
+{
+	return CSegmentCostCacheBase::s_stats;
+}
+
+void ResetYapfSegmentCacheStats()
+{
+	CSegmentCostCacheBase::s_stats = {};
 }
 
 void YapfCheckRailSignalPenalties()
@@ -0,0 +1,106 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file yapf_rail_regions.cpp Implementation of YAPF for rail regions, which are used to restrict long distance train searches to a corridor. */
+
+#include "../../stdafx.h"
+#include "../../train.h"
+#include "../../station_base.h"
+#include "../../waypoint_base.h"
+#include "../../core/math_func.hpp"
+
+#include "yapf.hpp"
+#include "yapf_regions.hpp"
+#include "yapf_rail_regions.h"
+#include "../rail_regions.h"
+
+#include "../../safeguards.h"
+
+/** YAPF node following for rail region pathfinding. */
+template <class Types>
+class CYapfFollowRailRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;                     ///< The pathfinder class (derived from THIS class).
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node;        ///< This will be our node type.
+	typedef typename Node::Key Key;                      ///< Key to hash tables.
+
+protected:
+	inline Tpf &Yapf() { return *static_cast<Tpf*>(this); }
+
+public:
+	inline void PfFollowNode(Node &old_node)
+	{
+		TVisitRailRegionPatchCallBack visitFunc = [&](const RailRegionPatchDesc &rail_region_patch)
+		{
+			Node &node = Yapf().CreateNewNode();
+			node.Set(&old_node, rail_region_patch);
+			Yapf().AddNewNode(node, TrackFollower{});
+		};
+		VisitRailRegionPatchNeighbors(old_node.m_key.m_region_patch, visitFunc);
+	}
+
+	inline char TransportTypeChar() const { return '#'; }
+
+	static bool FindRegionCorridor(const Train *v, TileIndex start_tile, TileIndex dest_tile, StationID dest_station, std::vector<TRailRegionIndex> &corridor)
+	{
+		corridor.clear();
+
+		const RailRegionPatchDesc start_rail_region_patch = GetRailRegionPatchInfo(start_tile);
+		if (start_rail_region_patch.label == INVALID_RAIL_REGION_PATCH) return false;
+
+		Tpf pf(GetRegionPatchSearchMaxNodes());
+
+		/* Search backwards from the destination patches to the start patch, so that the best node chain leads from the start to the destination. */
+		pf.SetDestination(start_rail_region_patch);
+
+		const BaseStation *st = (dest_station != INVALID_STATION) ? BaseStation::GetIfValid(dest_station) : nullptr;
+		if (st != nullptr) {
+			TileArea tile_area;
+			st->GetTileArea(&tile_area, Waypoint::IsExpected(st) ? STATION_WAYPOINT : STATION_RAIL);
+			for (const TileIndex tile : tile_area) {
+				if (HasStationTileRail(tile) && GetStationIndex(tile) == dest_station) pf.AddOrigin(GetRailRegionPatchInfo(tile));
+			}
+		} else if (dest_tile != INVALID_TILE) {
+			pf.AddOrigin(GetRailRegionPatchInfo(dest_tile));
+		}
+
+		if (!pf.HasAnyOrigin() || pf.HasOrigin(start_rail_region_patch)) return false;
+
+		if (!pf.FindPath(v)) return false;
+
+		for (Node *node = pf.GetBestNode(); node != nullptr; node = node->m_parent) {
+			VisitRailRegionNeighborhood(node->m_key.m_region_patch, [&](TRailRegionIndex index) {
+				corridor.push_back(index);
+			});
+		}
+		std::sort(corridor.begin(), corridor.end());
+		corridor.erase(std::unique(corridor.begin(), corridor.end()), corridor.end());
+		return true;
+	}
+};
+
+struct CYapfRegionRail : CYapfT<CYapfRegion_TypesT<CYapfRegionRail, CRegionNodeList, Train, CYapfFollowRailRegionT>>
+{
+	explicit CYapfRegionRail(int max_nodes) { m_max_search_nodes = max_nodes; }
+};
+
+/**
+ * Finds a corridor of rail regions between the start tile and the destination.
+ * The corridor consists of the regions along the best region level path, plus the regions surrounding them.
+ * @param v The train to find a corridor for.
+ * @param start_tile The tile the low level search starts from.
+ * @param dest_tile The destination tile, used when there is no destination station.
+ * @param dest_station The destination station or waypoint, or INVALID_STATION.
+ * @param[out] corridor Sorted rail region indices within the corridor.
+ * @returns True if a corridor was found.
+ */
+bool YapfRailFindRegionCorridor(const Train *v, TileIndex start_tile, TileIndex dest_tile, StationID dest_station, std::vector<TRailRegionIndex> &corridor)
+{
+	return CYapfRegionRail::FindRegionCorridor(v, start_tile, dest_tile, dest_station, corridor);
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file yapf_rail_regions.h Implementation of YAPF for rail regions, which are used to restrict long distance train searches to a corridor. */
+
+#ifndef YAPF_RAIL_REGIONS_H
+#define YAPF_RAIL_REGIONS_H
+
+#include "../../stdafx.h"
+#include "../../tile_type.h"
+#include "../../station_type.h"
+#include "../rail_regions.h"
+
+#include <algorithm>
+#include <vector>
+
+struct Train;
+
+/** Minimum manhattan distance between the start of the search and the destination before a region corridor is used. */
+constexpr uint RAIL_REGION_CORRIDOR_MIN_DISTANCE = 6 * RAIL_REGION_EDGE_LENGTH;
+
+bool YapfRailFindRegionCorridor(const Train *v, TileIndex start_tile, TileIndex dest_tile, StationID dest_station, std::vector<TRailRegionIndex> &corridor);
+
+/**
+ * Test whether a tile is within a corridor returned by YapfRailFindRegionCorridor.
+ * @param corridor The sorted corridor region indices.
+ * @param tile The tile to test.
+ * @return True if the region of the tile is within the corridor.
+ */
+inline bool IsTileInRailRegionCorridor(const std::vector<TRailRegionIndex> &corridor, TileIndex tile)
+{
+	return std::binary_search(corridor.begin(), corridor.end(), GetRailRegionIndex(tile));
+}
+
+#endif /* YAPF_RAIL_REGIONS_H */
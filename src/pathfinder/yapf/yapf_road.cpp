@@ -10,6 +10,7 @@
 #include "../../stdafx.h"
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
+#include "yapf_query_log.h"
 #include "../../roadstop_base.h"
 #include "../../vehicle_func.h"
 
@@ -26,6 +27,106 @@ const uint MAX_RV_PF_TILES = 1 << 11;
 
 const int MAX_RV_LEADER_TARGETS = 4;
 
+/** Reason for the end of a cached road segment walk at a given step. */
+enum RoadSegmentEnd : uint8_t {
+	RSE_NONE,      ///< the segment continues to the next step
+	RSE_DEPOT,     ///< the step enters a depot
+	RSE_NO_FOLLOW, ///< there is no way on from the step
+	RSE_JUNCTION,  ///< there is more than one way on from the step
+	RSE_LOOP,      ///< the way on from the step leads back to the start of the segment
+	RSE_MAX_TILES, ///< the segment length limit was reached, this step is only the last tile of the segment
+};
+
+/** One tile of a cached road segment walk. */
+struct CachedRoadSegmentStep {
+	TileIndex tile;
+	Trackdir td;
+	RoadSegmentEnd end;
+	bool slope_up;      ///< the way on from the step is uphill
+	uint tiles_skipped; ///< tunnel/bridge tiles skipped on the way on from the step
+	int max_speed;      ///< speed limit of the step
+	int min_speed;      ///< minimum speed of the step
+};
+
+/**
+ * The walk along a road segment, i.e. everything about the segment which only depends
+ * on the road layout. The costs which depend on the vehicle, its destination and the
+ * occupancy of road stops are still calculated for each search.
+ */
+struct CachedRoadSegment {
+	std::vector<CachedRoadSegmentStep> steps;
+	RoadTypes compatible_roadtypes; ///< road types the vehicle the segment was walked for can use, which decide where the walk can go
+	Owner owner;          ///< owner of the vehicle the segment was walked for
+	bool owner_dependent; ///< whether the walk passed a road stop or depot, so can differ for vehicles of other companies
+};
+
+/**
+ * Segment cache shared by all road YAPF types and all companies.
+ * Segments are keyed by their first tile, trackdir and road/tram type, and indexed by
+ * the tiles they cover or try to enter so that a change of a single tile only drops
+ * the segments which depend on it. A segment is only used for vehicles with the same
+ * compatible road types as the vehicle it was walked for, as those limit where it goes.
+ */
+struct RoadSegmentCostCache {
+	static const size_t MAX_SEGMENTS = 1 << 16; ///< flush instead of growing any further
+
+	robin_hood::unordered_flat_map<uint64_t, CachedRoadSegment> m_segments;
+	robin_hood::unordered_flat_map<TileIndex, std::vector<uint64_t>> m_tile_index; ///< segment keys by tile, may contain keys of already dropped segments
+	size_t m_tile_index_entries = 0;
+	YapfSegmentCacheStats m_stats = {};
+
+	static inline uint64_t MakeKey(TileIndex tile, Trackdir td, RoadTramType rtt)
+	{
+		return (static_cast<uint64_t>(tile) << 8) | (td << 1) | (rtt == RTT_TRAM ? 1 : 0);
+	}
+
+	void Flush()
+	{
+		if (m_segments.empty() && m_tile_index.empty()) return;
+		m_segments.clear();
+		m_tile_index.clear();
+		m_tile_index_entries = 0;
+		m_stats.flushes++;
+	}
+
+	const CachedRoadSegment *Find(uint64_t key, const RoadVehicle *v)
+	{
+		auto iter = m_segments.find(key);
+		if (iter == m_segments.end() || iter->second.compatible_roadtypes != v->compatible_roadtypes || (iter->second.owner_dependent && iter->second.owner != v->owner)) {
+			m_stats.misses++;
+			return nullptr;
+		}
+		m_stats.hits++;
+		return &iter->second;
+	}
+
+	const CachedRoadSegment &Insert(uint64_t key, CachedRoadSegment &&segment, const std::vector<TileIndex> &tiles)
+	{
+		if (m_segments.size() >= MAX_SEGMENTS || m_tile_index_entries > std::max<size_t>(1 << 16, m_segments.size() * 32)) Flush();
+
+		for (TileIndex tile : tiles) {
+			m_tile_index[tile].push_back(key);
+		}
+		m_tile_index_entries += tiles.size();
+		return m_segments[key] = std::move(segment);
+	}
+
+	void InvalidateTile(TileIndex tile)
+	{
+		m_stats.changed_tiles++;
+		auto iter = m_tile_index.find(tile);
+		if (iter == m_tile_index.end()) return;
+
+		for (uint64_t key : iter->second) {
+			m_stats.invalidated_segments += m_segments.erase(key);
+		}
+		m_tile_index_entries -= iter->second.size();
+		m_tile_index.erase(iter);
+	}
+};
+
+static RoadSegmentCostCache _road_segment_cache;
+
 template <class Types>
 class CYapfCostRoadT
 {
@@ -37,8 +138,10 @@ public:
 
 protected:
 	int m_max_cost;
+	bool m_disable_cache;
+	std::vector<TileIndex> m_segment_tiles; ///< scratch buffer for the tiles of a newly walked segment
 
-	CYapfCostRoadT() : m_max_cost(0) {};
+	CYapfCostRoadT() : m_max_cost(0), m_disable_cache(false) {};
 
 	/** to access inherited path finder */
 	Tpf &Yapf()
@@ -48,7 +151,7 @@ protected:
 		return *p;
 	}
 
-	int SlopeCost(TileIndex tile, TileIndex next_tile, Trackdir)
+	static bool IsSlopeUp(TileIndex tile, TileIndex next_tile)
 	{
 		/* height of the center of the current tile */
 		int x1 = TileX(tile) * TILE_SIZE;
@@ -60,13 +163,107 @@ protected:
 		int y2 = TileY(next_tile) * TILE_SIZE;
 		int z2 = GetSlopePixelZ(x2 + TILE_SIZE / 2, y2 + TILE_SIZE / 2, true);
 
-		if (z2 - z1 > 1) {
+		return z2 - z1 > 1;
+	}
+
+	int SlopeCost(TileIndex tile, TileIndex next_tile, Trackdir)
+	{
+		if (IsSlopeUp(tile, next_tile)) {
 			/* Slope up */
 			return Yapf().PfGetSettings().road_slope_penalty;
 		}
 		return 0;
 	}
 
+	/**
+	 * Walk along the segment starting at the given tile and trackdir until it ends,
+	 * recording everything about it which only depends on the road layout.
+	 * @param start_tile First tile of the segment.
+	 * @param start_td First trackdir of the segment.
+	 * @param[out] tiles The tiles the segment depends on.
+	 * @return The walked segment.
+	 */
+	CachedRoadSegment WalkSegment(TileIndex start_tile, Trackdir start_td, std::vector<TileIndex> &tiles)
+	{
+		const RoadVehicle *v = Yapf().GetVehicle();
+		CachedRoadSegment segment;
+		segment.compatible_roadtypes = v->compatible_roadtypes;
+		segment.owner = v->owner;
+		segment.owner_dependent = false;
+
+		uint count = 0;
+		TileIndex tile = start_tile;
+		Trackdir trackdir = start_td;
+		for (;;) {
+			CachedRoadSegmentStep &step = segment.steps.emplace_back();
+			step.tile = tile;
+			step.td = trackdir;
+			step.end = RSE_NONE;
+			step.slope_up = false;
+			step.tiles_skipped = 0;
+			step.max_speed = INT_MAX;
+			step.min_speed = 0;
+			tiles.push_back(tile);
+
+			if (IsRoadDepotTile(tile) && trackdir == DiagDirToDiagTrackdir(ReverseDiagDir(GetRoadDepotDirection(tile)))) {
+				step.end = RSE_DEPOT;
+				break;
+			}
+
+			/* The follower looks at the tile in front, whether or not it can be entered,
+			 * and road stops and depots there may not be usable by vehicles of all companies. */
+			const DiagDirection exitdir = TrackdirToExitdir(trackdir);
+			if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == exitdir) {
+				tiles.push_back(GetOtherTunnelBridgeEnd(tile));
+			} else {
+				const TileIndex next_tile = TileAddByDiagDir(tile, exitdir);
+				if (next_tile < MapSize()) {
+					tiles.push_back(next_tile);
+					if (IsBayRoadStopTile(next_tile) || IsRoadDepotTile(next_tile)) segment.owner_dependent = true;
+				}
+			}
+
+			TrackFollower F(v);
+			if (!F.Follow(tile, trackdir)) {
+				step.end = RSE_NO_FOLLOW;
+				break;
+			}
+
+			step.tiles_skipped = F.m_tiles_skipped;
+			count += F.m_tiles_skipped + 1;
+
+			if (KillFirstBit(F.m_new_td_bits) != TRACKDIR_BIT_NONE) {
+				step.end = RSE_JUNCTION;
+				break;
+			}
+
+			Trackdir new_td = (Trackdir)FindFirstBit(F.m_new_td_bits);
+			if (F.m_new_tile == start_tile && new_td == start_td) {
+				step.end = RSE_LOOP;
+				break;
+			}
+
+			step.slope_up = IsSlopeUp(tile, F.m_new_tile);
+			step.max_speed = F.GetSpeedLimit(&step.min_speed);
+
+			tile = F.m_new_tile;
+			trackdir = new_td;
+			if (count > MAX_RV_PF_TILES) {
+				CachedRoadSegmentStep &last = segment.steps.emplace_back();
+				last.tile = tile;
+				last.td = trackdir;
+				last.end = RSE_MAX_TILES;
+				last.slope_up = false;
+				last.tiles_skipped = 0;
+				last.max_speed = INT_MAX;
+				last.min_speed = 0;
+				break;
+			}
+		}
+
+		return segment;
+	}
+
 	/** return one tile cost */
 	inline int OneTileCost(TileIndex tile, Trackdir trackdir, const TrackFollower *tf)
 	{
@@ -140,12 +337,74 @@ public:
 		m_max_cost = max_cost;
 	}
 
+	void DisableCache(bool disable)
+	{
+		m_disable_cache = disable;
+	}
+
 	/**
 	 * Called by YAPF to calculate the cost from the origin to the given node.
 	 *  Calculates only the cost of given node, adds it to the parent node cost
 	 *  and stores the result into Node::m_cost member
 	 */
 	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	{
+		if (m_disable_cache) return PfCalcCostUncached(n, tf);
+
+		const RoadVehicle *v = Yapf().GetVehicle();
+		const uint64_t key = RoadSegmentCostCache::MakeKey(n.m_key.m_tile, n.m_key.m_td, GetRoadTramType(v->roadtype));
+		const CachedRoadSegment *segment = _road_segment_cache.Find(key, v);
+		if (segment == nullptr) {
+			m_segment_tiles.clear();
+			segment = &_road_segment_cache.Insert(key, WalkSegment(n.m_key.m_tile, n.m_key.m_td, m_segment_tiles), m_segment_tiles);
+		}
+
+		/* this is to handle the case where the starting tile is a junction custom bridge head,
+		 * and we have advanced across the bridge in the initial step */
+		int segment_cost = tf->m_tiles_skipped * YAPF_TILE_LENGTH;
+
+		TileIndex tile = INVALID_TILE;
+		Trackdir trackdir = INVALID_TRACKDIR;
+		int parent_cost = (n.m_parent != nullptr) ? n.m_parent->m_cost : 0;
+		int max_veh_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
+
+		/* replay the walk of the segment, the order of the checks is the same as in PfCalcCostUncached */
+		for (const CachedRoadSegmentStep &step : segment->steps) {
+			tile = step.tile;
+			trackdir = step.td;
+			if (step.end == RSE_MAX_TILES) break;
+
+			segment_cost += Yapf().OneTileCost(tile, trackdir, tf);
+
+			if (Yapf().PfDetectDestinationTile(tile, trackdir)) break;
+
+			if (m_max_cost > 0 && (parent_cost + segment_cost) > m_max_cost) {
+				return false;
+			}
+
+			if (step.end == RSE_DEPOT || step.end == RSE_NO_FOLLOW) break;
+
+			segment_cost += step.tiles_skipped * YAPF_TILE_LENGTH;
+			if (step.end == RSE_JUNCTION) break;
+			if (step.end == RSE_LOOP) return false;
+
+			if (step.slope_up) segment_cost += Yapf().PfGetSettings().road_slope_penalty;
+
+			if (step.max_speed < max_veh_speed) segment_cost += YAPF_TILE_LENGTH * (max_veh_speed - step.max_speed) * (4 + step.tiles_skipped) / max_veh_speed;
+			if (step.min_speed > max_veh_speed) segment_cost += YAPF_TILE_LENGTH * (step.min_speed - max_veh_speed);
+		}
+
+		/* save end of segment back to the node */
+		n.m_segment_last_tile = tile;
+		n.m_segment_last_td = trackdir;
+
+		/* save also tile cost */
+		n.m_cost = parent_cost + segment_cost;
+		return true;
+	}
+
+	/** Calculate the cost of the given node by following the road, without using the segment cache. */
+	inline bool PfCalcCostUncached(Node &n, const TrackFollower *tf)
 	{
 		/* this is to handle the case where the starting tile is a junction custom bridge head,
 		 * and we have advanced across the bridge in the initial step */
@@ -438,8 +697,21 @@ public:
 
 	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
 	{
-		Tpf pf;
-		return pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+		Tpf pf1;
+		Trackdir result1 = pf1.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+
+		if (_debug_yapfdesync_level > 0 || _debug_desync_level >= 2) {
+			Tpf pf2;
+			pf2.DisableCache(true);
+			bool path_found2;
+			RoadVehPathCache path_cache2;
+			Trackdir result2 = pf2.ChooseRoadTrack(v, tile, enterdir, path_found2, path_cache2);
+			if (result1 != result2 || path_found != path_found2) {
+				DEBUG(desync, 0, "CACHE ERROR: ChooseRoadTrack() = [%d, %d], vehicle: %u, tile: 0x%X", result1, result2, v->unitnumber, tile);
+			}
+		}
+
+		return result1;
 	}
 
 	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
@@ -571,8 +843,19 @@ public:
 
 	static FindDepotData stFindNearestDepot(const RoadVehicle *v, TileIndex tile, Trackdir td, int max_distance)
 	{
-		Tpf pf;
-		return pf.FindNearestDepot(v, tile, td, max_distance);
+		Tpf pf1;
+		FindDepotData result1 = pf1.FindNearestDepot(v, tile, td, max_distance);
+
+		if (_debug_yapfdesync_level > 0 || _debug_desync_level >= 2) {
+			Tpf pf2;
+			pf2.DisableCache(true);
+			FindDepotData result2 = pf2.FindNearestDepot(v, tile, td, max_distance);
+			if (result1.tile != result2.tile || result1.best_length != result2.best_length) {
+				DEBUG(desync, 0, "CACHE ERROR: FindNearestRoadDepot() = [0x%X, 0x%X], vehicle: %u", result1.tile, result2.tile, v->unitnumber);
+			}
+		}
+
+		return result1;
 	}
 
 	/**
@@ -637,8 +920,11 @@ Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDi
 		pfnChooseRoadTrack = &CYapfRoad1::stChooseRoadTrack; // Trackdir
 	}
 
+	YapfQueryLogScope log_scope(v, tile, enterdir);
 	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
-	return (td_ret != INVALID_TRACKDIR) ? td_ret : (Trackdir)FindFirstBit(trackdirs);
+	if (td_ret == INVALID_TRACKDIR) td_ret = (Trackdir)FindFirstBit(trackdirs);
+	log_scope.Finish(td_ret, path_found);
+	return td_ret;
 }
 
 FindDepotData YapfRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_distance)
@@ -661,3 +947,22 @@ FindDepotData YapfRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_dist
 
 	return pfnFindNearestDepot(v, tile, trackdir, max_distance);
 }
+
+void YapfNotifyRoadLayoutChange(TileIndex tile)
+{
+	if (tile == INVALID_TILE) {
+		_road_segment_cache.Flush();
+	} else {
+		_road_segment_cache.InvalidateTile(tile);
+	}
+}
+
+YapfSegmentCacheStats GetYapfRoadSegmentCacheStats()
+{
+	return _road_segment_cache.m_stats;
+}
+
+void ResetYapfRoadSegmentCacheStats()
+{
+	_road_segment_cache.m_stats = {};
+}
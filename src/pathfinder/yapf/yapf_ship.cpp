@@ -15,6 +15,7 @@
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
 #include "yapf_ship_regions.h"
+#include "yapf_query_log.h"
 #include "../water_regions.h"
 
 #include "../../safeguards.h"
@@ -451,8 +452,11 @@ struct CYapfShip : CYapfT<CYapfShip_TypesT<CYapfShip, CFollowTrackWater, CShipNo
 /** Ship controller helper - path finder invoker. */
 Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
 {
+	YapfQueryLogScope log_scope(v, tile, enterdir);
 	Trackdir td_ret = CYapfShip::ChooseShipTrack(v, tile, enterdir, tracks, path_found, path_cache);
-	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
+	Track track = (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
+	log_scope.Finish(track, path_found);
+	return track;
 }
 
 bool YapfShipCheckReverse(const Ship *v, Trackdir *trackdir)
@@ -12,159 +12,96 @@
 #include "../../core/math_func.hpp"
 
 #include "yapf.hpp"
+#include "yapf_regions.hpp"
 #include "yapf_ship_regions.h"
 #include "../water_regions.h"
+#include "../../3rdparty/robin_hood/robin_hood.h"
 
 #include "../../safeguards.h"
 
-constexpr int DIRECT_NEIGHBOR_COST = 100;
-constexpr int NODES_PER_REGION = 4;
-constexpr uint32_t MAX_NUMBER_OF_NODES = 65536;
+/** Key of a memoized water region path. */
+struct WaterRegionPathMemoKey {
+	uint32_t start_x;
+	uint32_t start_y;
+	uint32_t start_label;
+	uint32_t max_length;
+	uint64_t origins_hash; ///< hash of the destination patches, which are compared in full on lookup
 
-/** Yapf Node Key that represents a single patch of interconnected water within a water region. */
-struct CYapfRegionPatchNodeKey {
-	WaterRegionPatchDesc m_water_region_patch;
-
-	inline void Set(const WaterRegionPatchDesc &water_region_patch)
-	{
-		m_water_region_patch = water_region_patch;
-	}
-
-	inline uint32_t CalcHash() const { return CalculateWaterRegionPatchHash(m_water_region_patch); }
-	inline bool operator==(const CYapfRegionPatchNodeKey &other) const { return CalcHash() == other.CalcHash(); }
+	bool operator==(const WaterRegionPathMemoKey &other) const = default;
 };
 
-inline uint ManhattanDistance(const CYapfRegionPatchNodeKey &a, const CYapfRegionPatchNodeKey &b)
-{
-	return (Delta(a.m_water_region_patch.x, b.m_water_region_patch.x) + Delta(a.m_water_region_patch.y, b.m_water_region_patch.y)) * DIRECT_NEIGHBOR_COST;
-}
-
-/** Yapf Node for water regions. */
-template <class Tkey_>
-struct CYapfRegionNodeT {
-	typedef Tkey_ Key;
-	typedef CYapfRegionNodeT<Tkey_> Node;
-
-	Tkey_       m_key;
-	Node       *m_hash_next;
-	Node       *m_parent;
-	int         m_cost;
-	int         m_estimate;
-
-	inline void Set(Node *parent, const WaterRegionPatchDesc &water_region_patch)
-	{
-		m_key.Set(water_region_patch);
-		m_hash_next = nullptr;
-		m_parent = parent;
-		m_cost = 0;
-		m_estimate = 0;
-	}
-
-	inline void Set(Node *parent, const Key &key)
-	{
-		Set(parent, key.m_water_region_patch);
-	}
-
-	DiagDirection GetDiagDirFromParent() const
-	{
-		if (!m_parent) return INVALID_DIAGDIR;
-		const int dx = m_key.m_water_region_patch.x - m_parent->m_key.m_water_region_patch.x;
-		const int dy = m_key.m_water_region_patch.y - m_parent->m_key.m_water_region_patch.y;
-		if (dx > 0 && dy == 0) return DIAGDIR_SW;
-		if (dx < 0 && dy == 0) return DIAGDIR_NE;
-		if (dx == 0 && dy > 0) return DIAGDIR_SE;
-		if (dx == 0 && dy < 0) return DIAGDIR_NW;
-		return INVALID_DIAGDIR;
-	}
-
-	inline Node *GetHashNext() { return m_hash_next; }
-	inline void SetHashNext(Node *pNext) { m_hash_next = pNext; }
-	inline const Tkey_ &GetKey() const { return m_key; }
-	inline int GetCost() { return m_cost; }
-	inline int GetCostEstimate() { return m_estimate; }
-	inline bool operator<(const Node &other) const { return m_estimate < other.m_estimate; }
+/** A memoized water region path, and what it was searched from. */
+struct WaterRegionPathMemo {
+	std::vector<WaterRegionPatchDesc> origins; ///< the destination patches, which are the origins of the backwards search
+	std::vector<WaterRegionPatchDesc> path;    ///< the result of the search
 };
 
-/** YAPF origin for water regions. */
-template <class Types>
-class CYapfOriginRegionT
-{
-public:
-	typedef typename Types::Tpf Tpf;              ///< The pathfinder class (derived from THIS class).
-	typedef typename Types::NodeList::Titem Node; ///< This will be our node type.
-	typedef typename Node::Key Key;               ///< Key to hash tables.
+/**
+ * Memo of water region level paths, which many ships heading for the same dock ask for.
+ * An entry is dropped when any water region whose data the search read is invalidated,
+ * so a memoized path is always identical to the result of a new search, and the memo does
+ * not have to be saved or be the same on every client.
+ */
+struct WaterRegionPathMemoTable {
+	static const size_t MAX_ENTRIES = 4096;           ///< flush instead of growing any further
+	static const size_t MAX_INDEX_ENTRIES = 1 << 20;  ///< flush instead of growing the region index any further
 
-protected:
-	inline Tpf &Yapf() { return *static_cast<Tpf*>(this); }
+	struct KeyHash {
+		size_t operator()(const WaterRegionPathMemoKey &key) const noexcept
+		{
+			return robin_hood::hash_bytes(&key, sizeof(key));
+		}
+	};
 
-private:
-	std::vector<CYapfRegionPatchNodeKey> m_origin_keys;
+	robin_hood::unordered_flat_map<WaterRegionPathMemoKey, WaterRegionPathMemo, KeyHash> m_entries;
+	robin_hood::unordered_flat_map<TWaterRegionIndex, std::vector<WaterRegionPathMemoKey>> m_region_index; ///< entry keys by read region, may contain keys of already dropped entries
+	size_t m_region_index_entries = 0;
 
-public:
-	void AddOrigin(const WaterRegionPatchDesc &water_region_patch)
+	void Flush()
 	{
-		if (water_region_patch.label == INVALID_WATER_REGION_PATCH) return;
-		if (!HasOrigin(water_region_patch)) m_origin_keys.push_back(CYapfRegionPatchNodeKey{ water_region_patch });
+		m_entries.clear();
+		m_region_index.clear();
+		m_region_index_entries = 0;
 	}
 
-	bool HasOrigin(const WaterRegionPatchDesc &water_region_patch)
+	const WaterRegionPathMemo *Find(const WaterRegionPathMemoKey &key, const std::vector<WaterRegionPatchDesc> &origins) const
 	{
-		return std::find(m_origin_keys.begin(), m_origin_keys.end(), CYapfRegionPatchNodeKey{ water_region_patch }) != m_origin_keys.end();
+		auto iter = m_entries.find(key);
+		if (iter == m_entries.end() || iter->second.origins != origins) return nullptr;
+		return &iter->second;
 	}
 
-	void PfSetStartupNodes()
+	void Insert(const WaterRegionPathMemoKey &key, WaterRegionPathMemo &&memo, std::vector<TWaterRegionIndex> &regions)
 	{
-		for (const CYapfRegionPatchNodeKey &origin_key : m_origin_keys) {
-			Node &node = Yapf().CreateNewNode();
-			node.Set(nullptr, origin_key);
-			Yapf().AddStartupNode(node);
-		}
-	}
-};
-
-/** YAPF destination provider for water regions. */
-template <class Types>
-class CYapfDestinationRegionT
-{
-public:
-	typedef typename Types::Tpf Tpf;              ///< The pathfinder class (derived from THIS class).
-	typedef typename Types::NodeList::Titem Node; ///< This will be our node type.
-	typedef typename Node::Key Key;               ///< Key to hash tables.
-
-protected:
-	Key m_dest;
+		std::sort(regions.begin(), regions.end());
+		regions.erase(std::unique(regions.begin(), regions.end()), regions.end());
+		if (m_entries.size() >= MAX_ENTRIES || m_region_index_entries + regions.size() > MAX_INDEX_ENTRIES) Flush();
 
-public:
-	void SetDestination(const WaterRegionPatchDesc &water_region_patch)
-	{
-		m_dest.Set(water_region_patch);
+		for (TWaterRegionIndex region : regions) {
+			m_region_index[region].push_back(key);
+		}
+		m_region_index_entries += regions.size();
+		m_entries[key] = std::move(memo);
 	}
 
-protected:
-	Tpf &Yapf() { return *static_cast<Tpf*>(this); }
-
-public:
-	inline bool PfDetectDestination(Node &n) const
+	void InvalidateRegion(TWaterRegionIndex region)
 	{
-		return n.m_key == m_dest;
-	}
+		auto iter = m_region_index.find(region);
+		if (iter == m_region_index.end()) return;
 
-	inline bool PfCalcEstimate(Node &n)
-	{
-		if (PfDetectDestination(n)) {
-			n.m_estimate = n.m_cost;
-			return true;
+		for (const WaterRegionPathMemoKey &key : iter->second) {
+			m_entries.erase(key);
 		}
-
-		n.m_estimate = n.m_cost + ManhattanDistance(n.m_key, m_dest);
-
-		return true;
+		m_region_index_entries -= iter->second.size();
+		m_region_index.erase(iter);
 	}
 };
 
+static WaterRegionPathMemoTable _water_region_path_memo;
+
 /** YAPF node following for water region pathfinding. */
 template <class Types>
-class CYapfFollowRegionT
+class CYapfFollowWaterRegionT
 {
 public:
 	typedef typename Types::Tpf Tpf;                     ///< The pathfinder class (derived from THIS class).
@@ -173,18 +110,35 @@ public:
 	typedef typename Node::Key Key;                      ///< Key to hash tables.
 
 protected:
+	std::vector<TWaterRegionIndex> m_read_regions; ///< water regions whose data the search read
+
 	inline Tpf &Yapf() { return *static_cast<Tpf*>(this); }
 
+	/** Record that the data of a water region and its edges towards its neighbours were read. */
+	void AddReadRegionAndNeighbours(const WaterRegionPatchDesc &water_region_patch)
+	{
+		const uint32_t x = water_region_patch.x;
+		const uint32_t y = water_region_patch.y;
+		m_read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(x, y)));
+		if (x > 0) m_read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(x - 1, y)));
+		if (y > 0) m_read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(x, y - 1)));
+		if (x + 1 < MapSizeX() / WATER_REGION_EDGE_LENGTH) m_read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(x + 1, y)));
+		if (y + 1 < MapSizeY() / WATER_REGION_EDGE_LENGTH) m_read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(x, y + 1)));
+	}
+
 public:
 	inline void PfFollowNode(Node &old_node)
 	{
+		AddReadRegionAndNeighbours(old_node.m_key.m_region_patch);
 		TVisitWaterRegionPatchCallBack visitFunc = [&](const WaterRegionPatchDesc &water_region_patch)
 		{
+			/* Patches reached via an aqueduct can be in a region which is not adjacent to the current one. */
+			m_read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(water_region_patch)));
 			Node &node = Yapf().CreateNewNode();
 			node.Set(&old_node, water_region_patch);
 			Yapf().AddNewNode(node, TrackFollower{});
 		};
-		VisitWaterRegionPatchNeighbors(old_node.m_key.m_water_region_patch, visitFunc);
+		VisitWaterRegionPatchNeighbors(old_node.m_key.m_region_patch, visitFunc);
 	}
 
 	inline char TransportTypeChar() const { return '^'; }
@@ -193,9 +147,7 @@ public:
 	{
 		const WaterRegionPatchDesc start_water_region_patch = GetWaterRegionPatchInfo(start_tile);
 
-		/* We reserve 4 nodes (patches) per water region. The vast majority of water regions have 1 or 2 regions so this should be a pretty
-		 * safe limit. We cap the limit at 65536 which is at a region size of 16x16 is equivalent to one node per region for a 4096x4096 map. */
-		Tpf pf(std::min(static_cast<uint32_t>(MapSize() * NODES_PER_REGION) / WATER_REGION_NUMBER_OF_TILES, MAX_NUMBER_OF_NODES));
+		Tpf pf(GetRegionPatchSearchMaxNodes());
 		pf.SetDestination(start_water_region_patch);
 
 		if (v->current_order.IsType(OT_GOTO_STATION)) {
@@ -218,85 +170,41 @@ public:
 		path.reserve(max_returned_path_length);
 		if (pf.HasOrigin(start_water_region_patch)) return path;
 
-		/* Find best path. */
-		if (!pf.FindPath(v)) return {}; // Path not found.
+		/* Ships heading for the same dock from the same water region patch get the same path,
+		 * for as long as none of the water regions the search looked at change. */
+		const std::vector<WaterRegionPatchDesc> &origins = pf.GetOrigins();
+		WaterRegionPathMemoKey memo_key{ start_water_region_patch.x, start_water_region_patch.y, start_water_region_patch.label, static_cast<uint32_t>(max_returned_path_length), 0 };
+		for (const WaterRegionPatchDesc &origin : origins) {
+			memo_key.origins_hash = memo_key.origins_hash * 31 + CalculateWaterRegionPatchHash(origin);
+		}
+		const WaterRegionPathMemo *memo = _water_region_path_memo.Find(memo_key, origins);
+		if (memo != nullptr) return memo->path;
 
-		Node *node = pf.GetBestNode();
-		for (int i = 0; i < max_returned_path_length - 1; ++i) {
-			if (node != nullptr) {
-				node = node->m_parent;
-				if (node != nullptr) path.push_back(node->m_key.m_water_region_patch);
+		/* Find best path. */
+		if (!pf.FindPath(v)) {
+			path.clear(); // Path not found.
+		} else {
+			Node *node = pf.GetBestNode();
+			for (int i = 0; i < max_returned_path_length - 1; ++i) {
+				if (node != nullptr) {
+					node = node->m_parent;
+					if (node != nullptr) path.push_back(node->m_key.m_region_patch);
+				}
 			}
+			assert(!path.empty());
 		}
 
-		assert(!path.empty());
-		return path;
-	}
-};
-
-/** Cost Provider of YAPF for water regions. */
-template <class Types>
-class CYapfCostRegionT
-{
-public:
-	typedef typename Types::Tpf Tpf;              ///< The pathfinder class (derived from THIS class).
-	typedef typename Types::TrackFollower TrackFollower;
-	typedef typename Types::NodeList::Titem Node; ///< This will be our node type.
-	typedef typename Node::Key Key;               ///< Key to hash tables.
-
-protected:
-	/** To access inherited path finder. */
-	Tpf &Yapf() { return *static_cast<Tpf*>(this); }
-
-public:
-	/**
-	 * Called by YAPF to calculate the cost from the origin to the given node.
-	 * Calculates only the cost of given node, adds it to the parent node cost
-	 * and stores the result into Node::m_cost member.
-	 */
-	inline bool PfCalcCost(Node &n, const TrackFollower *)
-	{
-		n.m_cost = n.m_parent->m_cost + ManhattanDistance(n.m_key, n.m_parent->m_key);
-
-		/* Incentivise zigzagging by adding a slight penalty when the search continues in the same direction. */
-		Node *grandparent = n.m_parent->m_parent;
-		if (grandparent != nullptr) {
-			const DiagDirDiff dir_diff = DiagDirDifference(n.m_parent->GetDiagDirFromParent(), n.GetDiagDirFromParent());
-			if (dir_diff != DIAGDIRDIFF_90LEFT && dir_diff != DIAGDIRDIFF_90RIGHT) n.m_cost += 1;
+		std::vector<TWaterRegionIndex> &read_regions = pf.m_read_regions;
+		read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(start_water_region_patch)));
+		for (const WaterRegionPatchDesc &origin : origins) {
+			read_regions.push_back(GetWaterRegionIndex(WaterRegionDesc(origin)));
 		}
-
-		return true;
+		_water_region_path_memo.Insert(memo_key, { origins, path }, read_regions);
+		return path;
 	}
 };
 
-/* We don't need a follower but YAPF requires one. */
-struct DummyFollower : public CFollowTrackWater {};
-
-/**
- * Config struct of YAPF for route planning.
- * Defines all 6 base YAPF modules as classes providing services for CYapfBaseT.
- */
-template <class Tpf_, class Tnode_list>
-struct CYapfRegion_TypesT
-{
-	typedef CYapfRegion_TypesT<Tpf_, Tnode_list> Types;         ///< Shortcut for this struct type.
-	typedef Tpf_                                 Tpf;           ///< Pathfinder type.
-	typedef DummyFollower                        TrackFollower; ///< Track follower helper class
-	typedef Tnode_list                           NodeList;
-	typedef Ship                                 VehicleType;
-
-	/** Pathfinder components (modules). */
-	typedef CYapfBaseT<Types>                 PfBase;        ///< Base pathfinder class.
-	typedef CYapfFollowRegionT<Types>         PfFollow;      ///< Node follower.
-	typedef CYapfOriginRegionT<Types>         PfOrigin;      ///< Origin provider.
-	typedef CYapfDestinationRegionT<Types>    PfDestination; ///< Destination/distance provider.
-	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;       ///< Segment cost cache provider.
-	typedef CYapfCostRegionT<Types>           PfCost;        ///< Cost provider.
-};
-
-typedef CNodeList_HashTableT<CYapfRegionNodeT<CYapfRegionPatchNodeKey>, 12, 12> CRegionNodeListWater;
-
-struct CYapfRegionWater : CYapfT<CYapfRegion_TypesT<CYapfRegionWater, CRegionNodeListWater>>
+struct CYapfRegionWater : CYapfT<CYapfRegion_TypesT<CYapfRegionWater, CRegionNodeList, Ship, CYapfFollowWaterRegionT>>
 {
 	explicit CYapfRegionWater(int max_nodes) { m_max_search_nodes = max_nodes; }
 };
@@ -312,3 +220,18 @@ std::vector<WaterRegionPatchDesc> YapfShipFindWaterRegionPath(const Ship *v, Til
 {
 	return CYapfRegionWater::FindWaterRegionPath(v, start_tile, max_returned_path_length);
 }
+
+/**
+ * Drop the memoized water region paths whose search read the given water region.
+ * @param water_region The index of the water region which has been invalidated.
+ */
+void YapfShipInvalidateWaterRegionPaths(TWaterRegionIndex water_region)
+{
+	_water_region_path_memo.InvalidateRegion(water_region);
+}
+
+/** Drop all memoized water region paths. */
+void YapfShipFlushWaterRegionPaths()
+{
+	_water_region_path_memo.Flush();
+}
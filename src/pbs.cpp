@@ -830,12 +830,10 @@ struct FindTrainOnTrackInfo {
 	FindTrainOnTrackInfo() : best(nullptr) {}
 };
 
-/** Callback for Has/FindVehicleOnPos to find a train on a specific track. */
-static Vehicle *FindTrainOnTrackEnum(Vehicle *v, void *data)
+/** Visit a vehicle found by FindVehicleOnPos, when looking for a train on a specific track. */
+static void FindTrainOnTrackEnum(Vehicle *v, FindTrainOnTrackInfo *info)
 {
-	FindTrainOnTrackInfo *info = (FindTrainOnTrackInfo *)data;
-
-	if ((v->vehstatus & VS_CRASHED)) return nullptr;
+	if ((v->vehstatus & VS_CRASHED)) return;
 
 	Train *t = Train::From(v);
 	if (t->track & TRACK_BIT_WORMHOLE) {
@@ -843,7 +841,7 @@ static Vehicle *FindTrainOnTrackEnum(Vehicle *v, void *data)
 		 * Trains on the ramp/entrance itself are found though.
 		 */
 		if (IsTileType(info->res.tile, MP_TUNNELBRIDGE) && IsTunnelBridgeWithSignalSimulation(info->res.tile) && info->res.tile != TileVirtXY(t->x_pos, t->y_pos)) {
-			return nullptr;
+			return;
 		}
 	}
 	if (t->track & TRACK_BIT_WORMHOLE || HasBit((TrackBits)t->track, TrackdirToTrack(info->res.trackdir))) {
@@ -851,10 +849,7 @@ static Vehicle *FindTrainOnTrackEnum(Vehicle *v, void *data)
 
 		/* ALWAYS return the lowest ID (anti-desync!) */
 		if (info->best == nullptr || t->index < info->best->index) info->best = t;
-		return t;
 	}
-
-	return nullptr;
 }
 
 void TrainReservationLookAhead::SetNextExtendPosition()
@@ -923,7 +918,7 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res, Follo
 	ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->all_compatible_railtypes, tile, trackdir, FRF_NONE, v, nullptr);
 	ftoti.res.okay = (flags & FTRF_OKAY_UNUSED) ? false : IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
 	if (train_on_res != nullptr) {
-		FindVehicleOnPos(ftoti.res.tile, VEH_TRAIN, &ftoti, FindTrainOnTrackEnum);
+		FindVehicleOnPos(ftoti.res.tile, VEH_TRAIN, [&ftoti](Vehicle *v) { FindTrainOnTrackEnum(v, &ftoti); });
 		if (ftoti.best != nullptr) *train_on_res = ftoti.best->First();
 		if (*train_on_res == nullptr && IsRailStationTile(ftoti.res.tile)) {
 			/* The target tile is a rail station. The track follower
@@ -932,13 +927,13 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res, Follo
 			 * for a possible train. */
 			TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(ftoti.res.trackdir)));
 			for (TileIndex st_tile = ftoti.res.tile + diff; *train_on_res == nullptr && IsCompatibleTrainStationTile(st_tile, ftoti.res.tile); st_tile += diff) {
-				FindVehicleOnPos(st_tile, VEH_TRAIN, &ftoti, FindTrainOnTrackEnum);
+				FindVehicleOnPos(st_tile, VEH_TRAIN, [&ftoti](Vehicle *v) { FindTrainOnTrackEnum(v, &ftoti); });
 				if (ftoti.best != nullptr) *train_on_res = ftoti.best->First();
 			}
 		}
 		if (*train_on_res == nullptr && IsTileType(ftoti.res.tile, MP_TUNNELBRIDGE) && IsTrackAcrossTunnelBridge(ftoti.res.tile, TrackdirToTrack(ftoti.res.trackdir)) && !IsTunnelBridgeWithSignalSimulation(ftoti.res.tile)) {
 			/* The target tile is a bridge/tunnel, also check the other end tile. */
-			FindVehicleOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), VEH_TRAIN, &ftoti, FindTrainOnTrackEnum);
+			FindVehicleOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), VEH_TRAIN, [&ftoti](Vehicle *v) { FindTrainOnTrackEnum(v, &ftoti); });
 			if (ftoti.best != nullptr) *train_on_res = ftoti.best->First();
 		}
 	}
@@ -1322,14 +1317,14 @@ Train *GetTrainForReservation(TileIndex tile, Track track)
 		FindTrainOnTrackInfo ftoti;
 		ftoti.res = FollowReservation(GetTileOwner(tile), rts, tile, trackdir, FRF_IGNORE_ONEWAY, nullptr, nullptr);
 
-		FindVehicleOnPos(ftoti.res.tile, VEH_TRAIN, &ftoti, FindTrainOnTrackEnum);
+		FindVehicleOnPos(ftoti.res.tile, VEH_TRAIN, [&ftoti](Vehicle *v) { FindTrainOnTrackEnum(v, &ftoti); });
 		if (ftoti.best != nullptr) return ftoti.best;
 
 		/* Special case for stations: check the whole platform for a vehicle. */
 		if (IsRailStationTile(ftoti.res.tile)) {
 			TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(ftoti.res.trackdir)));
 			for (TileIndex st_tile = ftoti.res.tile + diff; IsCompatibleTrainStationTile(st_tile, ftoti.res.tile); st_tile += diff) {
-				FindVehicleOnPos(st_tile, VEH_TRAIN, &ftoti, FindTrainOnTrackEnum);
+				FindVehicleOnPos(st_tile, VEH_TRAIN, [&ftoti](Vehicle *v) { FindTrainOnTrackEnum(v, &ftoti); });
 				if (ftoti.best != nullptr) return ftoti.best;
 			}
 		}
@@ -1342,7 +1337,7 @@ Train *GetTrainForReservation(TileIndex tile, Track track)
 				}
 			} else {
 				/* Special case for bridges/tunnels: check the other end as well. */
-				FindVehicleOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), VEH_TRAIN, &ftoti, FindTrainOnTrackEnum);
+				FindVehicleOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), VEH_TRAIN, [&ftoti](Vehicle *v) { FindTrainOnTrackEnum(v, &ftoti); });
 			}
 			if (ftoti.best != nullptr) return ftoti.best;
 		}
@@ -1367,19 +1362,17 @@ CommandCost CheckTrainReservationPreventsTrackModification(const Train *v)
 	return CommandCost();
 }
 
-static Vehicle *TrainInTunnelBridgePreventsTrackModificationEnum(Vehicle *v, void *)
+static bool TrainInTunnelBridgePreventsTrackModification(const Vehicle *v)
 {
-	if (CheckTrainReservationPreventsTrackModification(Train::From(v)->First()).Failed()) return v;
-
-	return nullptr;
+	return CheckTrainReservationPreventsTrackModification(Train::From(v)->First()).Failed();
 }
 
 CommandCost CheckTrainInTunnelBridgePreventsTrackModification(TileIndex start, TileIndex end)
 {
 	if (_settings_game.vehicle.train_braking_model != TBM_REALISTIC) return CommandCost();
 
-	if (HasVehicleOnPos(start, VEH_TRAIN, nullptr, &TrainInTunnelBridgePreventsTrackModificationEnum) ||
-			HasVehicleOnPos(end, VEH_TRAIN, nullptr, &TrainInTunnelBridgePreventsTrackModificationEnum)) {
+	if (HasVehicleOnPos(start, VEH_TRAIN, TrainInTunnelBridgePreventsTrackModification) ||
+			HasVehicleOnPos(end, VEH_TRAIN, TrainInTunnelBridgePreventsTrackModification)) {
 		return_cmd_error(STR_ERROR_CANNOT_MODIFY_TRACK_TRAIN_APPROACHING);
 	}
 	return CommandCost();
@@ -1608,13 +1601,13 @@ bool IsWaitingPositionFree(const Train *v, TileIndex tile, Trackdir trackdir, bo
 			TileIndex other_end = GetOtherTunnelBridgeEnd(tile);
 			if (HasAcrossTunnelBridgeReservation(other_end) && GetTunnelBridgeExitSignalState(other_end) == SIGNAL_STATE_RED) return false;
 			Direction dir = DiagDirToDir(GetTunnelBridgeDirection(other_end));
-			if (HasVehicleOnPos(other_end, VEH_TRAIN, &dir, [](Vehicle *v, void *data) -> Vehicle * {
-				DirDiff diff = DirDifference(v->direction, *((Direction *) data));
-				if (diff == DIRDIFF_SAME) return v;
+			if (HasVehicleOnPos(other_end, VEH_TRAIN, [dir](const Vehicle *v) -> bool {
+				DirDiff diff = DirDifference(v->direction, dir);
+				if (diff == DIRDIFF_SAME) return true;
 				if (diff == DIRDIFF_45RIGHT || diff == DIRDIFF_45LEFT) {
-					if (GetAcrossTunnelBridgeTrackBits(v->tile) & Train::From(v)->track) return v;
+					if (GetAcrossTunnelBridgeTrackBits(v->tile) & Train::From(v)->track) return true;
 				}
-				return nullptr;
+				return false;
 			})) return false;
 		}
 		return free;
@@ -254,6 +254,7 @@ bool _mark_tile_dirty_on_road_cache_one_way_state_update = false;
 
 static void RefreshTileOnCachedOneWayStateChange(TileIndex tile)
 {
+	YapfNotifyRoadLayoutChange(tile);
 	if (IsAnyRoadStopTile(tile) && IsCustomRoadStopSpecIndex(tile)) {
 		MarkTileGroundDirtyByTile(tile, VMDF_NOT_MAP_MODE);
 		return;
@@ -420,6 +421,7 @@ void RecalculateRoadCachedOneWayStates()
 
 void UpdateRoadCachedOneWayStatesAroundTile(TileIndex tile)
 {
+	YapfNotifyRoadLayoutChange(tile);
 	if (_generating_world) return;
 
 	auto check_tile = [](TileIndex t) {
@@ -1783,6 +1785,7 @@ CommandCost CmdBuildRoadDepot(TileIndex tile, DoCommandFlag flags, uint32_t p1,
 		MakeDefaultName(dep);
 
 		NotifyRoadLayoutChanged(true);
+		YapfNotifyRoadLayoutChange(tile);
 	}
 	cost.AddCost(_price[PR_BUILD_DEPOT_ROAD]);
 	return cost;
@@ -1812,6 +1815,7 @@ static CommandCost RemoveRoadDepot(TileIndex tile, DoCommandFlag flags)
 		DoClearSquare(tile);
 
 		NotifyRoadLayoutChanged(false);
+		YapfNotifyRoadLayoutChange(tile);
 		DeleteNewGRFInspectWindow(GSF_ROADTYPES, tile);
 	}
 
@@ -2613,6 +2617,7 @@ static void TileLoop_Road(TileIndex tile)
 					IsNormalRoad(tile) && !HasAtMostOneBit(GetAllRoadBits(tile))) {
 				if (std::get<0>(GetFoundationSlope(tile)) == SLOPE_FLAT && EnsureNoVehicleOnGround(tile).Succeeded() && Chance16(1, 40)) {
 					StartRoadWorks(tile);
+					YapfNotifyRoadLayoutChange(tile);
 
 					if (_settings_client.sound.ambient) SndPlayTileFx(SND_21_ROAD_WORKS, tile);
 					CreateEffectVehicleAbove(
@@ -2649,6 +2654,7 @@ static void TileLoop_Road(TileIndex tile)
 		}
 	} else if (IncreaseRoadWorksCounter(tile)) {
 		TerminateRoadWorks(tile);
+		YapfNotifyRoadLayoutChange(tile);
 
 		if (_settings_game.economy.mod_road_rebuild) {
 			/* Generate a nicer town surface */
@@ -3190,6 +3196,7 @@ CommandCost CmdConvertRoad(TileIndex tile, DoCommandFlag flags, uint32_t p1, uin
 
 				/* Perform the conversion */
 				SetRoadType(tile, rtt, to_type);
+				YapfNotifyRoadLayoutChange(tile);
 				MarkTileDirtyByTile(tile);
 
 				/* update power of train on this tile */
@@ -3277,6 +3284,8 @@ CommandCost CmdConvertRoad(TileIndex tile, DoCommandFlag flags, uint32_t p1, uin
 				/* Perform the conversion */
 				SetRoadType(tile, rtt, to_type);
 				if (include_middle) SetRoadType(endtile, rtt, to_type);
+				YapfNotifyRoadLayoutChange(tile);
+				YapfNotifyRoadLayoutChange(endtile);
 
 				AddRoadTunnelBridgeInfrastructure(tile, endtile);
 
@@ -3320,4 +3329,5 @@ extern const TileTypeProcs _tile_type_road_procs = {
 	VehicleEnter_Road,       // vehicle_enter_tile_proc
 	GetFoundation_Road,      // get_foundation_proc
 	TerraformTile_Road,      // terraform_tile_proc
+	nullptr,                 // tile_loop_idle_proc
 };
@@ -707,12 +707,11 @@ struct RoadVehFindData {
 	RoadTypeCollisionMode collision_mode;
 };
 
-static Vehicle *EnumCheckRoadVehClose(Vehicle *veh, void *data)
+static void EnumCheckRoadVehClose(Vehicle *veh, RoadVehFindData *rvf)
 {
 	static const int8_t dist_x[] = { -4, -8, -4, -1, 4, 8, 4, 1 };
 	static const int8_t dist_y[] = { -4, -1, 4, 8, 4, 1, -4, -8 };
 
-	RoadVehFindData *rvf = (RoadVehFindData*)data;
 	RoadVehicle *v = RoadVehicle::From(veh);
 
 	short x_diff = v->x_pos - rvf->x;
@@ -734,8 +733,6 @@ static Vehicle *EnumCheckRoadVehClose(Vehicle *veh, void *data)
 			rvf->best_diff = diff;
 		}
 	}
-
-	return nullptr;
 }
 
 static RoadVehicle *RoadVehFindCloseTo(RoadVehicle *v, int x, int y, Direction dir, bool update_blocked_ctr = true)
@@ -754,11 +751,12 @@ static RoadVehicle *RoadVehFindCloseTo(RoadVehicle *v, int x, int y, Direction d
 	rvf.best_diff = UINT_MAX;
 	rvf.collision_mode = collision_mode;
 
+	auto check_close = [&rvf](Vehicle *u) { EnumCheckRoadVehClose(u, &rvf); };
 	if (front->state == RVSB_WORMHOLE) {
-		FindVehicleOnPos(v->tile, VEH_ROAD, &rvf, EnumCheckRoadVehClose);
-		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), VEH_ROAD, &rvf, EnumCheckRoadVehClose);
+		FindVehicleOnPos(v->tile, VEH_ROAD, check_close);
+		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), VEH_ROAD, check_close);
 	} else {
-		FindVehicleOnPosXY(x, y, VEH_ROAD, &rvf, EnumCheckRoadVehClose);
+		FindVehicleOnPosXY(x, y, VEH_ROAD, check_close);
 	}
 
 	/* This code protects a roadvehicle from being blocked for ever
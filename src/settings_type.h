@@ -208,12 +208,14 @@ struct GUISettings : public TimeSettings {
 	uint32_t    autosave_interval;                               ///< how often should we do autosaves?
 	bool        autosave_realtime;                               ///< autosaves based on real elapsed time (with pause handling)
 	bool        threaded_saves;                                  ///< should we do threaded saves?
+	bool        snapshot_autosaves;                              ///< should autosaves be written by a forked process, where supported?
 	bool        keep_all_autosave;                               ///< name the autosave in a different way
 	bool        autosave_on_exit;                                ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	bool        autosave_on_network_disconnect;                  ///< save an autosave when you get disconnected from a network game with an error?
 	uint8_t     date_format_in_default_names;                    ///< should the default savegame/screenshot name use long dates (31th Dec 2008), short dates (31-12-2008) or ISO dates (2008-12-31)
 	uint8_t     max_num_autosaves;                               ///< controls how many autosavegames are made before the game starts to overwrite (names them 0 to max_num_autosaves - 1)
 	uint8_t     max_num_lt_autosaves;                            ///< controls how many long-term autosavegames are made before the game starts to overwrite (names them 0 to max_num_lt_autosaves - 1)
+	uint8_t     delta_autosaves;                                 ///< how many autosaves containing only the differences to the last full autosave are made between full autosaves
 	uint8_t     savegame_overwrite_confirm;                      ///< Mode for when to warn about overwriting an existing savegame
 	bool        population_in_label;                             ///< show the population of a town in its label?
 	bool        city_in_label;                                   ///< show cities in label?
@@ -26,6 +26,8 @@
 #include "core/checksum_func.hpp"
 #include "core/hash_func.hpp"
 #include "pathfinder/follow_track.hpp"
+#include "command_func.h"
+#include "3rdparty/robin_hood/robin_hood.h"
 
 #include "safeguards.h"
 
@@ -218,6 +220,19 @@ public:
 		return true;
 	}
 
+	/**
+	 * Reads an element of the set, without removing it
+	 * @param i index of the element, less than Items()
+	 * @param tile pointer where tile is written to
+	 * @param dir pointer where dir is written to
+	 */
+	void Peek(uint i, TileIndex *tile, Tdir *dir) const
+	{
+		assert(i < this->n);
+		*tile = this->data[i].tile;
+		*dir = this->data[i].dir;
+	}
+
 	/**
 	 * Reads the last added element into the set
 	 * @param tile pointer where tile is written to
@@ -243,25 +258,150 @@ static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of
 
 static uint _num_signals_evaluated; ///< Number of programmable pre-signals evaluated
 
-/** Check whether there is a train on rail, not in a depot */
-static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
+static std::vector<TileIndex> _segment_train_tiles; ///< tiles of the current signal block where any train not in a depot occupies the block
+
+/** Check whether a train is on rail, not in a depot */
+static inline bool IsTrainOnTileRail(const Vehicle *v)
 {
-	if (Train::From(v)->track == TRACK_BIT_DEPOT) return nullptr;
+	return Train::From(v)->track != TRACK_BIT_DEPOT;
+}
 
-	return v;
+/** Check whether there is a train on rail, not in a depot */
+static bool HasTrainOnTileRail(TileIndex tile)
+{
+	return HasVehicleOnPos(tile, VEH_TRAIN, IsTrainOnTileRail);
 }
 
-/** Check whether there is a train only on ramp. */
-static Vehicle *TrainInWormholeTileEnum(Vehicle *v, void *data)
+/** Check whether a train is only on ramp. */
+static bool IsTrainInWormholeTile(const Vehicle *v, TileIndex tile)
 {
 	/* Only look for front engine or last wagon. */
-	if ((v->Previous() != nullptr && v->Next() != nullptr)) return nullptr;
-	TileIndex tile = (TileIndex) reinterpret_cast<uintptr_t>(data);
-	if (tile != TileVirtXY(v->x_pos, v->y_pos)) return nullptr;
-	if (!(Train::From(v)->track & TRACK_BIT_WORMHOLE) && !(Train::From(v)->track & GetAcrossTunnelBridgeTrackBits(tile))) return nullptr;
-	return v;
+	if ((v->Previous() != nullptr && v->Next() != nullptr)) return false;
+	if (tile != TileVirtXY(v->x_pos, v->y_pos)) return false;
+	if (!(Train::From(v)->track & TRACK_BIT_WORMHOLE) && !(Train::From(v)->track & GetAcrossTunnelBridgeTrackBits(tile))) return false;
+	return true;
+}
+
+/** Check whether there is a train only on ramp of \a tile, whose location is \a search_tile. */
+static bool HasTrainInWormholeTile(TileIndex search_tile, TileIndex tile)
+{
+	return HasVehicleOnPos(search_tile, VEH_TRAIN, [tile](const Vehicle *v) { return IsTrainInWormholeTile(v, tile); });
 }
 
+/** Current signal block state flags */
+enum SigFlags {
+	SF_NONE    = 0,
+	SF_TRAIN   = 1 << 0, ///< train found in segment
+	SF_FULL    = 1 << 1, ///< some of buffers was full, do not continue
+	SF_PBS     = 1 << 2, ///< pbs signal found
+	SF_JUNCTION= 1 << 3, ///< junction found
+};
+
+DECLARE_ENUM_AS_BIT_SET(SigFlags)
+
+struct SigInfo {
+	inline SigInfo()
+	{
+		flags = SF_NONE;
+		num_exits = 0;
+		num_green = 0;
+		out_signal_tile = INVALID_TILE;
+		out_signal_trackdir = INVALID_TRACKDIR;
+	}
+	SigFlags flags;
+	uint num_exits;
+	uint num_green;
+	TileIndex out_signal_tile;
+	Trackdir out_signal_trackdir;
+};
+
+/** Type of a #SignalSegmentItem */
+enum SignalSegmentItemType : uint8_t {
+	SSIT_TRAIN_TILE,              ///< tile where any train on rail occupies the block
+	SSIT_TRAIN_TRACKS,            ///< tile where a train on the track bits in data occupies the block
+	SSIT_DEPOT,                   ///< rail depot
+	SSIT_CROSSING,                ///< level crossing
+	SSIT_SIGNAL,                  ///< signal(s) on the track entered in the trackdir in data
+	SSIT_TUNNEL_BRIDGE_WORMHOLE,  ///< signalled tunnel/bridge end, entered from the wormhole
+	SSIT_TUNNEL_BRIDGE_SIGNAL,    ///< signalled tunnel/bridge end, entered onto its signal
+	SSIT_TUNNEL_BRIDGE_TRACKS,    ///< tunnel/bridge end where a train on the tracks entered from the direction in data occupies the block
+	SSIT_FULL,                    ///< the set of open nodes overflowed here
+};
+
+/** Something found while walking a signal block, which is evaluated against the current signal states and trains */
+struct SignalSegmentItem {
+	TileIndex tile;
+	SignalSegmentItemType type;
+	uint8_t data; ///< track bits, trackdir or direction, see #SignalSegmentItemType
+
+	bool operator==(const SignalSegmentItem &other) const = default;
+};
+
+/** Tile side which was removed from _globset while walking a signal block */
+struct SignalSegmentGlobalRemoval {
+	TileIndex tile;
+	DiagDirection dir;
+
+	bool operator==(const SignalSegmentGlobalRemoval &other) const = default;
+};
+
+/**
+ * Layout of a signal block, as found by walking it from a given start.
+ * This only depends on the track layout, not on trains or signal states.
+ */
+struct SignalSegmentRecord {
+	std::vector<SignalSegmentItem> items;                     ///< items, in the order in which they were found
+	std::vector<SignalSegmentGlobalRemoval> global_removals;  ///< removals from _globset, in the order in which they were done
+	SigFlags flags = SF_NONE;                                 ///< SF_JUNCTION if any junction was found
+
+	bool operator==(const SignalSegmentRecord &other) const = default;
+
+	void Clear()
+	{
+		this->items.clear();
+		this->global_removals.clear();
+		this->flags = SF_NONE;
+	}
+};
+
+/** Start of a signal block walk, and what else the walk depends on */
+struct SignalSegmentKey {
+	uint32_t tile[2];
+	uint8_t dir[2];
+	uint8_t owner;
+	uint8_t shared;
+
+	bool operator==(const SignalSegmentKey &other) const = default;
+};
+
+/**
+ * Cache of signal block layouts, so that a block does not have to be walked again each time a train enters or leaves it.
+ * The cache is flushed whenever the track layout changes, so a cached layout is always identical to the result of a
+ * new walk, and the cache does not have to be saved or be the same on every client.
+ */
+struct SignalSegmentCache {
+	static const size_t MAX_ITEMS = 1 << 20; ///< flush instead of growing any further
+
+	struct KeyHash {
+		size_t operator()(const SignalSegmentKey &key) const noexcept
+		{
+			return robin_hood::hash_bytes(&key, sizeof(key));
+		}
+	};
+
+	robin_hood::unordered_flat_map<SignalSegmentKey, SignalSegmentRecord, KeyHash> records;
+	size_t total_items = 0; ///< number of items and removals of all records
+
+	void Flush()
+	{
+		this->records.clear();
+		this->total_items = 0;
+	}
+};
+
+static SignalSegmentCache _signal_segment_cache;
+static SignalSegmentRecord _signal_segment_scratch; ///< record of a block which is not cached
+
 /**
  * Perform some operations before adding data into Todo set
  * The new and reverse direction is removed from _globset, because we are sure
@@ -273,12 +413,13 @@ static Vehicle *TrainInWormholeTileEnum(Vehicle *v, void *data)
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
+ * @param record record of the current walk, the removals from _globset are stored there
  * @return false iff reverse direction was in Todo set
  */
-static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2, SignalSegmentRecord &record)
 {
-	_globset.Remove(t1, d1); // it can be in Global but not in Todo
-	_globset.Remove(t2, d2); // remove in all cases
+	record.global_removals.push_back({ t1, d1 }); // it can be in Global but not in Todo
+	record.global_removals.push_back({ t2, d2 }); // remove in all cases
 
 	assert(!_tbdset.IsIn(t1, d1)); // it really shouldn't be there already
 
@@ -297,52 +438,30 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
+ * @param record record of the current walk
  * @return false iff the Todo buffer would be overrun
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2, SignalSegmentRecord &record)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
+	if (!CheckAddToTodoSet(t1, d1, t2, d2, record)) return true;
 
 	return _tbdset.Add(t1, d1);
 }
 
-
-/** Current signal block state flags */
-enum SigFlags {
-	SF_NONE    = 0,
-	SF_TRAIN   = 1 << 0, ///< train found in segment
-	SF_FULL    = 1 << 1, ///< some of buffers was full, do not continue
-	SF_PBS     = 1 << 2, ///< pbs signal found
-	SF_JUNCTION= 1 << 3, ///< junction found
-};
-
-DECLARE_ENUM_AS_BIT_SET(SigFlags)
-
-struct SigInfo {
-	inline SigInfo()
-	{
-		flags = SF_NONE;
-		num_exits = 0;
-		num_green = 0;
-		out_signal_tile = INVALID_TILE;
-		out_signal_trackdir = INVALID_TRACKDIR;
-	}
-	SigFlags flags;
-	uint num_exits;
-	uint num_green;
-	TileIndex out_signal_tile;
-	Trackdir out_signal_trackdir;
-};
-
 /**
- * Search signal block
+ * Walk the signal block starting at the tiles in _tbdset, and record its layout.
+ * Nothing which depends on trains or signal states is looked at here, see #EvaluateSignalSegment.
  *
  * @param owner owner whose signals we are updating
- * @return SigFlags
+ * @param record record to fill
  */
-static SigInfo ExploreSegment(Owner owner)
+static void WalkSignalSegment(Owner owner, SignalSegmentRecord &record)
 {
-	SigInfo info;
+	record.Clear();
+
+	auto add_item = [&](TileIndex tile, SignalSegmentItemType type, uint8_t data = 0) {
+		record.items.push_back({ tile, type, data });
+	};
 
 	TileIndex tile = INVALID_TILE; // Stop GCC from complaining about a possibly uninitialized variable (issue #8280).
 	DiagDirection enterdir = INVALID_DIAGDIR;
@@ -357,15 +476,13 @@ static SigInfo ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (_settings_game.vehicle.train_braking_model == TBM_REALISTIC) info.flags |= SF_PBS;
-						if (!(info.flags & SF_TRAIN) && HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum)) info.flags |= SF_TRAIN;
+						add_item(tile, SSIT_DEPOT);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (_settings_game.vehicle.train_braking_model == TBM_REALISTIC) info.flags |= SF_PBS;
-						if (!(info.flags & SF_TRAIN) && HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum)) info.flags |= SF_TRAIN;
+						add_item(tile, SSIT_DEPOT);
 						continue;
 					} else {
 						continue;
@@ -378,67 +495,30 @@ static SigInfo ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(info.flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) info.flags |= SF_TRAIN;
+					add_item(tile, SSIT_TRAIN_TRACKS, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(info.flags & SF_TRAIN) && HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum)) info.flags |= SF_TRAIN;
+					add_item(tile, SSIT_TRAIN_TILE);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
 					Track track = TrackBitsToTrack(tracks_masked); // mask TRACK_BIT_X and Y too
 					if (HasSignalOnTrack(tile, track)) { // now check whole track, not trackdir
-						SignalType sig = GetSignalType(tile, track);
 						Trackdir trackdir = (Trackdir)FindFirstBit((tracks * 0x101U) & _enterdir_to_trackdirbits[enterdir]);
-						Trackdir reversedir = ReverseTrackdir(trackdir);
-						/* add (tile, reversetrackdir) to 'to-be-updated' set when there is
-						 * ANY conventional signal in REVERSE direction
-						 * (if it is a presignal EXIT and it changes, it will be added to 'to-be-done' set later) */
-						if (HasSignalOnTrackdir(tile, reversedir)) {
-							if (IsPbsSignalNonExtended(sig)) {
-								info.flags |= SF_PBS;
-								if (_extra_aspects > 0 && GetSignalStateByTrackdir(tile, reversedir) == SIGNAL_STATE_GREEN && !IsRailSpecialSignalAspect(tile, track)) {
-									_tbpset.Add(tile, reversedir);
-								}
-							} else if (!_tbuset.Add(tile, reversedir)) {
-								info.flags |= SF_FULL;
-								return info;
-							}
-						}
-
-						if (HasSignalOnTrackdir(tile, trackdir)) {
-							if (!IsOnewaySignal(sig)) info.flags |= SF_PBS;
-							if (_extra_aspects > 0) {
-								info.out_signal_tile = tile;
-								info.out_signal_trackdir = trackdir;
-								if (_settings_game.vehicle.train_braking_model == TBM_REALISTIC && GetSignalAlwaysReserveThrough(tile, track) &&
-										GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_RED) {
-									info.flags |= SF_PBS;
-								}
-							}
-
-							/* if it is a presignal EXIT in OUR direction, count it */
-							if (IsExitSignal(sig)) { // found presignal exit
-								info.num_exits++;
-								if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-									info.num_green++;
-								}
-							}
-						}
-
+						add_item(tile, SSIT_SIGNAL, trackdir);
 						continue;
 					}
 				} else if (!HasAtMostOneBit(tracks)) {
-					info.flags |= SF_JUNCTION;
+					record.flags |= SF_JUNCTION;
 				}
 
 				for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) { // test all possible exit directions
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) {
-							info.flags |= SF_FULL;
-							return info;
+						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir, record)) {
+							add_item(tile, SSIT_FULL);
+							return;
 						}
 					}
 				}
@@ -452,7 +532,7 @@ static SigInfo ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(info.flags & SF_TRAIN) && HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum)) info.flags |= SF_TRAIN;
+				add_item(tile, SSIT_TRAIN_TILE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -461,8 +541,7 @@ static SigInfo ExploreSegment(Owner owner)
 				if (!IsOneSignalBlock(owner, GetTileOwner(tile))) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(info.flags & SF_TRAIN) && HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum)) info.flags |= SF_TRAIN;
-				if (_settings_game.vehicle.safer_crossings) info.flags |= SF_PBS;
+				add_item(tile, SSIT_CROSSING);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -474,19 +553,6 @@ static SigInfo ExploreSegment(Owner owner)
 				if (enterdir == tunnel_bridge_dir) continue;
 
 				TrackBits tracks = GetTunnelBridgeTrackBits(tile);
-				TrackBits across_tracks = GetAcrossTunnelBridgeTrackBits(tile);
-
-				auto check_train_present = [tile, tracks, across_tracks](DiagDirection enterdir) -> bool {
-					if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) {
-						if (_enterdir_to_trackbits[enterdir] & across_tracks) {
-							return EnsureNoTrainOnTrackBits(tile, TRACK_BIT_WORMHOLE | across_tracks).Failed();
-						} else {
-							return EnsureNoTrainOnTrackBits(tile, tracks & (~across_tracks)).Failed();
-						}
-					} else {
-						return HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum);
-					}
-				};
 
 				TrackBits tracks_masked = (TrackBits)(tracks & _enterdir_to_trackbits[enterdir == INVALID_DIAGDIR ? tunnel_bridge_dir : enterdir]); // only incidating trackbits
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) tracks = tracks_masked;
@@ -494,18 +560,7 @@ static SigInfo ExploreSegment(Owner owner)
 				if (IsTunnelBridgeWithSignalSimulation(tile)) {
 					if (enterdir == INVALID_DIAGDIR) {
 						// incoming from the wormhole, onto signal
-						if (!(info.flags & SF_TRAIN) && IsTunnelBridgeSignalSimulationExit(tile)) { // tunnel entrance is ignored
-							if (HasVehicleOnPos(GetOtherTunnelBridgeEnd(tile), VEH_TRAIN, reinterpret_cast<void *>((uintptr_t)tile), &TrainInWormholeTileEnum)) info.flags |= SF_TRAIN;
-							if (!(info.flags & SF_TRAIN) && HasVehicleOnPos(tile, VEH_TRAIN, reinterpret_cast<void *>((uintptr_t)tile), &TrainInWormholeTileEnum)) info.flags |= SF_TRAIN;
-						}
-						if (IsTunnelBridgeSignalSimulationExit(tile) && !_tbuset.Add(tile, INVALID_TRACKDIR)) {
-							info.flags |= SF_FULL;
-							return info;
-						}
-						if (_extra_aspects > 0 && IsTunnelBridgeSignalSimulationEntrance(tile)) {
-							info.out_signal_tile = tile;
-							info.out_signal_trackdir = GetTunnelBridgeEntranceTrackdir(tile, tunnel_bridge_dir);
-						}
+						add_item(tile, SSIT_TUNNEL_BRIDGE_WORMHOLE);
 						Trackdir exit_track = GetTunnelBridgeExitTrackdir(tile, tunnel_bridge_dir);
 						exitdir = TrackdirToExitdir(exit_track);
 						enterdir = ReverseDiagDir(exitdir);
@@ -513,53 +568,32 @@ static SigInfo ExploreSegment(Owner owner)
 						break;
 					} else if (_enterdir_to_trackbits[enterdir] & GetAcrossTunnelBridgeTrackBits(tile)) {
 						// NOT incoming from the wormhole!
-						if (IsTunnelBridgeSignalSimulationExit(tile)) {
-							if (IsTunnelBridgePBS(tile)) {
-								info.flags |= SF_PBS;
-								if (_extra_aspects > 0 && GetTunnelBridgeExitSignalState(tile) == SIGNAL_STATE_GREEN) {
-									Trackdir exit_td = GetTunnelBridgeExitTrackdir(tile, tunnel_bridge_dir);
-									_tbpset.Add(tile, exit_td);
-								}
-							} else if (!_tbuset.Add(tile, INVALID_TRACKDIR)) {
-								info.flags |= SF_FULL;
-								return info;
-							}
-						}
-						if (_extra_aspects > 0 && IsTunnelBridgeSignalSimulationEntrance(tile)) {
-							info.out_signal_tile = tile;
-							info.out_signal_trackdir = GetTunnelBridgeEntranceTrackdir(tile, tunnel_bridge_dir);
-						}
-						if (!(info.flags & SF_TRAIN)) {
-							if (HasVehicleOnPos(tile, VEH_TRAIN, reinterpret_cast<void *>((uintptr_t)tile), &TrainInWormholeTileEnum)) info.flags |= SF_TRAIN;
-							if (!(info.flags & SF_TRAIN) && IsTunnelBridgeSignalSimulationExit(tile)) {
-								if (HasVehicleOnPos(GetOtherTunnelBridgeEnd(tile), VEH_TRAIN, reinterpret_cast<void *>((uintptr_t)tile), &TrainInWormholeTileEnum)) info.flags |= SF_TRAIN;
-							}
-						}
+						add_item(tile, SSIT_TUNNEL_BRIDGE_SIGNAL);
 						continue;
 					}
 				} else if (!HasAtMostOneBit(tracks)) {
-					info.flags |= SF_JUNCTION;
+					record.flags |= SF_JUNCTION;
 				}
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(info.flags & SF_TRAIN) && check_train_present(tunnel_bridge_dir)) info.flags |= SF_TRAIN;
+					add_item(tile, SSIT_TUNNEL_BRIDGE_TRACKS, tunnel_bridge_dir);
 					enterdir = tunnel_bridge_dir;
 				} else if (enterdir != tunnel_bridge_dir) { // NOT incoming from the wormhole!
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(info.flags & SF_TRAIN) && check_train_present(enterdir)) info.flags |= SF_TRAIN;
+					add_item(tile, SSIT_TUNNEL_BRIDGE_TRACKS, enterdir);
 				}
 				for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) { // test all possible exit directions
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						if (dir == tunnel_bridge_dir) {
-							if (!MaybeAddToTodoSet(GetOtherTunnelBridgeEnd(tile), INVALID_DIAGDIR, tile, INVALID_DIAGDIR)) {
-								info.flags |= SF_FULL;
-								return info;
+							if (!MaybeAddToTodoSet(GetOtherTunnelBridgeEnd(tile), INVALID_DIAGDIR, tile, INVALID_DIAGDIR, record)) {
+								add_item(tile, SSIT_FULL);
+								return;
 							}
 						} else {
 							TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 							DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-							if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) {
-								info.flags |= SF_FULL;
-								return info;
+							if (!MaybeAddToTodoSet(newtile, newdir, tile, dir, record)) {
+								add_item(tile, SSIT_FULL);
+								return;
 							}
 						}
 					}
@@ -571,10 +605,240 @@ static SigInfo ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) {
-			info.flags |= SF_FULL;
+		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir, record)) {
+			add_item(tile, SSIT_FULL);
 		}
 	}
+}
+
+/**
+ * Evaluate a walked signal block against the current signal states and trains,
+ * the tiles in #_segment_train_tiles are not checked for trains yet
+ *
+ * @param record layout of the signal block
+ * @return SigFlags
+ */
+static SigInfo EvaluateSignalSegment(const SignalSegmentRecord &record)
+{
+	SigInfo info;
+	info.flags = record.flags;
+
+	for (const SignalSegmentItem &item : record.items) {
+		const TileIndex tile = item.tile;
+
+		switch (item.type) {
+			case SSIT_TRAIN_TILE:
+				if (!(info.flags & SF_TRAIN)) _segment_train_tiles.push_back(tile);
+				break;
+
+			case SSIT_TRAIN_TRACKS:
+				/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
+				if (!(info.flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, (TrackBits)item.data).Failed()) info.flags |= SF_TRAIN;
+				break;
+
+			case SSIT_DEPOT:
+				if (_settings_game.vehicle.train_braking_model == TBM_REALISTIC) info.flags |= SF_PBS;
+				if (!(info.flags & SF_TRAIN)) _segment_train_tiles.push_back(tile);
+				break;
+
+			case SSIT_CROSSING:
+				if (!(info.flags & SF_TRAIN)) _segment_train_tiles.push_back(tile);
+				if (_settings_game.vehicle.safer_crossings) info.flags |= SF_PBS;
+				break;
+
+			case SSIT_SIGNAL: {
+				Trackdir trackdir = (Trackdir)item.data;
+				Track track = TrackdirToTrack(trackdir);
+				SignalType sig = GetSignalType(tile, track);
+				Trackdir reversedir = ReverseTrackdir(trackdir);
+				/* add (tile, reversetrackdir) to 'to-be-updated' set when there is
+				 * ANY conventional signal in REVERSE direction
+				 * (if it is a presignal EXIT and it changes, it will be added to 'to-be-done' set later) */
+				if (HasSignalOnTrackdir(tile, reversedir)) {
+					if (IsPbsSignalNonExtended(sig)) {
+						info.flags |= SF_PBS;
+						if (_extra_aspects > 0 && GetSignalStateByTrackdir(tile, reversedir) == SIGNAL_STATE_GREEN && !IsRailSpecialSignalAspect(tile, track)) {
+							_tbpset.Add(tile, reversedir);
+						}
+					} else if (!_tbuset.Add(tile, reversedir)) {
+						info.flags |= SF_FULL;
+						return info;
+					}
+				}
+
+				if (HasSignalOnTrackdir(tile, trackdir)) {
+					if (!IsOnewaySignal(sig)) info.flags |= SF_PBS;
+					if (_extra_aspects > 0) {
+						info.out_signal_tile = tile;
+						info.out_signal_trackdir = trackdir;
+						if (_settings_game.vehicle.train_braking_model == TBM_REALISTIC && GetSignalAlwaysReserveThrough(tile, track) &&
+								GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_RED) {
+							info.flags |= SF_PBS;
+						}
+					}
+
+					/* if it is a presignal EXIT in OUR direction, count it */
+					if (IsExitSignal(sig)) { // found presignal exit
+						info.num_exits++;
+						if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+							info.num_green++;
+						}
+					}
+				}
+				break;
+			}
+
+			case SSIT_TUNNEL_BRIDGE_WORMHOLE: {
+				DiagDirection tunnel_bridge_dir = GetTunnelBridgeDirection(tile);
+				if (!(info.flags & SF_TRAIN) && IsTunnelBridgeSignalSimulationExit(tile)) { // tunnel entrance is ignored
+					if (HasTrainInWormholeTile(GetOtherTunnelBridgeEnd(tile), tile)) info.flags |= SF_TRAIN;
+					if (!(info.flags & SF_TRAIN) && HasTrainInWormholeTile(tile, tile)) info.flags |= SF_TRAIN;
+				}
+				if (IsTunnelBridgeSignalSimulationExit(tile) && !_tbuset.Add(tile, INVALID_TRACKDIR)) {
+					info.flags |= SF_FULL;
+					return info;
+				}
+				if (_extra_aspects > 0 && IsTunnelBridgeSignalSimulationEntrance(tile)) {
+					info.out_signal_tile = tile;
+					info.out_signal_trackdir = GetTunnelBridgeEntranceTrackdir(tile, tunnel_bridge_dir);
+				}
+				break;
+			}
+
+			case SSIT_TUNNEL_BRIDGE_SIGNAL: {
+				DiagDirection tunnel_bridge_dir = GetTunnelBridgeDirection(tile);
+				if (IsTunnelBridgeSignalSimulationExit(tile)) {
+					if (IsTunnelBridgePBS(tile)) {
+						info.flags |= SF_PBS;
+						if (_extra_aspects > 0 && GetTunnelBridgeExitSignalState(tile) == SIGNAL_STATE_GREEN) {
+							Trackdir exit_td = GetTunnelBridgeExitTrackdir(tile, tunnel_bridge_dir);
+							_tbpset.Add(tile, exit_td);
+						}
+					} else if (!_tbuset.Add(tile, INVALID_TRACKDIR)) {
+						info.flags |= SF_FULL;
+						return info;
+					}
+				}
+				if (_extra_aspects > 0 && IsTunnelBridgeSignalSimulationEntrance(tile)) {
+					info.out_signal_tile = tile;
+					info.out_signal_trackdir = GetTunnelBridgeEntranceTrackdir(tile, tunnel_bridge_dir);
+				}
+				if (!(info.flags & SF_TRAIN)) {
+					if (HasTrainInWormholeTile(tile, tile)) info.flags |= SF_TRAIN;
+					if (!(info.flags & SF_TRAIN) && IsTunnelBridgeSignalSimulationExit(tile)) {
+						if (HasTrainInWormholeTile(GetOtherTunnelBridgeEnd(tile), tile)) info.flags |= SF_TRAIN;
+					}
+				}
+				break;
+			}
+
+			case SSIT_TUNNEL_BRIDGE_TRACKS: {
+				if (info.flags & SF_TRAIN) break;
+
+				const DiagDirection enterdir = (DiagDirection)item.data;
+				const TrackBits tracks = GetTunnelBridgeTrackBits(tile);
+				const TrackBits across_tracks = GetAcrossTunnelBridgeTrackBits(tile);
+				bool train_present;
+				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) {
+					if (_enterdir_to_trackbits[enterdir] & across_tracks) {
+						train_present = EnsureNoTrainOnTrackBits(tile, TRACK_BIT_WORMHOLE | across_tracks).Failed();
+					} else {
+						train_present = EnsureNoTrainOnTrackBits(tile, tracks & (~across_tracks)).Failed();
+					}
+				} else {
+					train_present = HasTrainOnTileRail(tile);
+				}
+				if (train_present) info.flags |= SF_TRAIN;
+				break;
+			}
+
+			case SSIT_FULL:
+				info.flags |= SF_FULL;
+				break;
+		}
+	}
+
+	return info;
+}
+
+/**
+ * Get the layout of the signal block starting at the tiles in _tbdset, from the cache if possible.
+ * The block is always walked again while a command is executing, as the track layout may have changed
+ * before the change was notified, and the cache is then flushed.
+ *
+ * @param owner owner whose signals we are updating
+ * @return layout of the signal block, valid until the next call
+ */
+static const SignalSegmentRecord &GetSignalSegmentRecord(Owner owner)
+{
+	if (IsCommandExecuting()) {
+		_signal_segment_cache.Flush();
+		WalkSignalSegment(owner, _signal_segment_scratch);
+		return _signal_segment_scratch;
+	}
+
+	SignalSegmentKey key{};
+	if (_tbdset.Items() > lengthof(key.tile)) {
+		WalkSignalSegment(owner, _signal_segment_scratch);
+		return _signal_segment_scratch;
+	}
+	for (uint i = 0; i < _tbdset.Items(); i++) {
+		TileIndex tile;
+		DiagDirection dir;
+		_tbdset.Peek(i, &tile, &dir);
+		key.tile[i] = tile;
+		key.dir[i] = dir;
+	}
+	key.owner = owner;
+	key.shared = _settings_game.economy.infrastructure_sharing[VEH_TRAIN] ? 1 : 0;
+
+	auto iter = _signal_segment_cache.records.find(key);
+	if (iter != _signal_segment_cache.records.end()) {
+		if (_debug_desync_level >= 2) {
+			WalkSignalSegment(owner, _signal_segment_scratch);
+			if (_signal_segment_scratch != iter->second) {
+				DEBUG(desync, 0, "Cached signal block layout does not match the track layout, tile: 0x%X, dir: %u", key.tile[0], key.dir[0]);
+				return _signal_segment_scratch;
+			}
+		}
+		_tbdset.Reset();
+		return iter->second;
+	}
+
+	SignalSegmentRecord record;
+	WalkSignalSegment(owner, record);
+	if (_signal_segment_cache.total_items >= SignalSegmentCache::MAX_ITEMS) _signal_segment_cache.Flush();
+	_signal_segment_cache.total_items += record.items.size() + record.global_removals.size();
+	return _signal_segment_cache.records.emplace(key, std::move(record)).first->second;
+}
+
+/** Forget the layouts of all signal blocks, this is called whenever the track layout changes. */
+void FlushSignalSegmentCache()
+{
+	_signal_segment_cache.Flush();
+}
+
+/**
+ * Search signal block
+ *
+ * @param owner owner whose signals we are updating
+ * @return SigFlags
+ */
+static SigInfo ExploreSegment(Owner owner)
+{
+	const SignalSegmentRecord &record = GetSignalSegmentRecord(owner);
+
+	if (!_globset.IsEmpty()) {
+		for (const SignalSegmentGlobalRemoval &removal : record.global_removals) {
+			_globset.Remove(removal.tile, removal.dir);
+		}
+	}
+
+	_segment_train_tiles.clear();
+	SigInfo info = EvaluateSignalSegment(record);
+
+	/* Check all the tiles where any train occupies the block at once */
+	if (!(info.flags & SF_TRAIN) && HasVehicleOnTiles(_segment_train_tiles, VEH_TRAIN, IsTrainOnTileRail)) info.flags |= SF_TRAIN;
 
 	return info;
 }
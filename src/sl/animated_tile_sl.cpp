@@ -21,13 +21,8 @@
  */
 static void Save_ANIT()
 {
-	uint count = 0;
+	SlSetLength(_animated_tiles.size() * 5);
 	for (const auto &it : _animated_tiles) {
-		if (!it.second.pending_deletion) count++;
-	}
-	SlSetLength(count * 5);
-	for (const auto &it : _animated_tiles) {
-		if (it.second.pending_deletion) continue;
 		SlWriteUint32(it.first);
 		SlWriteByte(it.second.speed);
 	}
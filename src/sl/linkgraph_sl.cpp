@@ -152,6 +152,92 @@ static void FilterDescs()
 	_filtered_job_desc = SlFilterObject(GetLinkGraphJobDesc());
 }
 
+/**
+ * Save the MCF results of the last job of a link graph.
+ * @param lg Link graph to be saved.
+ */
+static void Save_LinkGraphMCFCache(const LinkGraph &lg)
+{
+	const LinkGraph::MCFResultCache *cache = lg.GetMCFResultCache();
+	if (cache == nullptr) {
+		SlWriteUint32(0);
+		SlWriteUint32(0);
+		return;
+	}
+
+	SlWriteUint32((uint32_t)cache->edges.size());
+	for (const auto &edge : cache->edges) {
+		SlWriteUint16(edge.first);
+		SlWriteUint16(edge.second);
+	}
+	SlWriteUint32((uint32_t)cache->sources.size());
+	for (const LinkGraph::MCFSourceResult &result : cache->sources) {
+		SlWriteUint32((uint32_t)result.demands.size());
+		for (const LinkGraph::MCFSourceResult::Demand &demand : result.demands) {
+			SlWriteUint16(demand.dest);
+			SlWriteUint32(demand.demand);
+			SlWriteUint32(demand.satisfied);
+		}
+		SlWriteUint32((uint32_t)result.legs.size());
+		for (const LinkGraph::MCFSourceResult::Leg &leg : result.legs) {
+			SlWriteUint16(leg.from);
+			SlWriteUint16(leg.to);
+			SlWriteUint32(leg.capacity);
+			SlWriteUint32(leg.flow);
+		}
+	}
+}
+
+/**
+ * Load the MCF results of the last job of a link graph.
+ * @param lg Link graph to be loaded.
+ */
+static void Load_LinkGraphMCFCache(LinkGraph &lg)
+{
+	std::shared_ptr<LinkGraph::MCFResultCache> cache = std::make_shared<LinkGraph::MCFResultCache>();
+	const uint size = lg.Size();
+
+	/* The edges are distinct and sorted, and all nodes have to be in the graph. This also bounds the amount of memory allocated before the edges have been read. */
+	uint32_t edges = SlReadUint32();
+	if (edges > (uint64_t)size * (size - 1)) SlErrorCorrupt("Link graph MCF results edge count overflow");
+	cache->edges.reserve(std::min<size_t>(edges, lg.GetEdges().size()));
+	for (uint32_t i = 0; i < edges; i++) {
+		std::pair<NodeID, NodeID> edge;
+		edge.first = SlReadUint16();
+		edge.second = SlReadUint16();
+		if (edge.first >= size || edge.second >= size || edge.first == edge.second) SlErrorCorrupt("Link graph MCF results edge overflow");
+		if (!cache->edges.empty() && !(cache->edges.back() < edge)) SlErrorCorrupt("Link graph MCF results edges not sorted");
+		cache->edges.push_back(edge);
+	}
+	uint32_t sources = SlReadUint32();
+	if (sources > size) SlErrorCorrupt("Link graph MCF results overflow");
+	cache->sources.resize(sources);
+	for (LinkGraph::MCFSourceResult &result : cache->sources) {
+		/* There is at most one demand per destination, and one leg per edge. */
+		uint32_t demands = SlReadUint32();
+		if (demands > size) SlErrorCorrupt("Link graph MCF results demand count overflow");
+		result.demands.resize(demands);
+		for (LinkGraph::MCFSourceResult::Demand &demand : result.demands) {
+			demand.dest = SlReadUint16();
+			demand.demand = SlReadUint32();
+			demand.satisfied = SlReadUint32();
+			if (demand.dest >= size) SlErrorCorrupt("Link graph MCF results demand overflow");
+		}
+		uint32_t legs = SlReadUint32();
+		if (legs > edges) SlErrorCorrupt("Link graph MCF results leg count overflow");
+		result.legs.resize(legs);
+		for (LinkGraph::MCFSourceResult::Leg &leg : result.legs) {
+			leg.from = SlReadUint16();
+			leg.to = SlReadUint16();
+			leg.capacity = SlReadUint32();
+			leg.flow = SlReadUint32();
+			if (leg.from >= size || leg.to >= size) SlErrorCorrupt("Link graph MCF results leg overflow");
+		}
+	}
+
+	lg.SetMCFResultCache(sources > 0 ? std::move(cache) : nullptr);
+}
+
 /**
  * Save a link graph.
  * @param lg Link graph to be saved or loaded.
@@ -173,6 +259,7 @@ void Save_LinkGraph(LinkGraph &lg)
 		}
 		SlWriteUint16(INVALID_NODE);
 	}
+	Save_LinkGraphMCFCache(lg);
 }
 
 /**
@@ -221,6 +308,7 @@ void Load_LinkGraph(LinkGraph &lg)
 			}
 		}
 	}
+	if (SlXvIsFeaturePresent(XSLFI_LINKGRAPH_MCF_CACHE)) Load_LinkGraphMCFCache(lg);
 }
 
 /**
@@ -47,6 +47,8 @@
 #include "../scope.h"
 #include "../core/ring_buffer.hpp"
 #include "../timer/timer_game_tick.h"
+#include "../worker_thread.h"
+#include "../core/hash_func.hpp"
 #include <atomic>
 #include <string>
 #include <sys/stat.h>
@@ -57,6 +59,10 @@
 #ifndef _WIN32
 #	include <unistd.h>
 #endif /* _WIN32 */
+#if defined(__linux__)
+#	include <sys/wait.h>
+#	define WITH_SNAPSHOT_SAVE
+#endif
 
 #include "../tbtr_template_vehicle.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
@@ -88,6 +94,7 @@ uint32_t _ttdp_version;       ///< version of TTDP savegame (if applicable)
 SaveLoadVersion _sl_version;  ///< the major savegame version identifier
 byte   _sl_minor_version;     ///< the minor savegame version, DO NOT USE!
 std::string _savegame_format; ///< how to compress savegames
+bool _savegame_framed;        ///< compress savegames as independent frames, in parallel
 bool _do_autosave;            ///< are we doing an autosave at the moment?
 
 extern bool _sl_is_ext_version;
@@ -261,6 +268,9 @@ struct SaveLoadParams {
 
 	bool saveinprogress;                 ///< Whether there is currently a save in progress.
 	SaveModeFlags save_flags;            ///< Save mode flags
+	bool snapshot_child;                 ///< Whether this is a forked snapshot save process, which has no worker threads.
+
+	std::vector<std::pair<uint32_t, size_t>> chunk_offsets; ///< ID and offset in the savegame data of each saved chunk
 };
 
 static SaveLoadParams _sl; ///< Parameters used for/at saveload.
@@ -516,6 +526,11 @@ struct AsyncSaveThread {
 	std::atomic<bool> exit_thread;                ///< Signal that the thread should exit early
 	std::atomic<AsyncSaveFinishProc> finish_proc; ///< Callback to call when the savegame saving is finished.
 	std::thread save_thread;                      ///< The thread we're using to compress and write a savegame
+#ifdef WITH_SNAPSHOT_SAVE
+	pid_t snapshot_pid = -1;                      ///< The forked process writing a snapshot save, or -1
+	int snapshot_error_fd = -1;                   ///< Read end of the pipe the snapshot save process reports errors on
+	std::string snapshot_temp_name;               ///< Temporary file the snapshot save process writes to, removed if it fails
+#endif
 
 	void SetAsyncSaveFinish(AsyncSaveFinishProc proc)
 	{
@@ -562,6 +577,10 @@ struct AsyncSaveThread {
 };
 static AsyncSaveThread _async_save_thread;
 
+#ifdef WITH_SNAPSHOT_SAVE
+static void CheckSnapshotSave(bool wait);
+#endif
+
 /**
  * Called by save thread to tell we finished saving.
  * @param proc The callback to call when saving is done.
@@ -577,6 +596,9 @@ static void SetAsyncSaveFinish(AsyncSaveFinishProc proc)
 void ProcessAsyncSaveFinish()
 {
 	_async_save_thread.ProcessAsyncSaveFinish();
+#ifdef WITH_SNAPSHOT_SAVE
+	CheckSnapshotSave(false);
+#endif
 }
 
 /**
@@ -2712,7 +2734,9 @@ static void SlSaveChunk(const ChunkHandler &ch)
 static void SlSaveChunks()
 {
 	for (auto &ch : ChunkHandlers()) {
+		const size_t offset = SlGetBytesWritten();
 		SlSaveChunk(ch);
+		if (SlGetBytesWritten() != offset) _sl.chunk_offsets.emplace_back(ch.id, offset);
 	}
 
 	/* Terminator */
@@ -2870,6 +2894,20 @@ struct FileWriter : SaveFilter {
 	{
 	}
 
+	/**
+	 * Close the file without writing anything, and leave the temporary file for someone else to finish.
+	 * This is used when the savegame is written by a forked process.
+	 * @return The temporary name of the file, which has to be removed if the savegame is not finished.
+	 */
+	std::string Detach()
+	{
+		if (this->file != nullptr) fclose(this->file);
+		this->file = nullptr;
+		std::string temp_name = std::move(this->temp_name);
+		this->temp_name.clear();
+		return temp_name;
+	}
+
 	/** Make sure everything is cleaned up. */
 	~FileWriter()
 	{
@@ -3440,6 +3478,9 @@ struct SaveLoadFormat {
 	SaveLoadFormatFlags flags;            ///< flags
 };
 
+static std::shared_ptr<LoadFilter> CreateFramedLoadFilter(std::shared_ptr<LoadFilter> chain);
+static std::shared_ptr<LoadFilter> CreateDeltaLoadFilter(std::shared_ptr<LoadFilter> chain);
+
 /** The different saveload formats known/understood by OpenTTD. */
 static const SaveLoadFormat _saveload_formats[] = {
 #if defined(WITH_LZO)
@@ -3479,6 +3520,11 @@ static const SaveLoadFormat _saveload_formats[] = {
 #else
 	{"zstd",   TO_BE32X('OTTS'), nullptr,                            nullptr,                            0, 0, 0, SLF_REQUIRES_ZSTD},
 #endif
+	/* Container of independently compressed frames of one of the formats above, see SaveFramedFileToFilter. It is used
+	 * instead of the tag of the selected format when _savegame_framed is set, so it cannot be selected by itself. */
+	{"framed", TO_BE32X('OTTF'), CreateFramedLoadFilter,             nullptr,                            0, 0, 0, SLF_NONE},
+	/* Differences to an earlier full autosave, see SaveDeltaFileToFilter. It is used instead of the tag of the selected format for delta autosaves. */
+	{"delta",  TO_BE32X('OTTP'), CreateDeltaLoadFilter,              nullptr,                            0, 0, 0, SLF_NONE},
 };
 
 /**
@@ -3529,6 +3575,795 @@ static const SaveLoadFormat *GetSavegameFormat(const std::string &full_name, byt
 	return def;
 }
 
+/********************************************
+ ********* START OF FRAMED SAVEGAMES ********
+ ********************************************/
+
+/*
+ * After the usual savegame header with the tag 'OTTF', a framed savegame contains:
+ *   - uint32 tag of the format the frames are compressed with
+ *   - for each frame: uint32 compressed size, uint32 uncompressed size, the frame as a complete compressed stream
+ *   - uint32 0, uint32 0 as end marker
+ *   - index: uint32 number of frames, for each frame: uint64 file offset of the frame, uint64 offset of its uncompressed data
+ *   - index: uint32 number of chunks, for each chunk: uint32 chunk ID, uint64 offset of the chunk in the uncompressed data
+ *   - uint64 file offset of the index, 'OTTI'
+ * All numbers are big endian. As the frames are independent they can be compressed and decompressed in parallel,
+ * and reading the frames up to the end marker results in the same data as any other savegame.
+ */
+
+static const size_t FRAMED_SAVE_BLOCKS_PER_FRAME = 32; ///< Number of memory dumper blocks in a frame, 4 MiB.
+
+/** Save filter collecting the output of another filter in memory. */
+struct MemorySaveFilter : SaveFilter {
+	std::vector<byte> data; ///< The written data.
+
+	MemorySaveFilter() : SaveFilter(nullptr) {}
+
+	void Write(byte *buf, size_t len) override
+	{
+		this->data.insert(this->data.end(), buf, buf + len);
+	}
+};
+
+/** Load filter reading from a buffer in memory. */
+struct MemoryLoadFilter : LoadFilter {
+	const byte *pos; ///< Current read position.
+	const byte *end; ///< End of the buffer.
+
+	MemoryLoadFilter(const byte *buf, size_t len) : LoadFilter(nullptr), pos(buf), end(buf + len) {}
+
+	size_t Read(byte *buf, size_t len) override
+	{
+		len = std::min<size_t>(len, this->end - this->pos);
+		memcpy(buf, this->pos, len);
+		this->pos += len;
+		return len;
+	}
+
+	void Reset() override
+	{
+		NOT_REACHED();
+	}
+};
+
+/** Writer of the container of a framed or delta savegame, keeping track of the offset. */
+struct ContainerSaveWriter {
+	SaveFilter &sf;  ///< Filter to write to.
+	uint64_t offset; ///< Offset in the file.
+
+	void Write(byte *buf, size_t len)
+	{
+		this->sf.Write(buf, len);
+		this->offset += len;
+	}
+
+	void WriteByte(byte value)
+	{
+		this->Write(&value, sizeof(value));
+	}
+
+	void WriteUint32(uint32_t value)
+	{
+		value = TO_BE32(value);
+		this->Write((byte *)&value, sizeof(value));
+	}
+
+	void WriteUint64(uint64_t value)
+	{
+		this->WriteUint32((uint32_t)(value >> 32));
+		this->WriteUint32((uint32_t)value);
+	}
+};
+
+/**
+ * Read a big endian uint32 from the container of a framed or delta savegame.
+ * @param lf The filter to read from.
+ * @return The value.
+ */
+static uint32_t ReadContainerUint32(LoadFilter &lf)
+{
+	uint32_t value;
+	if (lf.Read((byte *)&value, sizeof(value)) != sizeof(value)) SlErrorCorrupt("Truncated savegame container");
+	return FROM_BE32(value);
+}
+
+/**
+ * Read a big endian uint64 from the container of a framed or delta savegame.
+ * @param lf The filter to read from.
+ * @return The value.
+ */
+static uint64_t ReadContainerUint64(LoadFilter &lf)
+{
+	uint64_t value = (uint64_t)ReadContainerUint32(lf) << 32;
+	return value | ReadContainerUint32(lf);
+}
+
+/**
+ * Get the format of the frames of a framed savegame, or of the data of a delta savegame.
+ * @param tag The tag of the format.
+ * @return The format, or nullptr if it is not available.
+ */
+static const SaveLoadFormat *GetContainedSavegameFormat(uint32_t tag)
+{
+	if (tag == TO_BE32X('OTTF') || tag == TO_BE32X('OTTP')) return nullptr;
+	for (const SaveLoadFormat &slf : _saveload_formats) {
+		if (slf.tag == tag) return slf.init_load != nullptr ? &slf : nullptr;
+	}
+	return nullptr;
+}
+
+/**
+ * Call a functor for all sub-ranges of [0, count) using the worker threads, and wait for all calls to complete.
+ * In a forked snapshot save process the worker threads do not exist, so there everything is done by the calling thread.
+ * @param count End of the range.
+ * @param grain Maximum size of a sub-range passed to \a func.
+ * @param func Functor to call with the (begin, end) of each sub-range.
+ */
+template <typename F>
+static void SaveLoadParallelFor(size_t count, size_t grain, F func)
+{
+	if (_sl.snapshot_child) {
+		func(0, count);
+	} else {
+		WorkerTaskGroup(WTC_SAVELOAD).ParallelFor(0, count, grain, func);
+	}
+}
+
+/**
+ * Compress the savegame in memory as independent frames, and write these with an index to the save filter.
+ * The savegame header has already been written.
+ * The frames are compressed in parallel by the worker threads.
+ * @param fmt The format to compress the frames with.
+ * @param compression The compression level.
+ */
+static void SaveFramedFileToFilter(const SaveLoadFormat *fmt, byte compression)
+{
+	MemoryDumper &dumper = *_sl.dumper;
+	dumper.FinaliseBlock();
+
+	const size_t block_count = dumper.blocks.size();
+	const size_t frame_count = CeilDivT<size_t>(block_count, FRAMED_SAVE_BLOCKS_PER_FRAME);
+	std::vector<std::vector<byte>> frames(frame_count);
+	std::vector<size_t> frame_sizes(frame_count);
+	std::atomic<bool> failed = false;
+
+	auto compress_frames = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			try {
+				auto sink = std::make_shared<MemorySaveFilter>();
+				std::shared_ptr<SaveFilter> sf = fmt->init_write(sink, compression);
+				const size_t last = std::min(block_count, (i + 1) * FRAMED_SAVE_BLOCKS_PER_FRAME);
+				for (size_t b = i * FRAMED_SAVE_BLOCKS_PER_FRAME; b < last; b++) {
+					sf->Write(dumper.blocks[b].data, dumper.blocks[b].size);
+					frame_sizes[i] += dumper.blocks[b].size;
+				}
+				sf->Finish();
+				frames[i] = std::move(sink->data);
+			} catch (...) {
+				failed = true;
+			}
+		}
+	};
+	SaveLoadParallelFor(frame_count, 1, compress_frames);
+	if (failed) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "compression of savegame frame failed");
+
+	ContainerSaveWriter out{ *_sl.sf, 8 };
+	uint32_t tag = fmt->tag;
+	out.Write((byte *)&tag, sizeof(tag));
+
+	std::vector<std::pair<uint64_t, uint64_t>> frame_offsets;
+	uint64_t data_offset = 0;
+	for (size_t i = 0; i < frame_count; i++) {
+		frame_offsets.emplace_back(out.offset, data_offset);
+		out.WriteUint32((uint32_t)frames[i].size());
+		out.WriteUint32((uint32_t)frame_sizes[i]);
+		out.Write(frames[i].data(), frames[i].size());
+		data_offset += frame_sizes[i];
+	}
+	out.WriteUint32(0);
+	out.WriteUint32(0);
+
+	const uint64_t index_offset = out.offset;
+	out.WriteUint32((uint32_t)frame_offsets.size());
+	for (const auto &it : frame_offsets) {
+		out.WriteUint64(it.first);
+		out.WriteUint64(it.second);
+	}
+	out.WriteUint32((uint32_t)_sl.chunk_offsets.size());
+	for (const auto &it : _sl.chunk_offsets) {
+		out.WriteUint32(it.first);
+		out.WriteUint64(it.second);
+	}
+	out.WriteUint64(index_offset);
+	tag = TO_BE32X('OTTI');
+	out.Write((byte *)&tag, sizeof(tag));
+
+	DEBUG(sl, 3, "Compressed " PRINTF_SIZE " bytes into " PRINTF_SIZE " frames, " OTTD_PRINTF64U " bytes", (size_t)data_offset, frame_count, out.offset);
+
+	_sl.sf->Finish();
+}
+
+/**
+ * Decompress a frame of a framed savegame.
+ * @param fmt The format the frame is compressed with.
+ * @param compressed The compressed frame.
+ * @param size The uncompressed size of the frame.
+ * @return The uncompressed frame.
+ */
+static std::vector<byte> DecompressSavegameFrame(const SaveLoadFormat *fmt, const std::vector<byte> &compressed, size_t size)
+{
+	std::vector<byte> frame(size);
+	std::shared_ptr<LoadFilter> lf = fmt->init_load(std::make_shared<MemoryLoadFilter>(compressed.data(), compressed.size()));
+	size_t done = 0;
+	while (done < size) {
+		size_t read = lf->Read(frame.data() + done, size - done);
+		if (read == 0) SlErrorCorrupt("Truncated savegame frame");
+		done += read;
+	}
+	return frame;
+}
+
+/** Frame of a framed savegame which is being decompressed. */
+struct FramedLoadPendingFrame {
+	/** State of the decompression. */
+	enum State : uint8_t {
+		QUEUED,    ///< Not yet started
+		RUNNING,   ///< Being decompressed
+		DONE,      ///< Decompressed
+		FAILED,    ///< Decompression failed
+		CANCELLED, ///< No longer needed
+	};
+
+	const SaveLoadFormat *fmt;  ///< The format the frame is compressed with.
+	std::vector<byte> compressed; ///< Compressed data.
+	std::vector<byte> data;     ///< Uncompressed data, when done.
+	size_t size;                ///< Uncompressed size.
+	std::atomic<State> state = QUEUED;
+	std::mutex lock;            ///< Lock for waiting until done.
+	std::condition_variable cv; ///< Notified when done or failed.
+
+	FramedLoadPendingFrame(const SaveLoadFormat *fmt, size_t size) : fmt(fmt), size(size) {}
+
+	/** Decompress the frame on a worker thread, unless this was already started by the reader. */
+	void Run()
+	{
+		State expected = QUEUED;
+		if (!this->state.compare_exchange_strong(expected, RUNNING)) return;
+
+		State result = DONE;
+		try {
+			this->data = DecompressSavegameFrame(this->fmt, this->compressed, this->size);
+		} catch (...) {
+			/* The reader decompresses the frame again itself, to report the error. */
+			result = FAILED;
+		}
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->state = result;
+		this->cv.notify_all();
+	}
+};
+
+/**
+ * Filter reading the frames of a framed savegame in order.
+ * The next frames are decompressed ahead in parallel by the worker threads.
+ */
+struct FramedLoadFilter : LoadFilter {
+	const SaveLoadFormat *fmt = nullptr; ///< The format the frames are compressed with.
+	std::deque<std::shared_ptr<FramedLoadPendingFrame>> pending; ///< Frames read from the file but not yet returned, in order.
+	uint max_pending;                    ///< Maximum number of frames in #pending.
+	std::vector<byte> frame;             ///< Uncompressed data of the current frame.
+	size_t frame_pos = 0;                ///< Read position in the current frame.
+	bool ended = false;                  ///< Whether the end marker has been read.
+	WorkerTaskGroup group;               ///< Jobs decompressing frames, must be after everything used by the jobs.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	FramedLoadFilter(std::shared_ptr<LoadFilter> chain) : LoadFilter(std::move(chain)), group(WTC_SAVELOAD)
+	{
+		uint32_t tag;
+		if (this->chain->Read((byte *)&tag, sizeof(tag)) != sizeof(tag)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+		this->fmt = GetContainedSavegameFormat(tag);
+		if (this->fmt == nullptr) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "Loader for the frames of the savegame is not available.");
+
+		this->max_pending = 1 + this->group.GetWorkerCount() * 2;
+	}
+
+	~FramedLoadFilter()
+	{
+		/* Skip any queued frames, the group waits for the running ones. */
+		for (auto &it : this->pending) {
+			FramedLoadPendingFrame::State expected = FramedLoadPendingFrame::QUEUED;
+			it->state.compare_exchange_strong(expected, FramedLoadPendingFrame::CANCELLED);
+		}
+	}
+
+	/** Read frames from the file until enough are pending, and queue them for decompression. */
+	void FillPending()
+	{
+		while (!this->ended && this->pending.size() < this->max_pending) {
+			const uint32_t compressed_size = ReadContainerUint32(*this->chain);
+			const uint32_t size = ReadContainerUint32(*this->chain);
+			if (compressed_size == 0 && size == 0) {
+				this->ended = true;
+				break;
+			}
+			if (size > FRAMED_SAVE_BLOCKS_PER_FRAME * MEMORY_CHUNK_SIZE || compressed_size > 2 * FRAMED_SAVE_BLOCKS_PER_FRAME * MEMORY_CHUNK_SIZE) {
+				SlErrorCorrupt("Invalid savegame frame size");
+			}
+
+			auto pending = std::make_shared<FramedLoadPendingFrame>(this->fmt, size);
+			pending->compressed.resize(compressed_size);
+			if (this->chain->Read(pending->compressed.data(), compressed_size) != compressed_size) SlErrorCorrupt("Truncated savegame frame");
+			if (this->group.GetWorkerCount() > 0) this->group.Enqueue([pending]() { pending->Run(); });
+			this->pending.push_back(std::move(pending));
+		}
+	}
+
+	/**
+	 * Make the next frame the current one.
+	 * If it is not yet being decompressed by a worker thread it is decompressed here, instead of waiting for a worker.
+	 * @return Whether there was a next frame.
+	 */
+	bool NextFrame()
+	{
+		this->FillPending();
+		if (this->pending.empty()) return false;
+
+		std::shared_ptr<FramedLoadPendingFrame> next = std::move(this->pending.front());
+		this->pending.pop_front();
+
+		FramedLoadPendingFrame::State expected = FramedLoadPendingFrame::QUEUED;
+		if (!next->state.compare_exchange_strong(expected, FramedLoadPendingFrame::RUNNING)) {
+			std::unique_lock<std::mutex> lock(next->lock);
+			next->cv.wait(lock, [&]() { return next->state >= FramedLoadPendingFrame::DONE; });
+		}
+		if (next->state == FramedLoadPendingFrame::DONE) {
+			this->frame = std::move(next->data);
+		} else {
+			this->frame = DecompressSavegameFrame(next->fmt, next->compressed, next->size);
+		}
+		this->frame_pos = 0;
+		return true;
+	}
+
+	size_t Read(byte *buf, size_t size) override
+	{
+		size_t read = 0;
+		while (read < size) {
+			if (this->frame_pos == this->frame.size()) {
+				if (!this->NextFrame()) break;
+				continue;
+			}
+			const size_t count = std::min(size - read, this->frame.size() - this->frame_pos);
+			memcpy(buf + read, this->frame.data() + this->frame_pos, count);
+			this->frame_pos += count;
+			read += count;
+		}
+		return read;
+	}
+};
+
+static std::shared_ptr<LoadFilter> CreateFramedLoadFilter(std::shared_ptr<LoadFilter> chain)
+{
+	return std::make_shared<FramedLoadFilter>(std::move(chain));
+}
+
+/********************************************
+ ********* START OF DELTA SAVEGAMES *********
+ ********************************************/
+
+/*
+ * A delta savegame only contains the parts of the savegame data which differ from an earlier full autosave, the base.
+ * After the usual savegame header with the tag 'OTTP', it contains the uint32 tag of the format the rest is compressed with.
+ * The compressed data contains:
+ *   - uint32 length and the file name of the base, in the autosave directory
+ *   - uint32 second word of the savegame header of the base, uint64 hash of the data of the base
+ *   - uint32 number of chunks in the base, for each chunk: uint32 chunk ID, uint64 offset, uint64 length
+ *   - uint32 number of chunks, for each chunk: uint32 chunk ID, uint64 length, uint32 index of the chunk with this ID in the
+ *     base or UINT32_MAX, followed by the segments of the chunk. When there is a chunk in the base each segment starts with
+ *     a byte which is 0 when the segment is the same as the segment at the same position in the base chunk, or 1 when the
+ *     data of the segment follows. Otherwise the data of all segments follows.
+ * All numbers are big endian. The chunks include their header, and the last chunk includes the terminator.
+ */
+
+static const size_t DELTA_SAVE_SEGMENT_SIZE = 16384; ///< Size of the parts of a chunk which are compared with the base.
+static const uint32_t DELTA_SAVE_MAX_CHUNKS = 4096;  ///< Maximum number of chunks in the base of a delta savegame.
+
+/** A chunk in the savegame data, with the hashes of its segments. */
+struct DeltaSaveChunk {
+	uint32_t id;                          ///< Chunk ID.
+	size_t offset;                        ///< Offset in the savegame data.
+	size_t length;                        ///< Length in the savegame data.
+	std::vector<uint64_t> segment_hashes; ///< Hash of each segment of DELTA_SAVE_SEGMENT_SIZE bytes.
+};
+
+/** The last full autosave, which delta autosaves are written against. */
+struct DeltaSaveBase {
+	bool valid = false;                 ///< Whether the base was saved successfully.
+	std::string filename;               ///< File name in the autosave directory.
+	uint32_t header_version = 0;        ///< Second word of the savegame header.
+	uint64_t hash = 0;                  ///< Hash of the savegame data.
+	std::vector<DeltaSaveChunk> chunks; ///< Chunks in the savegame data.
+	uint deltas = 0;                    ///< Number of delta autosaves written against this base.
+};
+
+/** The base for delta autosaves, this is written by the save thread of the full autosave and of each delta autosave. */
+static DeltaSaveBase _delta_save_base;
+
+/**
+ * Forget the base for delta autosaves, as it belongs to the game which is being replaced.
+ * The next autosave is a full autosave again.
+ */
+void ClearDeltaSaveBase()
+{
+	WaitTillSaved();
+	_delta_save_base = {};
+}
+
+/**
+ * Hash a segment of the savegame data.
+ * @param data The segment.
+ * @param len The length of the segment.
+ * @return The hash.
+ */
+static uint64_t HashDeltaSaveSegment(const byte *data, size_t len)
+{
+	uint64_t hash = len;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = SimpleHash64(hash ^ FROM_LE64(word));
+	}
+	uint64_t tail = 0;
+	for (; i < len; i++) tail = (tail << 8) | data[i];
+	return SimpleHash64(hash ^ tail);
+}
+
+/**
+ * Hash the savegame data, from the hashes of the segments of its chunks.
+ * @param chunks The chunks.
+ * @return The hash.
+ */
+static uint64_t HashDeltaSaveChunks(const std::vector<DeltaSaveChunk> &chunks)
+{
+	uint64_t hash = chunks.size();
+	for (const DeltaSaveChunk &chunk : chunks) {
+		hash = SimpleHash64(hash ^ chunk.id);
+		hash = SimpleHash64(hash ^ chunk.length);
+		for (uint64_t segment : chunk.segment_hashes) hash = SimpleHash64(hash ^ segment);
+	}
+	return hash;
+}
+
+/**
+ * Hash the segments of chunks in parallel.
+ * @param chunks The chunks, with their segment hashes to fill in.
+ * @param read_segment Functor returning a pointer to the data of a segment, given the chunk, the offset in the chunk, the length and a buffer of DELTA_SAVE_SEGMENT_SIZE bytes it may use.
+ */
+template <typename F>
+static void HashDeltaSaveSegments(std::vector<DeltaSaveChunk> &chunks, F read_segment)
+{
+	std::vector<std::pair<DeltaSaveChunk *, size_t>> segments;
+	for (DeltaSaveChunk &chunk : chunks) {
+		chunk.segment_hashes.resize(CeilDivT<size_t>(chunk.length, DELTA_SAVE_SEGMENT_SIZE));
+		for (size_t i = 0; i < chunk.segment_hashes.size(); i++) segments.emplace_back(&chunk, i);
+	}
+	SaveLoadParallelFor(segments.size(), 64, [&](size_t begin, size_t end) {
+		std::unique_ptr<byte[]> buffer(new byte[DELTA_SAVE_SEGMENT_SIZE]);
+		for (size_t i = begin; i < end; i++) {
+			DeltaSaveChunk &chunk = *segments[i].first;
+			const size_t pos = segments[i].second * DELTA_SAVE_SEGMENT_SIZE;
+			const size_t len = std::min(DELTA_SAVE_SEGMENT_SIZE, chunk.length - pos);
+			chunk.segment_hashes[segments[i].second] = HashDeltaSaveSegment(read_segment(chunk, pos, len, buffer.get()), len);
+		}
+	});
+}
+
+/** Random access to the savegame data in the memory dumper, after its last block has been finalised. */
+struct MemoryDumperView {
+	const MemoryDumper &dumper;
+	std::vector<size_t> block_offsets; ///< Offset of each block in the savegame data.
+	size_t size = 0;                   ///< Size of the savegame data.
+
+	MemoryDumperView(const MemoryDumper &dumper) : dumper(dumper)
+	{
+		for (const MemoryDumper::BufferInfo &block : dumper.blocks) {
+			this->block_offsets.push_back(this->size);
+			this->size += block.size;
+		}
+	}
+
+	/**
+	 * Call a functor for the contiguous parts of a range of the savegame data.
+	 * @param offset Start of the range.
+	 * @param len Length of the range.
+	 * @param func Functor to call with the pointer and the length of each part.
+	 */
+	template <typename F>
+	void ForEachPart(size_t offset, size_t len, F func) const
+	{
+		size_t block = std::upper_bound(this->block_offsets.begin(), this->block_offsets.end(), offset) - this->block_offsets.begin() - 1;
+		while (len > 0) {
+			const MemoryDumper::BufferInfo &info = this->dumper.blocks[block];
+			const size_t pos = offset - this->block_offsets[block];
+			const size_t count = std::min(len, info.size - pos);
+			if (count > 0) func(info.data + pos, count);
+			offset += count;
+			len -= count;
+			block++;
+		}
+	}
+
+	/**
+	 * Split the savegame data in chunks, and hash their segments.
+	 * @return The chunks.
+	 */
+	std::vector<DeltaSaveChunk> GetChunks() const
+	{
+		std::vector<DeltaSaveChunk> chunks;
+		for (const auto &it : _sl.chunk_offsets) {
+			if (!chunks.empty()) chunks.back().length = it.second - chunks.back().offset;
+			chunks.push_back({ it.first, it.second, 0, {} });
+		}
+		if (chunks.empty() || chunks.front().offset != 0) chunks.insert(chunks.begin(), { 0, 0, chunks.empty() ? 0 : chunks.front().offset, {} });
+		chunks.back().length = this->size - chunks.back().offset;
+
+		HashDeltaSaveSegments(chunks, [&](const DeltaSaveChunk &chunk, size_t pos, size_t len, byte *buffer) -> const byte * {
+			byte *out = buffer;
+			this->ForEachPart(chunk.offset + pos, len, [&](const byte *data, size_t count) {
+				memcpy(out, data, count);
+				out += count;
+			});
+			return buffer;
+		});
+		return chunks;
+	}
+};
+
+/**
+ * Remember the savegame in memory, which has just been written, as the base for delta autosaves.
+ * The file name has already been set by DoAutoOrNetsave.
+ * @param header_version Second word of the savegame header.
+ */
+static void SetDeltaSaveBase(uint32_t header_version)
+{
+	_delta_save_base.chunks = MemoryDumperView(*_sl.dumper).GetChunks();
+	_delta_save_base.header_version = header_version;
+	_delta_save_base.hash = HashDeltaSaveChunks(_delta_save_base.chunks);
+	_delta_save_base.valid = true;
+}
+
+/**
+ * Compress the differences between the savegame in memory and the base for delta autosaves, and write these to the save filter.
+ * The savegame header has already been written.
+ * @param fmt The format to compress the differences with.
+ * @param compression The compression level.
+ */
+static void SaveDeltaFileToFilter(const SaveLoadFormat *fmt, byte compression)
+{
+	const DeltaSaveBase &base = _delta_save_base;
+	assert(base.valid);
+
+	_sl.dumper->FinaliseBlock();
+	const MemoryDumperView view(*_sl.dumper);
+	const std::vector<DeltaSaveChunk> chunks = view.GetChunks();
+
+	uint32_t tag = fmt->tag;
+	_sl.sf->Write((byte *)&tag, sizeof(tag));
+	_sl.sf = fmt->init_write(_sl.sf, compression);
+
+	ContainerSaveWriter out{ *_sl.sf, 0 };
+	std::string filename = base.filename;
+	out.WriteUint32((uint32_t)filename.size());
+	out.Write((byte *)filename.data(), filename.size());
+	out.WriteUint32(base.header_version);
+	out.WriteUint64(base.hash);
+	out.WriteUint32((uint32_t)base.chunks.size());
+	for (const DeltaSaveChunk &chunk : base.chunks) {
+		out.WriteUint32(chunk.id);
+		out.WriteUint64(chunk.offset);
+		out.WriteUint64(chunk.length);
+	}
+
+	size_t changed = 0;
+	out.WriteUint32((uint32_t)chunks.size());
+	for (const DeltaSaveChunk &chunk : chunks) {
+		auto base_chunk = std::find_if(base.chunks.begin(), base.chunks.end(), [&](const DeltaSaveChunk &it) { return it.id == chunk.id; });
+		const bool in_base = base_chunk != base.chunks.end();
+
+		out.WriteUint32(chunk.id);
+		out.WriteUint64(chunk.length);
+		out.WriteUint32(in_base ? (uint32_t)(base_chunk - base.chunks.begin()) : UINT32_MAX);
+		for (size_t i = 0; i < chunk.segment_hashes.size(); i++) {
+			const size_t pos = i * DELTA_SAVE_SEGMENT_SIZE;
+			const size_t len = std::min(DELTA_SAVE_SEGMENT_SIZE, chunk.length - pos);
+			if (in_base) {
+				const bool same = pos + len <= base_chunk->length && std::min(DELTA_SAVE_SEGMENT_SIZE, base_chunk->length - pos) == len &&
+						base_chunk->segment_hashes[i] == chunk.segment_hashes[i];
+				out.WriteByte(same ? 0 : 1);
+				if (same) continue;
+			}
+			view.ForEachPart(chunk.offset + pos, len, [&](byte *data, size_t count) { out.Write(data, count); });
+			changed += len;
+		}
+	}
+
+	DEBUG(sl, 3, "Saved " PRINTF_SIZE " of " PRINTF_SIZE " bytes as differences to %s", changed, view.size, base.filename.c_str());
+
+	_sl.sf->Finish();
+}
+
+/** Filter reconstructing the savegame data of a delta savegame, from the differences and its base. */
+struct DeltaLoadFilter : LoadFilter {
+	/** A chunk in the base. */
+	struct BaseChunk {
+		size_t offset; ///< Offset in the savegame data of the base.
+		size_t length; ///< Length of the chunk.
+	};
+
+	std::vector<byte> base;             ///< Savegame data of the base.
+	std::vector<BaseChunk> base_chunks; ///< Chunks in the base.
+	uint32_t chunks_left = 0;           ///< Number of chunks which still have to be started.
+	const BaseChunk *base_chunk = nullptr; ///< Chunk in the base of the current chunk, if any.
+	size_t chunk_length = 0;            ///< Length of the current chunk.
+	size_t chunk_pos = 0;               ///< Position of the next segment in the current chunk.
+	std::vector<byte> buffer;           ///< Buffer for a segment which is not in the base.
+	const byte *segment = nullptr;      ///< Current segment.
+	size_t segment_length = 0;          ///< Length of the current segment.
+	size_t segment_pos = 0;             ///< Read position in the current segment.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	DeltaLoadFilter(std::shared_ptr<LoadFilter> chain) : LoadFilter(std::move(chain)), buffer(DELTA_SAVE_SEGMENT_SIZE)
+	{
+		uint32_t tag;
+		if (this->chain->Read((byte *)&tag, sizeof(tag)) != sizeof(tag)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+		const SaveLoadFormat *fmt = GetContainedSavegameFormat(tag);
+		if (fmt == nullptr) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "Loader for the data of the delta savegame is not available.");
+		this->chain = fmt->init_load(std::move(this->chain));
+
+		const uint32_t name_length = ReadContainerUint32(*this->chain);
+		if (name_length > MAX_PATH) SlErrorCorrupt("Invalid name of the base of the delta savegame");
+		std::string filename(name_length, '\0');
+		if (this->chain->Read((byte *)filename.data(), name_length) != name_length) SlErrorCorrupt("Truncated savegame container");
+		/* The base is always a file directly in the autosave directory. */
+		if (filename.empty() || filename.find_first_of("/\\:") != std::string::npos || filename.find('\0') != std::string::npos || filename.find("..") != std::string::npos) {
+			SlErrorCorrupt("Invalid name of the base of the delta savegame");
+		}
+		const uint32_t header_version = ReadContainerUint32(*this->chain);
+		const uint64_t hash = ReadContainerUint64(*this->chain);
+
+		const uint32_t chunk_count = ReadContainerUint32(*this->chain);
+		if (chunk_count > DELTA_SAVE_MAX_CHUNKS) SlErrorCorrupt("Too many chunks in the base of the delta savegame");
+		std::vector<DeltaSaveChunk> chunks(chunk_count);
+		size_t base_size = 0;
+		for (DeltaSaveChunk &chunk : chunks) {
+			chunk.id = ReadContainerUint32(*this->chain);
+			const uint64_t offset = ReadContainerUint64(*this->chain);
+			const uint64_t length = ReadContainerUint64(*this->chain);
+			if (offset != base_size || length > SIZE_MAX - base_size) SlErrorCorrupt("Invalid chunk of the base of the delta savegame");
+			chunk.offset = (size_t)offset;
+			chunk.length = (size_t)length;
+			base_size += chunk.length;
+			this->base_chunks.push_back({ chunk.offset, chunk.length });
+		}
+
+		/* Check that the base is still the file the differences were saved against. */
+		bool same = this->LoadBase(filename, header_version, base_size);
+		if (same) {
+			HashDeltaSaveSegments(chunks, [&](const DeltaSaveChunk &chunk, size_t pos, size_t, byte *) -> const byte * {
+				return this->base.data() + chunk.offset + pos;
+			});
+			same = HashDeltaSaveChunks(chunks) == hash;
+		}
+		if (!same) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "The base savegame " + filename + " of the delta savegame has been replaced.");
+
+		this->chunks_left = ReadContainerUint32(*this->chain);
+	}
+
+	/**
+	 * Read the savegame data of the base.
+	 * @param filename File name of the base, in the autosave directory.
+	 * @param header_version Expected second word of the savegame header of the base.
+	 * @param size Expected size of the savegame data of the base, no more than this is read.
+	 * @return Whether the savegame data of the base has the expected size.
+	 */
+	bool LoadBase(const std::string &filename, uint32_t header_version, size_t size)
+	{
+		FILE *fh = FioFOpenFile(filename, "rb", AUTOSAVE_DIR);
+		if (fh == nullptr) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "The base savegame " + filename + " of the delta savegame cannot be found.");
+
+		std::shared_ptr<LoadFilter> lf = std::make_shared<FileReader>(fh);
+		uint32_t hdr[2];
+		if (lf->Read((byte *)hdr, sizeof(hdr)) != sizeof(hdr)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+		if (hdr[1] != header_version) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "The base savegame " + filename + " of the delta savegame has been replaced.");
+
+		const SaveLoadFormat *fmt = nullptr;
+		for (const SaveLoadFormat &slf : _saveload_formats) {
+			if (slf.tag == hdr[0] && slf.tag != TO_BE32X('OTTP')) fmt = &slf;
+		}
+		if (fmt == nullptr || fmt->init_load == nullptr) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "Loader for the base savegame of the delta savegame is not available.");
+		lf = fmt->init_load(std::move(lf));
+
+		/* Grow the buffer as the data is read, instead of trusting the expected size. */
+		size_t pos = 0;
+		while (pos < size) {
+			const size_t count = std::min(size - pos, MEMORY_CHUNK_SIZE);
+			this->base.resize(pos + count);
+			const size_t read = lf->Read(this->base.data() + pos, count);
+			pos += read;
+			if (read < count) {
+				this->base.resize(pos);
+				return false;
+			}
+		}
+
+		/* There must be nothing after the expected data. */
+		byte extra;
+		return lf->Read(&extra, sizeof(extra)) == 0;
+	}
+
+	/**
+	 * Make the next segment the current one.
+	 * @return Whether there was a next segment.
+	 */
+	bool NextSegment()
+	{
+		while (this->chunk_pos == this->chunk_length) {
+			if (this->chunks_left == 0) return false;
+			this->chunks_left--;
+
+			ReadContainerUint32(*this->chain); // Chunk ID
+			this->chunk_length = ReadContainerUint64(*this->chain);
+			const uint32_t base_index = ReadContainerUint32(*this->chain);
+			if (base_index != UINT32_MAX && base_index >= this->base_chunks.size()) SlErrorCorrupt("Invalid chunk of the base of the delta savegame");
+			this->base_chunk = (base_index == UINT32_MAX) ? nullptr : &this->base_chunks[base_index];
+			this->chunk_pos = 0;
+		}
+
+		this->segment_length = std::min(DELTA_SAVE_SEGMENT_SIZE, this->chunk_length - this->chunk_pos);
+		this->segment_pos = 0;
+
+		byte changed = 1;
+		if (this->base_chunk != nullptr && this->chain->Read(&changed, sizeof(changed)) != sizeof(changed)) SlErrorCorrupt("Truncated savegame container");
+		if (changed == 0) {
+			if (this->chunk_pos + this->segment_length > this->base_chunk->length) SlErrorCorrupt("Invalid segment of the base of the delta savegame");
+			this->segment = this->base.data() + this->base_chunk->offset + this->chunk_pos;
+		} else {
+			if (this->chain->Read(this->buffer.data(), this->segment_length) != this->segment_length) SlErrorCorrupt("Truncated savegame container");
+			this->segment = this->buffer.data();
+		}
+		this->chunk_pos += this->segment_length;
+		return true;
+	}
+
+	size_t Read(byte *buf, size_t size) override
+	{
+		size_t read = 0;
+		while (read < size) {
+			if (this->segment_pos == this->segment_length) {
+				if (!this->NextSegment()) break;
+				continue;
+			}
+			const size_t count = std::min(size - read, this->segment_length - this->segment_pos);
+			memcpy(buf + read, this->segment + this->segment_pos, count);
+			this->segment_pos += count;
+			read += count;
+		}
+		return read;
+	}
+};
+
+static std::shared_ptr<LoadFilter> CreateDeltaLoadFilter(std::shared_ptr<LoadFilter> chain)
+{
+	return std::make_shared<DeltaLoadFilter>(std::move(chain));
+}
+
 /* actual loader/saver function */
 void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settings);
 extern bool AfterLoadGame();
@@ -3556,6 +4391,7 @@ static inline void ClearSaveLoadState()
 	_sl.save_flags = SMF_NONE;
 	_sl.current_chunk_id = 0;
 	_sl.chunk_block_modes.clear();
+	_sl.chunk_offsets.clear();
 
 	GamelogStopAnyAction();
 }
@@ -3604,6 +4440,34 @@ static void SaveFileError()
 	SaveFileDone();
 }
 
+/** Compress the savegame in memory, and write it to the save filter. */
+static void SaveFileToFilter()
+{
+	byte compression;
+	const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression, _sl.save_flags);
+
+	const bool delta = (_sl.save_flags & SMF_DELTA) != 0;
+	const bool framed = !delta && _savegame_framed;
+	DEBUG(sl, 3, "Using compression format: %s, level: %u%s", fmt->name, compression, delta ? ", delta" : (framed ? ", framed" : ""));
+
+	/* We have written our stuff to memory, now write it to file! */
+	uint32_t hdr[2] = { delta ? TO_BE32X('OTTP') : (framed ? TO_BE32X('OTTF') : fmt->tag), TO_BE32((uint32_t) (SAVEGAME_VERSION | SAVEGAME_VERSION_EXT) << 16) };
+	_sl.sf->Write((byte*)hdr, sizeof(hdr));
+
+	if (delta) {
+		SaveDeltaFileToFilter(fmt, compression);
+	} else if (framed) {
+		SaveFramedFileToFilter(fmt, compression);
+	} else {
+		_sl.sf = fmt->init_write(_sl.sf, compression);
+		_sl.dumper->Flush(*(_sl.sf));
+	}
+
+	if (_sl.save_flags & SMF_DELTA_BASE) SetDeltaSaveBase(hdr[1]);
+	/* The delta autosave has been written completely, so the next one gets the next number. */
+	if (delta) _delta_save_base.deltas++;
+}
+
 /**
  * We have written the whole game into memory, _memory_savegame, now find
  * and appropriate compressor and start writing to file.
@@ -3611,17 +4475,7 @@ static void SaveFileError()
 static SaveOrLoadResult SaveFileToDisk(bool threaded)
 {
 	try {
-		byte compression;
-		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression, _sl.save_flags);
-
-		DEBUG(sl, 3, "Using compression format: %s, level: %u", fmt->name, compression);
-
-		/* We have written our stuff to memory, now write it to file! */
-		uint32_t hdr[2] = { fmt->tag, TO_BE32((uint32_t) (SAVEGAME_VERSION | SAVEGAME_VERSION_EXT) << 16) };
-		_sl.sf->Write((byte*)hdr, sizeof(hdr));
-
-		_sl.sf = fmt->init_write(_sl.sf, compression);
-		_sl.dumper->Flush(*(_sl.sf));
+		SaveFileToFilter();
 
 		ClearSaveLoadState();
 
@@ -3653,8 +4507,123 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 void WaitTillSaved()
 {
 	_async_save_thread.WaitTillSaved();
+#ifdef WITH_SNAPSHOT_SAVE
+	CheckSnapshotSave(true);
+#endif
 }
 
+#ifdef WITH_SNAPSHOT_SAVE
+/**
+ * Save the game from a copy-on-write snapshot of the whole process, taken by forking.
+ * The child process serialises, compresses and writes the savegame, while the game continues in the parent.
+ * The result is reported back by CheckSnapshotSave.
+ * @param writer The file to write the savegame to, this is only written to by the child process.
+ * @return Whether the child process was started, if not the game should be saved in the usual way.
+ */
+static bool DoSnapshotSave(const std::shared_ptr<FileWriter> &writer)
+{
+	assert(!_sl.saveinprogress);
+
+	int error_pipe[2];
+	if (pipe(error_pipe) != 0) return false;
+
+	_sl_version = SAVEGAME_VERSION;
+	SlXvSetCurrentState();
+
+	SaveViewportBeforeSaveGame();
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		DEBUG(sl, 1, "Cannot fork snapshot save process, reverting to normal saving: %s", strerror(errno));
+		close(error_pipe[0]);
+		close(error_pipe[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		/* Child process: only this thread exists here, and nothing but the savegame may be written. */
+		close(error_pipe[0]);
+		_sl.snapshot_child = true;
+		int status = 0;
+		try {
+			_sl.dumper = std::make_unique<MemoryDumper>();
+			_sl.sf = writer;
+			SlSaveChunks();
+			SaveFileToFilter();
+		} catch (...) {
+			status = 1;
+			uint32_t error_str = _sl.error_str;
+			bool ok = write(error_pipe[1], &error_str, sizeof(error_str)) == sizeof(error_str);
+			if (ok && !_sl.extra_msg.empty()) ok = write(error_pipe[1], _sl.extra_msg.data(), _sl.extra_msg.size()) == (ssize_t)_sl.extra_msg.size();
+			(void)ok;
+		}
+		_exit(status);
+	}
+
+	close(error_pipe[1]);
+	_async_save_thread.snapshot_temp_name = writer->Detach();
+	ClearSaveLoadState();
+
+	DEBUG(sl, 2, "Snapshot save process %d started", (int)pid);
+	_async_save_thread.snapshot_pid = pid;
+	_async_save_thread.snapshot_error_fd = error_pipe[0];
+	SaveFileStart();
+	return true;
+}
+
+/**
+ * Check whether the snapshot save process has finished, and if so report its result.
+ * @param wait Whether to wait for the process to finish.
+ */
+static void CheckSnapshotSave(bool wait)
+{
+	AsyncSaveThread &ast = _async_save_thread;
+	if (ast.snapshot_pid < 0) return;
+
+	int status = 0;
+	pid_t result;
+	do {
+		result = waitpid(ast.snapshot_pid, &status, wait ? 0 : WNOHANG);
+	} while (result < 0 && errno == EINTR);
+	if (result == 0) return;
+
+	const bool success = (result == ast.snapshot_pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	std::string error;
+	char buf[256];
+	ssize_t count;
+	while ((count = read(ast.snapshot_error_fd, buf, sizeof(buf))) > 0) {
+		error.append(buf, count);
+	}
+	close(ast.snapshot_error_fd);
+	ast.snapshot_error_fd = -1;
+	ast.snapshot_pid = -1;
+	std::string temp_name = std::move(ast.snapshot_temp_name);
+	ast.snapshot_temp_name.clear();
+
+	if (success) {
+		SaveFileDone();
+		return;
+	}
+
+	/* The process did not get to renaming the temporary file, or was killed. */
+	if (!temp_name.empty()) unlink(temp_name.c_str());
+
+	if (error.size() >= sizeof(uint32_t)) {
+		uint32_t error_str;
+		memcpy(&error_str, error.data(), sizeof(error_str));
+		_sl.error_str = error_str;
+		_sl.extra_msg = error.substr(sizeof(error_str));
+	} else {
+		_sl.error_str = STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE;
+		_sl.extra_msg = (result == ast.snapshot_pid && WIFSIGNALED(status)) ? stdstr_fmt("Snapshot save process killed by signal %d", WTERMSIG(status)) : "Snapshot save process failed";
+	}
+	_sl.action = SLA_SAVE;
+	DEBUG(sl, 0, "%s", strip_leading_colours(GetSaveLoadErrorString()));
+	SaveFileError();
+}
+#endif /* WITH_SNAPSHOT_SAVE */
+
 /**
  * Actually perform the saving of the savegame.
  * General tactics is to first save the game to memory, then write it to file
@@ -3827,11 +4796,12 @@ struct ThreadedLoadFilter : LoadFilter {
 
 /**
  * Actually perform the loading of a "non-old" savegame.
- * @param reader     The filter to read the savegame from.
- * @param load_check Whether to perform the checking ("preview") or actually load the game.
+ * @param reader      The filter to read the savegame from.
+ * @param load_check  Whether to perform the checking ("preview") or actually load the game.
+ * @param allow_delta Whether the savegame may be a delta savegame, see IsDeltaLoadAllowed.
  * @return Return the result of the action. #SL_OK or #SL_REINIT ("unload" the game)
  */
-static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_check)
+static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_check, bool allow_delta)
 {
 	_sl.lf = std::move(reader);
 
@@ -3918,6 +4888,11 @@ static SaveOrLoadResult DoLoad(std::shared_ptr<LoadFilter> reader, bool load_che
 		fmt++;
 	}
 
+	/* A delta savegame reads its base from the autosave directory, so it is only loaded from there. */
+	if (fmt->tag == TO_BE32X('OTTP') && !allow_delta) {
+		SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "Delta savegames can only be loaded from the autosave directory.");
+	}
+
 	/* loader for this savegame type is not implemented? */
 	if (fmt->init_load == nullptr) {
 		char err_str[64];
@@ -4072,7 +5047,7 @@ SaveOrLoadResult LoadWithFilter(std::shared_ptr<LoadFilter> reader)
 {
 	try {
 		_sl.action = SLA_LOAD;
-		return DoLoad(std::move(reader), false);
+		return DoLoad(std::move(reader), false, false);
 	} catch (...) {
 		ClearSaveLoadState();
 
@@ -4083,6 +5058,29 @@ SaveOrLoadResult LoadWithFilter(std::shared_ptr<LoadFilter> reader)
 	}
 }
 
+/**
+ * Check whether a delta savegame may be loaded from a file.
+ * That is only the case for local files in the autosave directory, as the base is read from there.
+ * @param filename The name of the savegame being loaded.
+ * @param sb The sub directory the savegame is loaded from.
+ * @return Whether a delta savegame may be loaded.
+ */
+static bool IsDeltaLoadAllowed(const std::string &filename, Subdirectory sb)
+{
+	if (filename.find("..") != std::string::npos) return false;
+	if (sb == AUTOSAVE_DIR) return true;
+	if (sb != NO_DIRECTORY) return false;
+
+	/* Files picked from the file list have their full path. */
+	const size_t separator = filename.rfind(PATHSEPCHAR);
+	if (separator == std::string::npos) return false;
+	const std::string_view dir = std::string_view(filename).substr(0, separator + 1);
+	for (Searchpath sp : _valid_searchpaths) {
+		if (FioGetDirectory(sp, AUTOSAVE_DIR) == dir) return true;
+	}
+	return false;
+}
+
 /**
  * Main Save or Load function where the high-level saveload functions are
  * handled. It opens the savegame, selects format and checks versions
@@ -4152,12 +5150,14 @@ SaveOrLoadResult SaveOrLoad(const std::string &filename, SaveLoadOperation fop,
 		FILE *fh = nullptr;
 		std::string temp_save_filename;
 		std::string temp_save_filename_suffix;
+		bool allow_delta = false;
 
 		if (fop == SLO_SAVE) {
 			temp_save_filename_suffix = stdstr_fmt(".tmp-%08x", InteractiveRandom());
 			fh = FioFOpenFile(filename + temp_save_filename_suffix, "wb", sb, nullptr, &temp_save_filename);
 		} else {
 			fh = FioFOpenFile(filename, "rb", sb);
+			allow_delta = fh != nullptr && IsDeltaLoadAllowed(filename, sb);
 
 			/* Make it a little easier to load savegames from the console */
 			if (fh == nullptr) fh = FioFOpenFile(filename, "rb", SAVE_DIR);
@@ -4174,13 +5174,17 @@ SaveOrLoadResult SaveOrLoad(const std::string &filename, SaveLoadOperation fop,
 			DEBUG(desync, 1, "save: %s; %s", debug_date_dumper().HexDate(), filename.c_str());
 			if (!_settings_client.gui.threaded_saves) threaded = false;
 
-			return DoSave(std::make_shared<FileWriter>(fh, temp_save_filename, temp_save_filename.substr(0, temp_save_filename.size() - temp_save_filename_suffix.size())), threaded);
+			auto writer = std::make_shared<FileWriter>(fh, temp_save_filename, temp_save_filename.substr(0, temp_save_filename.size() - temp_save_filename_suffix.size()));
+#ifdef WITH_SNAPSHOT_SAVE
+			if (threaded && (save_flags & SMF_SNAPSHOT) && DoSnapshotSave(writer)) return SL_OK;
+#endif
+			return DoSave(std::move(writer), threaded);
 		}
 
 		/* LOAD game */
 		assert(fop == SLO_LOAD || fop == SLO_CHECK);
 		DEBUG(desync, 1, "load: %s", filename.c_str());
-		return DoLoad(std::make_shared<FileReader>(fh), fop == SLO_CHECK);
+		return DoLoad(std::make_shared<FileReader>(fh), fop == SLO_CHECK, allow_delta);
 	} catch (...) {
 		/* This code may be executed both for old and new save games. */
 		ClearSaveLoadState();
@@ -4200,22 +5204,48 @@ SaveOrLoadResult SaveOrLoad(const std::string &filename, SaveLoadOperation fop,
  */
 void DoAutoOrNetsave(FiosNumberedSaveName &counter, bool threaded, FiosNumberedSaveName *lt_counter)
 {
+	extern FiosNumberedSaveName &GetAutoSaveFiosNumberedSaveName();
+
 	std::string filename;
+	SaveModeFlags save_flags = SMF_ZSTD_OK;
+	if (_settings_client.gui.snapshot_autosaves) save_flags |= SMF_SNAPSHOT;
+
+	/* Delta autosaves are written against the last full autosave with the same number. */
+	const bool use_delta = _settings_client.gui.delta_autosaves > 0 && !_settings_client.gui.keep_all_autosave && &counter == &GetAutoSaveFiosNumberedSaveName();
+	if (use_delta) {
+		/* The base is set by the save thread of the last full autosave. */
+		WaitTillSaved();
+	}
 
 	if (_settings_client.gui.keep_all_autosave) {
 		filename = GenerateDefaultSaveName() + counter.Extension();
+	} else if (use_delta && _delta_save_base.valid && _delta_save_base.deltas < _settings_client.gui.delta_autosaves) {
+		filename = counter.FilenameUsingNumber(counter.GetLastNumber(), stdstr_fmt("-delta%u", _delta_save_base.deltas + 1).c_str());
+		/* The delta autosave is counted by the process writing the savegame when it succeeds, so this cannot be a forked process. */
+		save_flags |= SMF_DELTA;
+		save_flags &= ~SMF_SNAPSHOT;
 	} else {
 		filename = counter.Filename();
+		std::string dir = FioFindDirectory(AUTOSAVE_DIR);
 		if (lt_counter != nullptr && counter.GetLastNumber() == 0) {
 			std::string lt_path = lt_counter->FilenameUsingMaxSaves(_settings_client.gui.max_num_lt_autosaves);
 			DEBUG(sl, 2, "Renaming autosave '%s' to long-term file '%s'", filename.c_str(), lt_path.c_str());
-			std::string dir = FioFindDirectory(AUTOSAVE_DIR);
 			FioRenameFile(dir + filename, dir + lt_path);
 		}
+		if (use_delta) {
+			/* Remove the delta autosaves against the full autosave which is about to be replaced. */
+			for (uint i = 1; FioRemove(dir + counter.FilenameUsingNumber(counter.GetLastNumber(), stdstr_fmt("-delta%u", i).c_str())); i++) {}
+
+			_delta_save_base = {};
+			_delta_save_base.filename = filename;
+			/* The base is remembered by the process writing the savegame, so this cannot be a forked process. */
+			save_flags |= SMF_DELTA_BASE;
+			save_flags &= ~SMF_SNAPSHOT;
+		}
 	}
 
 	DEBUG(sl, 2, "Autosaving to '%s'", filename.c_str());
-	if (SaveOrLoad(filename, SLO_SAVE, DFT_GAME_FILE, AUTOSAVE_DIR, threaded, SMF_ZSTD_OK) != SL_OK) {
+	if (SaveOrLoad(filename, SLO_SAVE, DFT_GAME_FILE, AUTOSAVE_DIR, threaded, save_flags) != SL_OK) {
 		ShowErrorMessage(STR_ERROR_AUTOSAVE_FAILED, INVALID_STRING_ID, WL_ERROR);
 	}
 }
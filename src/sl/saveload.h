@@ -61,6 +61,9 @@ enum SaveModeFlags : byte {
 	SMF_NET_SERVER       = 1 << 0, ///< Network server save
 	SMF_ZSTD_OK          = 1 << 1, ///< Zstd OK
 	SMF_SCENARIO         = 1 << 2, ///< Scenario save
+	SMF_SNAPSHOT         = 1 << 3, ///< Save from a copy-on-write snapshot in a forked process, where supported
+	SMF_DELTA            = 1 << 4, ///< Only save the differences to the base for delta autosaves
+	SMF_DELTA_BASE       = 1 << 5, ///< Remember this save as the base for delta autosaves
 };
 DECLARE_ENUM_AS_BIT_SET(SaveModeFlags);
 
@@ -73,6 +76,7 @@ SaveOrLoadResult SaveOrLoad(const std::string &filename, SaveLoadOperation fop,
 void WaitTillSaved();
 void ProcessAsyncSaveFinish();
 void DoExitSave();
+void ClearDeltaSaveBase();
 
 void DoAutoOrNetsave(FiosNumberedSaveName &counter, bool threaded, FiosNumberedSaveName *lt_counter = nullptr);
 
@@ -1097,6 +1101,7 @@ void SlProcessVENC();
 void SlResetTNNC();
 
 extern std::string _savegame_format;
+extern bool _savegame_framed;
 extern bool _do_autosave;
 
 #endif /* SL_SAVELOAD_H */
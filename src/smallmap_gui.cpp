@@ -394,7 +394,7 @@ static TileType GetSmallMapTileType(TileIndex tile, TileType t)
 static inline uint32_t GetSmallMapContoursPixels(TileIndex tile, TileType t)
 {
 	const SmallMapColourScheme *cs = &_heightmap_schemes[_settings_client.gui.smallmap_land_colour];
-	return ApplyMask(cs->height_colours[TileHeight(tile)], &_smallmap_contours_andor[GetSmallMapTileType(tile, t)]);
+	return ApplyMask(cs->height_colours[TileHeightShadow(tile)], &_smallmap_contours_andor[GetSmallMapTileType(tile, t)]);
 }
 
 /**
@@ -420,7 +420,7 @@ static inline uint32_t GetSmallMapVehiclesPixels(TileIndex tile, TileType t)
 static inline uint32_t GetSmallMapIndustriesPixels(TileIndex tile, TileType t)
 {
 	const SmallMapColourScheme *cs = &_heightmap_schemes[_settings_client.gui.smallmap_land_colour];
-	return ApplyMask(_smallmap_show_heightmap ? cs->height_colours[TileHeight(tile)] : cs->default_colour, &_smallmap_vehicles_andor[GetSmallMapTileType(tile, t)]);
+	return ApplyMask(_smallmap_show_heightmap ? cs->height_colours[TileHeightShadow(tile)] : cs->default_colour, &_smallmap_vehicles_andor[GetSmallMapTileType(tile, t)]);
 }
 
 /**
@@ -613,7 +613,7 @@ static inline uint32_t GetSmallMapOwnerPixels(TileIndex tile, TileType t)
 	if ((o < MAX_COMPANIES && !_legend_land_owners[_company_to_list_pos[o]].show_on_map) || o == OWNER_NONE || o == OWNER_WATER) {
 		if (t == MP_WATER) return MKCOLOUR_XXXX(PC_WATER);
 		const SmallMapColourScheme *cs = &_heightmap_schemes[_settings_client.gui.smallmap_land_colour];
-		return _smallmap_show_heightmap ? cs->height_colours[TileHeight(tile)] : cs->default_colour;
+		return _smallmap_show_heightmap ? cs->height_colours[TileHeightShadow(tile)] : cs->default_colour;
 	} else if (o == OWNER_TOWN) {
 		return MKCOLOUR_XXXX(PC_DARK_RED);
 	}
@@ -721,7 +721,7 @@ inline uint32_t SmallMapWindow::GetTileColours(const TileArea &ta) const
 	TileType et = MP_VOID;         // Effective tile type at that position.
 
 	for (TileIndex ti : ta) {
-		TileType ttype = GetTileType(ti);
+		TileType ttype = GetTileTypeShadow(ti);
 
 		switch (ttype) {
 			case MP_TUNNELBRIDGE: {
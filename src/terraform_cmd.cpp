@@ -17,6 +17,7 @@
 #include "company_base.h"
 #include "company_func.h"
 #include "core/backup_type.hpp"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 
@@ -328,6 +329,12 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32_t p1, u
 			int height = it.second;
 
 			SetTileHeight(t, (uint)height);
+
+			/* The height of the corner changes the slope of all tiles sharing it. */
+			YapfNotifyRoadLayoutChange(t);
+			if (TileX(t) > 0) YapfNotifyRoadLayoutChange(t - TileDiffXY(1, 0));
+			if (TileY(t) > 0) YapfNotifyRoadLayoutChange(t - TileDiffXY(0, 1));
+			if (TileX(t) > 0 && TileY(t) > 0) YapfNotifyRoadLayoutChange(t - TileDiffXY(1, 1));
 		}
 
 		if (c != nullptr) c->terraform_limit -= (uint32_t)ts.tile_to_new_height.size() << 16;
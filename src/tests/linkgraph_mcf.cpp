@@ -0,0 +1,33 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file linkgraph_mcf.cpp Test batched MCF path searches from linkgraph/mcf.cpp */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../map_func.h"
+#include "../linkgraph/linkgraphjob.h"
+
+TEST_CASE("MCF - batched path searches give the serial result")
+{
+	AllocateMap(256, 256);
+
+	LinkGraphSettings settings{};
+	settings.accuracy = 16;
+	settings.demand_size = 100;
+	settings.demand_distance = 100;
+	settings.short_path_saturation = 80;
+	settings.aircraft_link_scale = 100;
+
+	const auto [nodes, links] = GENERATE(table<uint, uint>({ { 2, 1 }, { 40, 2 }, { 150, 4 } }));
+	LinkGraphMCFComparison result = CompareLinkGraphMCFBatching(nodes, links, settings);
+	CHECK(result.serial_flow > 0);
+	CHECK(result.differing_edges == 0);
+	CHECK(result.serial_flow == result.batched_flow);
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file radix_heap.cpp Test functionality from misc/radixheap.hpp */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../misc/radixheap.hpp"
+
+#include <vector>
+
+struct RadixHeapTestItem {
+	int estimate;
+
+	int GetCostEstimate() const { return this->estimate; }
+};
+
+static std::vector<int> DrainRadixHeap(CRadixHeapT<RadixHeapTestItem> &heap)
+{
+	std::vector<int> result;
+	while (!heap.IsEmpty()) {
+		result.push_back(heap.Shift()->estimate);
+	}
+	return result;
+}
+
+TEST_CASE("RadixHeap - ordering")
+{
+	std::vector<RadixHeapTestItem> items = { { 40 }, { 7 }, { 1000000 }, { 7 }, { 0 }, { 65 }, { 64 }, { 1 } };
+	CRadixHeapT<RadixHeapTestItem> heap;
+	for (RadixHeapTestItem &item : items) heap.Include(&item);
+	CHECK(heap.Length() == 8);
+	CHECK(heap.Begin()->estimate == 0);
+	CHECK(DrainRadixHeap(heap) == std::vector<int>({ 0, 1, 7, 7, 40, 64, 65, 1000000 }));
+}
+
+TEST_CASE("RadixHeap - monotone and non-monotone insertion")
+{
+	std::vector<RadixHeapTestItem> items = { { 10 }, { 20 }, { 30 }, { 15 }, { 12 }, { 5 } };
+	CRadixHeapT<RadixHeapTestItem> heap;
+	heap.Include(&items[0]);
+	heap.Include(&items[1]);
+	heap.Include(&items[2]);
+	CHECK(heap.Shift()->estimate == 10);
+
+	/* Not lower than the last removed key. */
+	heap.Include(&items[3]);
+	heap.Include(&items[4]);
+	CHECK(heap.Shift()->estimate == 12);
+
+	/* Lower than the last removed key. */
+	heap.Include(&items[5]);
+	CHECK(DrainRadixHeap(heap) == std::vector<int>({ 5, 15, 20, 30 }));
+}
+
+TEST_CASE("RadixHeap - remove")
+{
+	std::vector<RadixHeapTestItem> items = { { 3 }, { 9 }, { 4 }, { 9 }, { 100 } };
+	CRadixHeapT<RadixHeapTestItem> heap;
+	for (RadixHeapTestItem &item : items) heap.Include(&item);
+	CHECK(heap.Shift()->estimate == 3);
+
+	heap.Remove(items[3]);
+	heap.Remove(items[4]);
+	CHECK(heap.Length() == 2);
+	CHECK(heap.Shift() == &items[2]);
+	CHECK(heap.Shift() == &items[1]);
+	CHECK(heap.IsEmpty());
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tracerestrict.cpp Test compiled execution of routefinding restriction programs. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../tracerestrict.h"
+
+#include <random>
+
+/** Random generator of valid programs, using only conditions and actions which do not look at the train. */
+struct TraceRestrictTestProgramGenerator {
+	std::mt19937 rng;
+	std::vector<TraceRestrictItem> items;
+	uint16_t next_penalty = 1;
+
+	TraceRestrictTestProgramGenerator(uint seed) : rng(seed) {}
+
+	bool Chance(uint percent)
+	{
+		return (this->rng() % 100) < percent;
+	}
+
+	/** Entry direction condition, which is true for input trackdir TRACKDIR_X_SW only if the direction is NE. */
+	void AddCondition(TraceRestrictCondFlags flags)
+	{
+		TraceRestrictItem item = 0;
+		SetTraceRestrictTypeAndNormalise(item, TRIT_COND_ENTRY_DIRECTION);
+		SetTraceRestrictCondFlags(item, flags);
+		SetTraceRestrictCondOp(item, TRCO_IS);
+		SetTraceRestrictValue(item, this->Chance(50) ? TRNTSV_NE : TRNTSV_SE);
+		this->items.push_back(item);
+	}
+
+	void AddEndIf(TraceRestrictCondFlags flags)
+	{
+		TraceRestrictItem item = 0;
+		SetTraceRestrictTypeAndNormalise(item, TRIT_COND_ENDIF);
+		SetTraceRestrictCondFlags(item, flags);
+		this->items.push_back(item);
+	}
+
+	/** Penalty action with a distinct power of two, so that the result shows exactly which actions were executed. */
+	void AddAction()
+	{
+		TraceRestrictItem item = 0;
+		SetTraceRestrictTypeAndNormalise(item, TRIT_PF_PENALTY);
+		SetTraceRestrictAuxField(item, TRPPAF_VALUE);
+		SetTraceRestrictValue(item, this->next_penalty);
+		this->next_penalty = (this->next_penalty < 0x8000) ? this->next_penalty << 1 : 1;
+		this->items.push_back(item);
+	}
+
+	void AddBlock(uint depth)
+	{
+		uint statements = this->rng() % 4;
+		for (uint i = 0; i < statements; i++) {
+			if (depth < 4 && this->Chance(40)) {
+				this->AddIfBlock(depth + 1);
+			} else {
+				this->AddAction();
+			}
+		}
+	}
+
+	void AddIfBlock(uint depth)
+	{
+		this->AddCondition(TRCF_DEFAULT);
+		this->AddBlock(depth);
+		uint branches = this->rng() % 4;
+		for (uint i = 0; i < branches; i++) {
+			this->AddCondition(this->Chance(50) ? TRCF_OR : TRCF_ELSE);
+			this->AddBlock(depth);
+		}
+		if (this->Chance(50)) {
+			this->AddEndIf(TRCF_ELSE);
+			this->AddBlock(depth);
+		}
+		this->AddEndIf(TRCF_DEFAULT);
+	}
+};
+
+TEST_CASE("TraceRestrictProgram - compiled execution matches interpreted execution")
+{
+	REQUIRE(TraceRestrictProgram::CanAllocateItem());
+	TraceRestrictProgram *prog = new TraceRestrictProgram();
+	TraceRestrictProgramInput input(0, TRACKDIR_X_SW, nullptr, nullptr);
+
+	for (uint seed = 0; seed < 500; seed++) {
+		TraceRestrictTestProgramGenerator gen(seed);
+		gen.AddBlock(0);
+		prog->items = gen.items;
+		REQUIRE(prog->Validate().Succeeded());
+
+		TraceRestrictProgramResult interpreted;
+		prog->ExecuteInterpreted(nullptr, input, interpreted);
+		TraceRestrictProgramResult compiled;
+		prog->Execute(nullptr, input, compiled);
+		CHECK(compiled.penalty == interpreted.penalty);
+		CHECK(compiled.flags == interpreted.flags);
+	}
+
+	delete prog;
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_thread.cpp Test functionality from worker_thread.h */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../worker_thread.h"
+
+#include <atomic>
+#include <numeric>
+
+TEST_CASE("WorkerTaskGroup - ParallelFor covers range once")
+{
+	WorkerThreadPool pool;
+	pool.Start("test:worker", 4);
+
+	std::vector<std::atomic<uint>> hits(10000);
+	std::atomic<size_t> largest_range = 0;
+	bool threaded;
+	{
+		WorkerTaskGroup group(WTC_OTHER, WJP_NORMAL, pool);
+		threaded = group.GetWorkerCount() > 0;
+		group.ParallelFor(0, hits.size(), 64, [&](size_t begin, size_t end) {
+			/* Catch2 assertions are not thread-safe, so only record the range size here. */
+			size_t size = end - begin;
+			size_t largest = largest_range.load(std::memory_order_relaxed);
+			while (size > largest && !largest_range.compare_exchange_weak(largest, size, std::memory_order_relaxed)) {}
+			for (size_t i = begin; i < end; i++) hits[i]++;
+		});
+	}
+
+	/* Without workers the whole range is run inline. */
+	if (threaded) CHECK(largest_range.load() <= 64);
+
+	bool all_once = true;
+	for (auto &h : hits) all_once &= (h.load() == 1);
+	CHECK(all_once);
+
+	pool.Stop();
+}
+
+TEST_CASE("WorkerTaskGroup - nested groups and join")
+{
+	WorkerThreadPool pool;
+	pool.Start("test:worker", 4);
+
+	std::vector<uint64_t> sums(16);
+	WorkerTaskGroup outer(WTC_OTHER, WJP_NORMAL, pool);
+	for (size_t i = 0; i < sums.size(); i++) {
+		outer.Enqueue([&pool, &sums, i]() {
+			std::vector<uint64_t> partial(100);
+			WorkerTaskGroup inner(WTC_OTHER, WJP_HIGH, pool);
+			inner.ParallelFor(0, partial.size(), 7, [&](size_t begin, size_t end) {
+				for (size_t j = begin; j < end; j++) partial[j] = j * (i + 1);
+			});
+			sums[i] = std::accumulate(partial.begin(), partial.end(), (uint64_t)0);
+		});
+	}
+	outer.Join();
+
+	for (size_t i = 0; i < sums.size(); i++) {
+		CHECK(sums[i] == 4950 * (i + 1));
+	}
+
+	CHECK(pool.GetTaskStats(WTC_OTHER).jobs >= sums.size());
+
+	pool.Stop();
+}
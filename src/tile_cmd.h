@@ -136,6 +136,14 @@ typedef void AddProducedCargoProc(TileIndex tile, CargoArray &produced);
 typedef bool ClickTileProc(TileIndex tile);
 typedef void AnimateTileProc(TileIndex tile);
 typedef void TileLoopProc(TileIndex tile);
+
+/**
+ * Tile callback function signature for checking whether the tile loop of a tile would do nothing other than its ambient sound effect.
+ * This is called from worker threads before the tile loop is run, so it must only read the tile itself and state which tile loops do not change.
+ * @param tile Tile being queried
+ * @return true if the tile loop proc of the tile can be replaced by AmbientSoundEffect
+ */
+typedef bool TileLoopIdleProc(TileIndex tile);
 typedef void ChangeTileOwnerProc(TileIndex tile, Owner old_owner, Owner new_owner);
 
 /** @see VehicleEnterTileStatus to see what the return values mean */
@@ -178,6 +186,7 @@ struct TileTypeProcs {
 	VehicleEnterTileProc *vehicle_enter_tile_proc; ///< Called when a vehicle enters a tile
 	GetFoundationProc *get_foundation_proc;
 	TerraformTileProc *terraform_tile_proc;        ///< Called when a terraforming operation is about to take place
+	TileLoopIdleProc *tile_loop_idle_proc;         ///< Called to check whether the tile loop may be skipped, optional
 };
 
 extern const TileTypeProcs * const _tile_type_procs[16];
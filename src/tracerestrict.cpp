@@ -9,6 +9,7 @@
 
 #include "stdafx.h"
 #include "tracerestrict.h"
+#include "tracerestrict_memo.h"
 #include "train.h"
 #include "core/bitmath_func.hpp"
 #include "core/container_func.hpp"
@@ -25,10 +26,14 @@
 #include "scope_info.h"
 #include "vehicle_func.h"
 #include "date_func.h"
+#include "debug.h"
 #include "3rdparty/cpp-btree/btree_map.h"
+#include "3rdparty/robin_hood/robin_hood.h"
 
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <type_traits>
 
 #include "safeguards.h"
 
@@ -239,8 +244,11 @@ static bool TestStationCondition(StationID station, TraceRestrictItem item)
  * Execute program on train and store results in out
  * @p v may not be nullptr
  * @p out should be zero-initialised
+ * @tparam use_branch_targets Whether to use the branch targets from Compile() to skip over branches which are not taken,
+ *                            instead of stepping through them and evaluating conditions whose result is not used
  */
-void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
+template <bool use_branch_targets>
+void TraceRestrictProgram::ExecuteIntl(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
 {
 	/* static to avoid needing to re-alloc/resize on each execution */
 	static std::vector<TraceRestrictCondStackFlags> condstack;
@@ -254,6 +262,7 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 
 	size_t size = this->items.size();
 	for (size_t i = 0; i < size; i++) {
+		const size_t offset = i;
 		TraceRestrictItem item = this->items[i];
 		TraceRestrictItemType type = GetTraceRestrictType(item);
 
@@ -268,11 +277,35 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 					assert(!(condstack.back() & TRCSF_SEEN_ELSE));
 					HandleCondition(condstack, condflags, true);
 					condstack.back() |= TRCSF_SEEN_ELSE;
+					if (use_branch_targets && !(condstack.back() & TRCSF_ACTIVE)) {
+						// an earlier branch was taken, skip to the end if
+						i = this->branch_targets[offset].end - 1;
+					}
 				} else {
 					// end if
 					condstack.pop_back();
 				}
 			} else {
+				if (use_branch_targets && !(condflags & (TRCF_OR | TRCF_ELSE)) && this->branch_targets[offset].no_actions) {
+					// if block without any actions, conditions have no side effects so the result would not be used
+					i = this->branch_targets[offset].end;
+					continue;
+				}
+				if (use_branch_targets && (condflags & (TRCF_OR | TRCF_ELSE))) {
+					assert(!condstack.empty());
+					if ((condflags & TRCF_OR) && (condstack.back() & TRCSF_ACTIVE)) {
+						// orif of an active branch, the condition result is not used
+						if (IsTraceRestrictDoubleItem(item)) i++;
+						continue;
+					}
+					if (condstack.back() & (TRCSF_DONE_IF | TRCSF_PARENT_INACTIVE)) {
+						// an earlier branch was taken, skip to the end if
+						condstack.back() &= ~TRCSF_ACTIVE;
+						i = this->branch_targets[offset].end - 1;
+						continue;
+					}
+				}
+
 				uint16_t condvalue = GetTraceRestrictValue(item);
 				bool result = false;
 				switch(type) {
@@ -639,6 +672,10 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 						NOT_REACHED();
 				}
 				HandleCondition(condstack, condflags, result);
+				if (use_branch_targets && !(condstack.back() & TRCSF_ACTIVE)) {
+					// branch not taken, skip to the next else/elif/orif/endif
+					i = this->branch_targets[offset].next - 1;
+				}
 			}
 		} else {
 			if (condstack.empty() || condstack.back() & TRCSF_ACTIVE) {
@@ -910,6 +947,304 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 	assert(condstack.empty());
 }
 
+/**
+ * Key of a memoised program result, see TraceRestrictProgram::Execute
+ * This includes the parts of the current order which order conditionals depend on, so that the memo does not need to be
+ * invalidated when the train advances to the next order
+ */
+struct TraceRestrictMemoKey {
+	uint32_t vehicle;
+	uint32_t program;
+	uint32_t tile;
+	uint32_t trackdir;
+	uint32_t input_flags;
+	uint32_t order_type;
+	uint32_t order_destination;
+	uint32_t order_index;
+	uint32_t last_station;
+
+	bool operator==(const TraceRestrictMemoKey &other) const = default;
+};
+static_assert(std::has_unique_object_representations_v<TraceRestrictMemoKey>);
+
+struct TraceRestrictMemoKeyHash {
+	size_t operator()(const TraceRestrictMemoKey &key) const noexcept
+	{
+		return robin_hood::hash_bytes(&key, sizeof(TraceRestrictMemoKey));
+	}
+};
+
+/**
+ * Memo of program results within a single tick
+ * The memo is emptied whenever the tick or the version changes, the version is changed whenever a slot occupancy or
+ * counter value changes, and around commands. It is never saved, so cannot make a server and a client diverge.
+ */
+struct TraceRestrictMemo {
+	robin_hood::unordered_flat_map<TraceRestrictMemoKey, TraceRestrictProgramResult, TraceRestrictMemoKeyHash> results;
+	StateTicks tick;
+	uint64_t version = 0;
+	uint64_t current_version = 1;
+	uint suspended = 0;
+	TraceRestrictMemoStats stats = {};
+
+	void Validate()
+	{
+		if (this->tick != _state_ticks || this->version != this->current_version) {
+			this->results.clear();
+			this->tick = _state_ticks;
+			this->version = this->current_version;
+		}
+	}
+};
+
+static TraceRestrictMemo _tracerestrict_memo;
+
+/** Invalidate the memo of program results, this must be called whenever any state which memoisable programs depend on changes */
+void InvalidateTraceRestrictMemo()
+{
+	_tracerestrict_memo.current_version++;
+	_tracerestrict_memo.stats.invalidations++;
+}
+
+const TraceRestrictMemoStats &GetTraceRestrictMemoStats()
+{
+	return _tracerestrict_memo.stats;
+}
+
+void ResetTraceRestrictMemoStats()
+{
+	_tracerestrict_memo.stats = {};
+}
+
+TraceRestrictMemoSuspendScope::TraceRestrictMemoSuspendScope()
+{
+	InvalidateTraceRestrictMemo();
+	_tracerestrict_memo.suspended++;
+}
+
+TraceRestrictMemoSuspendScope::~TraceRestrictMemoSuspendScope()
+{
+	_tracerestrict_memo.suspended--;
+	InvalidateTraceRestrictMemo();
+}
+
+/**
+ * Execute program on train and store results in out
+ * Programs which only depend on the train's static properties, its current order, slots, counters and the date are memoised for the rest of the tick,
+ * as the same train often executes the same program several times per tick (pathfinder, reservation and signal state)
+ * Executions which may change slots or counters, and executions with temporary slot state are not memoised
+ * @p v may be nullptr, in which case the memo is not used
+ * @p out should be zero-initialised
+ */
+void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
+{
+	TraceRestrictMemo &memo = _tracerestrict_memo;
+	if (!this->memoisable || v == nullptr || input.permitted_slot_operations != TRPISP_NONE || out.penalty != 0 || out.flags != 0 ||
+			memo.suspended > 0 || IsCommandExecuting() || TraceRestrictSlotTemporaryState::IsChangeStackActive()) {
+		memo.stats.bypassed++;
+		this->ExecuteUncached(v, input, out);
+		return;
+	}
+
+	TraceRestrictMemoKey key;
+	key.vehicle = v->index;
+	key.program = this->index;
+	key.tile = input.tile;
+	key.trackdir = input.trackdir;
+	key.input_flags = input.input_flags;
+	key.order_type = v->current_order.GetType();
+	key.order_destination = v->current_order.GetDestination();
+	key.order_index = v->cur_real_order_index;
+	key.last_station = v->last_station_visited;
+
+	memo.Validate();
+	auto iter = memo.results.find(key);
+	if (iter != memo.results.end()) {
+		memo.stats.hits++;
+		if (_debug_desync_level >= 2) {
+			this->ExecuteUncached(v, input, out);
+			if (out.penalty != iter->second.penalty || out.flags != iter->second.flags) {
+				DEBUG(desync, 0, "Memoised routefinding restriction result does not match, vehicle: %u, program: %u, tile: 0x%X", v->index, this->index, input.tile);
+			}
+			return;
+		}
+		out = iter->second;
+		return;
+	}
+
+	memo.stats.misses++;
+	this->ExecuteUncached(v, input, out);
+	memo.results[key] = out;
+}
+
+/**
+ * Execute program on train and store results in out, using the compiled program if available, without using the memo
+ * @p out should be zero-initialised
+ */
+void TraceRestrictProgram::ExecuteUncached(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
+{
+	if (this->branch_targets.size() == this->items.size()) {
+		this->ExecuteIntl<true>(v, input, out);
+	} else {
+		this->ExecuteIntl<false>(v, input, out);
+	}
+}
+
+/**
+ * Execute program on train and store results in out, stepping through every instruction
+ * This is only for comparison with Execute
+ */
+void TraceRestrictProgram::ExecuteInterpreted(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
+{
+	this->ExecuteIntl<false>(v, input, out);
+}
+
+/**
+ * Whether a condition only depends on state which does not change within a tick without invalidating the memo of program results
+ * Conditions on the train's position, speed, load and status may change whenever the train moves or loads
+ */
+static bool IsTraceRestrictConditionMemoisable(TraceRestrictItemType type)
+{
+	switch (type) {
+		case TRIT_COND_ENDIF:
+		case TRIT_COND_UNDEFINED:
+		case TRIT_COND_TRAIN_LENGTH:
+		case TRIT_COND_CURRENT_ORDER:
+		case TRIT_COND_NEXT_ORDER:
+		case TRIT_COND_LAST_STATION:
+		case TRIT_COND_CARGO:
+		case TRIT_COND_ENTRY_DIRECTION:
+		case TRIT_COND_TRAIN_GROUP:
+		case TRIT_COND_TRAIN_IN_SLOT:
+		case TRIT_COND_SLOT_OCCUPANCY:
+		case TRIT_COND_TRAIN_OWNER:
+		case TRIT_COND_COUNTER_VALUE:
+		case TRIT_COND_TIME_DATE_VALUE:
+		case TRIT_COND_CATEGORY:
+		case TRIT_COND_TARGET_DIRECTION:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Resolve the branch targets of all conditional instructions, so that Execute can skip over branches which are not taken,
+ * and find the if blocks which contain no actions, so that Execute can skip them entirely
+ * The program must be valid, see Validate
+ * The branch targets only depend on the instruction types and condition flags, not on the instruction values
+ */
+void TraceRestrictProgram::Compile()
+{
+	const uint32_t size = (uint32_t)this->items.size();
+	this->branch_targets.assign(size, { size, size, false });
+	this->memoisable = true;
+
+	std::vector<uint32_t> branches;   // array offsets of the if/else/elif/orif instructions of all open if blocks
+	std::vector<size_t> block_starts; // index into branches of the if instruction of each open if block
+	std::vector<bool> block_actions;  // whether each open if block contains any actions so far
+
+	for (uint32_t i = 0; i < size; i++) {
+		TraceRestrictItem item = this->items[i];
+		if (IsTraceRestrictConditional(item)) {
+			if (!IsTraceRestrictConditionMemoisable(GetTraceRestrictType(item))) this->memoisable = false;
+			TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
+			if (GetTraceRestrictType(item) == TRIT_COND_ENDIF && !(condflags & TRCF_ELSE)) {
+				// end if, resolve the whole block
+				assert(!block_starts.empty());
+				const size_t start = block_starts.back();
+				block_starts.pop_back();
+				const bool has_actions = block_actions.back();
+				block_actions.pop_back();
+				for (size_t j = start; j < branches.size(); j++) {
+					TraceRestrictBranchTarget &target = this->branch_targets[branches[j]];
+					target.next = (j + 1 < branches.size()) ? branches[j + 1] : i;
+					target.end = i;
+				}
+				this->branch_targets[branches[start]].no_actions = !has_actions;
+				branches.resize(start);
+				if (has_actions && !block_actions.empty()) block_actions.back() = true;
+			} else {
+				if (GetTraceRestrictType(item) != TRIT_COND_ENDIF && !(condflags & (TRCF_OR | TRCF_ELSE))) {
+					// if, start a new block
+					block_starts.push_back(branches.size());
+					block_actions.push_back(false);
+				}
+				branches.push_back(i);
+			}
+		} else if (!block_actions.empty()) {
+			block_actions.back() = true;
+		}
+		if (IsTraceRestrictDoubleItem(item)) i++;
+	}
+	assert(block_starts.empty());
+}
+
+/**
+ * Benchmark the execution of all programs for the trains of the current game, interpreted and compiled
+ * No slot or counter operations are permitted, so this does not change any game state
+ */
+TraceRestrictBenchmarkResult BenchmarkTraceRestrictPrograms(uint iterations)
+{
+	TraceRestrictBenchmarkResult result{};
+	result.iterations = iterations;
+
+	std::vector<const TraceRestrictProgram *> programs;
+	std::vector<TraceRestrictProgramInput> inputs;
+	for (const TraceRestrictProgram *prog : TraceRestrictProgram::Iterate()) {
+		if (prog->refcount == 0 || prog->items.empty()) continue;
+		TraceRestrictRefId ref = prog->GetRefIdsPtr()[0];
+		TileIndex tile = GetTraceRestrictRefIdTileIndex(ref);
+		Track track = GetTraceRestrictRefIdTrack(ref);
+		programs.push_back(prog);
+		inputs.emplace_back(tile, TrackToTrackdir(track), nullptr, nullptr);
+	}
+
+	std::vector<const Train *> trains;
+	for (const Train *t : Train::IterateFrontOnly()) {
+		if (t->IsPrimaryVehicle()) trains.push_back(t);
+	}
+
+	result.programs = (uint)programs.size();
+	result.trains = (uint)trains.size();
+	if (programs.empty() || trains.empty()) return result;
+
+	std::vector<TraceRestrictProgramResult> interpreted_results;
+	interpreted_results.reserve(programs.size() * trains.size());
+
+	auto run = [&](bool compiled) -> uint64_t {
+		auto start = std::chrono::steady_clock::now();
+		for (uint iter = 0; iter < iterations; iter++) {
+			size_t n = 0;
+			for (size_t p = 0; p < programs.size(); p++) {
+				for (const Train *t : trains) {
+					TraceRestrictProgramResult out;
+					if (compiled) {
+						programs[p]->ExecuteUncached(t, inputs[p], out);
+						if (iter == 0) {
+							const TraceRestrictProgramResult &expected = interpreted_results[n];
+							if (out.penalty != expected.penalty || out.flags != expected.flags ||
+									((out.flags & TRPRF_SPEED_RESTRICTION_SET) && out.speed_restriction != expected.speed_restriction)) {
+								result.mismatches++;
+							}
+						}
+					} else {
+						programs[p]->ExecuteInterpreted(t, inputs[p], out);
+						if (iter == 0) interpreted_results.push_back(out);
+					}
+					n++;
+				}
+			}
+		}
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	result.interpreted_us = run(false);
+	result.compiled_us = run(true);
+	return result;
+}
+
 void TraceRestrictProgram::ClearRefIds()
 {
 	if (this->refcount > 4) free(this->ref_ids.ptr_ref_ids.buffer);
@@ -2219,6 +2554,7 @@ CommandCost CmdProgramSignalTraceRestrict(TileIndex tile, DoCommandFlag flags, u
 		// move in modified program
 		prog->items.swap(items);
 		prog->actions_used_flags = actions_used_flags;
+		prog->Compile();
 
 		if (prog->items.size() == 0 && prog->refcount == 1) {
 			// program is empty, and this tile is the only reference to it
@@ -2549,6 +2885,7 @@ bool TraceRestrictSlot::Occupy(const Vehicle *v, bool force)
 	if (this->occupants.size() >= this->max_occupancy && !force) return false;
 	this->occupants.push_back(v->index);
 	this->AddIndex(v);
+	InvalidateTraceRestrictMemo();
 	this->UpdateSignals();
 	return true;
 }
@@ -2593,6 +2930,7 @@ void TraceRestrictSlot::Vacate(const Vehicle *v)
 {
 	if (container_unordered_remove(this->occupants, v->index)) {
 		this->DeIndex(v->index, v);
+		InvalidateTraceRestrictMemo();
 		this->UpdateSignals();
 	}
 }
@@ -2618,6 +2956,7 @@ void TraceRestrictSlot::Clear()
 		this->DeIndex(id, nullptr);
 	}
 	this->occupants.clear();
+	InvalidateTraceRestrictMemo();
 }
 
 void TraceRestrictSlot::UpdateSignals() {
@@ -2783,6 +3122,7 @@ void TraceRestrictSlotTemporaryState::PopFromChangeStackApplyTemporaryChanges(co
 
 	if (this->change_stack.empty()) {
 		this->ApplyTemporaryChanges(v);
+		InvalidateTraceRestrictMemo();
 	} else {
 		this->ApplyTemporaryChangesToParent(v->index, this->change_stack.back());
 	}
@@ -2800,6 +3140,7 @@ void TraceRestrictRemoveVehicleFromAllSlots(VehicleID vehicle_id)
 	}
 
 	const bool anything_to_erase = (start != it);
+	if (anything_to_erase) InvalidateTraceRestrictMemo();
 
 	slot_vehicle_index.erase(start, it);
 
@@ -3063,6 +3404,7 @@ void TraceRestrictCounter::UpdateValue(int32_t new_value)
 	new_value = std::max<int32_t>(0, new_value);
 	if (new_value != this->value) {
 		this->value = new_value;
+		InvalidateTraceRestrictMemo();
 		InvalidateWindowClassesData(WC_TRACE_RESTRICT_COUNTERS);
 		for (SignalReference sr : this->progsig_dependants) {
 			AddTrackToSignalBuffer(sr.tile, sr.track, GetTileOwner(sr.tile));
@@ -518,6 +518,8 @@ private:
 public:
 	static TraceRestrictSlotTemporaryState *GetCurrent() { return change_stack.back(); }
 
+	static bool IsChangeStackActive() { return !change_stack.empty(); }
+
 	static void ClearChangeStackApplyAllTemporaryChanges(const Vehicle *v)
 	{
 		while (!change_stack.empty()) {
@@ -582,6 +584,15 @@ struct TraceRestrictProgramResult {
 			: penalty(0), flags(static_cast<TraceRestrictProgramResultFlags>(0)) { }
 };
 
+/**
+ * Pre-resolved branch targets of a conditional instruction, see TraceRestrictProgram::Compile
+ */
+struct TraceRestrictBranchTarget {
+	uint32_t next;                           ///< Array offset of the next else/elif/orif/endif of the same if block
+	uint32_t end;                            ///< Array offset of the endif of the same if block
+	bool no_actions;                         ///< For an if instruction: the whole if block contains no actions, so it can be skipped without evaluating any conditions
+};
+
 /**
  * Program type, this stores the instruction list
  * This is refcounted, see info at top of tracerestrict.cpp
@@ -592,6 +603,11 @@ struct TraceRestrictProgram : TraceRestrictProgramPool::PoolItem<&_tracerestrict
 	TraceRestrictProgramActionsUsedFlags actions_used_flags;
 
 private:
+	std::vector<TraceRestrictBranchTarget> branch_targets; ///< Branch targets by array offset, empty if the program is not compiled
+	bool memoisable = false;                               ///< Whether the result only depends on state tracked by the per-tick memo, see Execute
+
+	template <bool use_branch_targets>
+	void ExecuteIntl(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
 
 	struct ptr_buffer {
 		TraceRestrictRefId *buffer;
@@ -623,6 +639,12 @@ public:
 
 	void Execute(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
 
+	void ExecuteUncached(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
+
+	void ExecuteInterpreted(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
+
+	void Compile();
+
 	inline const TraceRestrictRefId *GetRefIdsPtr() const { return const_cast<TraceRestrictProgram *>(this)->GetRefIdsPtr(); }
 
 	void IncrementRefCount(TraceRestrictRefId ref_id);
@@ -671,10 +693,17 @@ public:
 		return items.begin() + TraceRestrictProgram::InstructionOffsetToArrayOffset(items, instruction_offset);
 	}
 
-	/** Call validation function on current program instruction list and set actions_used_flags */
+	/** Call validation function on current program instruction list, set actions_used_flags and compile the program if it is valid */
 	CommandCost Validate()
 	{
-		return TraceRestrictProgram::Validate(items, actions_used_flags);
+		CommandCost result = TraceRestrictProgram::Validate(items, actions_used_flags);
+		if (result.Succeeded()) {
+			this->Compile();
+		} else {
+			this->branch_targets.clear();
+			this->memoisable = false;
+		}
+		return result;
 	}
 };
 
@@ -1181,6 +1210,18 @@ void TraceRestrictRemoveVehicleFromAllSlots(VehicleID id);
 void TraceRestrictTransferVehicleOccupantInAllSlots(VehicleID from, VehicleID to);
 void TraceRestrictGetVehicleSlots(VehicleID id, std::vector<TraceRestrictSlotID> &out);
 
+/** Timings of a trace restrict program execution benchmark. */
+struct TraceRestrictBenchmarkResult {
+	uint programs;           ///< Number of programs.
+	uint trains;             ///< Number of trains each program was executed for.
+	uint iterations;         ///< Number of times all programs were executed for all trains.
+	uint mismatches;         ///< Number of executions where the compiled result differed from the interpreted result.
+	uint64_t interpreted_us; ///< Time for interpreted execution, in microseconds.
+	uint64_t compiled_us;    ///< Time for compiled execution, in microseconds.
+};
+
+TraceRestrictBenchmarkResult BenchmarkTraceRestrictPrograms(uint iterations);
+
 static const uint MAX_LENGTH_TRACE_RESTRICT_SLOT_NAME_CHARS = 128; ///< The maximum length of a slot name in characters including '\0'
 
 /**
@@ -0,0 +1,34 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tracerestrict_memo.h Per-tick memo of routefinding restriction program results. */
+
+#ifndef TRACERESTRICT_MEMO_H
+#define TRACERESTRICT_MEMO_H
+
+/** Statistics of the per-tick memo of program results, see TraceRestrictProgram::Execute. */
+struct TraceRestrictMemoStats {
+	uint64_t hits;          ///< Executions answered from the memo.
+	uint64_t misses;        ///< Memoisable executions which were not in the memo.
+	uint64_t bypassed;      ///< Executions which could not use the memo.
+	uint64_t invalidations; ///< Number of times the memo was invalidated by a slot, counter or command.
+};
+
+void InvalidateTraceRestrictMemo();
+const TraceRestrictMemoStats &GetTraceRestrictMemoStats();
+void ResetTraceRestrictMemoStats();
+
+/**
+ * Suspend the per-tick memo of program results while a command is executed.
+ * The memo is invalidated on entry and on exit, and is not used in between.
+ */
+struct TraceRestrictMemoSuspendScope {
+	TraceRestrictMemoSuspendScope();
+	~TraceRestrictMemoSuspendScope();
+};
+
+#endif /* TRACERESTRICT_MEMO_H */
@@ -2602,16 +2602,6 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 }
 
 
-/**
- * Check if the vehicle is a train
- * @param v vehicle on tile
- * @return v if it is a train, nullptr otherwise
- */
-static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
-{
-	return v;
-}
-
 /**
  * Check if a level crossing tile has a train on it
  * @param tile tile to test
@@ -2622,28 +2612,24 @@ bool TrainOnCrossing(TileIndex tile)
 {
 	assert(IsLevelCrossingTile(tile));
 
-	return HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum);
+	return !GetVehiclesOnTile(tile, VEH_TRAIN).empty();
 }
 
 
 /**
  * Checks if a train is approaching a rail-road crossing
  * @param v vehicle on tile
- * @param data tile with crossing we are testing
- * @return v if it is approaching a crossing, nullptr otherwise
+ * @param tile tile with crossing we are testing
+ * @return true if it is approaching the crossing
  */
-static Vehicle *TrainApproachingCrossingEnum(Vehicle *v, void *data)
+static bool IsTrainApproachingCrossing(const Vehicle *v, TileIndex tile)
 {
-	if ((v->vehstatus & VS_CRASHED)) return nullptr;
+	if ((v->vehstatus & VS_CRASHED)) return false;
 
-	Train *t = Train::From(v);
-	if (!t->IsFrontEngine()) return nullptr;
+	const Train *t = Train::From(v);
+	if (!t->IsFrontEngine()) return false;
 
-	TileIndex tile = (TileIndex) reinterpret_cast<uintptr_t>(data);
-
-	if (TrainApproachingCrossingTile(t) != tile) return nullptr;
-
-	return t;
+	return TrainApproachingCrossingTile(t) == tile;
 }
 
 
@@ -2658,14 +2644,8 @@ static bool TrainApproachingCrossing(TileIndex tile)
 	dbg_assert_tile(IsLevelCrossingTile(tile), tile);
 
 	DiagDirection dir = AxisToDiagDir(GetCrossingRailAxis(tile));
-	TileIndex tile_from = tile + TileOffsByDiagDir(dir);
-
-	if (HasVehicleOnPos(tile_from, VEH_TRAIN, reinterpret_cast<void *>((uintptr_t)tile), &TrainApproachingCrossingEnum)) return true;
-
-	dir = ReverseDiagDir(dir);
-	tile_from = tile + TileOffsByDiagDir(dir);
-
-	return HasVehicleOnPos(tile_from, VEH_TRAIN, reinterpret_cast<void *>((uintptr_t)tile), &TrainApproachingCrossingEnum);
+	const TileIndex tiles_from[] = { tile + TileOffsByDiagDir(dir), tile + TileOffsByDiagDir(ReverseDiagDir(dir)) };
+	return HasVehicleOnTiles(tiles_from, VEH_TRAIN, [tile](const Vehicle *v) { return IsTrainApproachingCrossing(v, tile); });
 }
 
 /** Check if the crossing should be closed
@@ -5071,26 +5051,23 @@ struct TrainCollideChecker {
 /**
  * Collision test function.
  * @param v %Train vehicle to test collision with.
- * @param data %Train being examined.
- * @return \c nullptr (always continue search)
+ * @param tcc %Train being examined.
  */
-static Vehicle *FindTrainCollideEnum(Vehicle *v, void *data)
+static void FindTrainCollideEnum(Vehicle *v, TrainCollideChecker *tcc)
 {
-	TrainCollideChecker *tcc = (TrainCollideChecker*)data;
-
 	/* not in depot */
-	if (Train::From(v)->track == TRACK_BIT_DEPOT) return nullptr;
+	if (Train::From(v)->track == TRACK_BIT_DEPOT) return;
 
 	if (_settings_game.vehicle.no_train_crash_other_company) {
 		/* do not crash into trains of another company. */
-		if (v->owner != tcc->v->owner) return nullptr;
+		if (v->owner != tcc->v->owner) return;
 	}
 
 	/* get first vehicle now to make most usual checks faster */
 	Train *coll = Train::From(v)->First();
 
 	/* can't collide with own wagons */
-	if (coll == tcc->v) return nullptr;
+	if (coll == tcc->v) return;
 
 	int x_diff = v->x_pos - tcc->v->x_pos;
 	int y_diff = v->y_pos - tcc->v->y_pos;
@@ -5100,20 +5077,18 @@ static Vehicle *FindTrainCollideEnum(Vehicle *v, void *data)
 	 * Differences are shifted by 7, mapping range [-7 .. 8] into [0 .. 15]
 	 * Differences are then ORed and then we check for any higher bits */
 	uint hash = (y_diff + 7) | (x_diff + 7);
-	if (hash & ~15) return nullptr;
+	if (hash & ~15) return;
 
 	/* Slower check using multiplication */
 	int min_diff = (Train::From(v)->gcache.cached_veh_length + 1) / 2 + (tcc->v->gcache.cached_veh_length + 1) / 2 - 1;
-	if (x_diff * x_diff + y_diff * y_diff >= min_diff * min_diff) return nullptr;
+	if (x_diff * x_diff + y_diff * y_diff >= min_diff * min_diff) return;
 
 	/* Happens when there is a train under bridge next to bridge head */
-	if (abs(v->z_pos - tcc->v->z_pos) > 5) return nullptr;
+	if (abs(v->z_pos - tcc->v->z_pos) > 5) return;
 
 	/* crash both trains */
 	tcc->num += TrainCrashed(tcc->v);
 	tcc->num += TrainCrashed(coll);
-
-	return nullptr; // continue searching
 }
 
 /**
@@ -5135,11 +5110,12 @@ static bool CheckTrainCollision(Train *v)
 	tcc.num = 0;
 
 	/* find colliding vehicles */
+	auto collide = [&tcc](Vehicle *u) { FindTrainCollideEnum(u, &tcc); };
 	if (v->track & TRACK_BIT_WORMHOLE) {
-		FindVehicleOnPos(v->tile, VEH_TRAIN, &tcc, FindTrainCollideEnum);
-		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), VEH_TRAIN, &tcc, FindTrainCollideEnum);
+		FindVehicleOnPos(v->tile, VEH_TRAIN, collide);
+		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), VEH_TRAIN, collide);
 	} else {
-		FindVehicleOnPosXY(v->x_pos, v->y_pos, VEH_TRAIN, &tcc, FindTrainCollideEnum);
+		FindVehicleOnPosXY(v->x_pos, v->y_pos, VEH_TRAIN, collide);
 	}
 
 	/* any dead -> no crash */
@@ -5153,19 +5129,16 @@ static bool CheckTrainCollision(Train *v)
 	return true;
 }
 
-static Vehicle *CheckTrainAtSignal(Vehicle *v, void *data)
+static bool CheckTrainAtSignal(const Vehicle *v, DiagDirection exitdir)
 {
-	if ((v->vehstatus & VS_CRASHED)) return nullptr;
+	if ((v->vehstatus & VS_CRASHED)) return false;
 
-	Train *t = Train::From(v);
-	DiagDirection exitdir = *(DiagDirection *)data;
+	const Train *t = Train::From(v);
 
 	/* not front engine of a train, inside wormhole or depot, crashed */
-	if (!t->IsFrontEngine() || !(t->track & TRACK_BIT_MASK)) return nullptr;
+	if (!t->IsFrontEngine() || !(t->track & TRACK_BIT_MASK)) return false;
 
-	if (t->cur_speed > 5 || VehicleExitDir(t->direction, t->track) != exitdir) return nullptr;
-
-	return t;
+	return t->cur_speed <= 5 && VehicleExitDir(t->direction, t->track) == exitdir;
 }
 
 struct FindSpaceBetweenTrainsChecker {
@@ -5175,17 +5148,16 @@ struct FindSpaceBetweenTrainsChecker {
 };
 
 /** Find train in front and keep distance between trains in tunnel/bridge. */
-static Vehicle *FindSpaceBetweenTrainsEnum(Vehicle *v, void *data)
+static bool FindSpaceBetweenTrainsEnum(const Vehicle *v, const FindSpaceBetweenTrainsChecker *checker)
 {
 	/* Don't look at wagons between front and back of train. */
-	if ((v->Previous() != nullptr && v->Next() != nullptr)) return nullptr;
+	if ((v->Previous() != nullptr && v->Next() != nullptr)) return false;
 
 	if (!IsDiagonalDirection(v->direction)) {
 		/* Check for vehicles on non-across track pieces of custom bridge head */
-		if ((GetAcrossTunnelBridgeTrackBits(v->tile) & Train::From(v)->track & TRACK_BIT_ALL) == TRACK_BIT_NONE) return nullptr;
+		if ((GetAcrossTunnelBridgeTrackBits(v->tile) & Train::From(v)->track & TRACK_BIT_ALL) == TRACK_BIT_NONE) return false;
 	}
 
-	const FindSpaceBetweenTrainsChecker *checker = (FindSpaceBetweenTrainsChecker*) data;
 	int32_t a, b = 0;
 
 	switch (checker->direction) {
@@ -5196,8 +5168,7 @@ static Vehicle *FindSpaceBetweenTrainsEnum(Vehicle *v, void *data)
 		case DIAGDIR_NW: a = checker->pos; b = v->y_pos; break;
 	}
 
-	if (a > b && a <= (b + (int)(checker->distance)) + (int)(TILE_SIZE) - 1) return v;
-	return nullptr;
+	return a > b && a <= (b + (int)(checker->distance)) + (int)(TILE_SIZE) - 1;
 }
 
 static bool IsTooCloseBehindTrain(Train *t, TileIndex tile, uint16_t distance, bool check_endtile)
@@ -5248,7 +5219,8 @@ static bool IsTooCloseBehindTrain(Train *t, TileIndex tile, uint16_t distance, b
 		case DIAGDIR_NW: checker.pos = (TileY(tile) * TILE_SIZE) + TILE_UNIT_MASK; break;
 	}
 
-	if (HasVehicleOnPos(t->tile, VEH_TRAIN, &checker, &FindSpaceBetweenTrainsEnum)) {
+	auto in_front = [&checker](const Vehicle *v) { return FindSpaceBetweenTrainsEnum(v, &checker); };
+	if (HasVehicleOnPos(t->tile, VEH_TRAIN, in_front)) {
 		/* Revert train if not going with tunnel direction. */
 		if (checker.direction != GetTunnelBridgeDirection(t->tile)) {
 			SetBit(t->flags, VRF_REVERSING);
@@ -5257,7 +5229,7 @@ static bool IsTooCloseBehindTrain(Train *t, TileIndex tile, uint16_t distance, b
 	}
     /* Cover blind spot at end of tunnel bridge. */
 	if (check_endtile){
-		if (HasVehicleOnPos(GetOtherTunnelBridgeEnd(t->tile), VEH_TRAIN, &checker, &FindSpaceBetweenTrainsEnum)) {
+		if (HasVehicleOnPos(GetOtherTunnelBridgeEnd(t->tile), VEH_TRAIN, in_front)) {
 			/* Revert train if not going with tunnel direction. */
 			if (checker.direction != GetTunnelBridgeDirection(t->tile)) {
 				SetBit(t->flags, VRF_REVERSING);
@@ -5708,7 +5680,7 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 								exitdir = ReverseDiagDir(exitdir);
 
 								/* check if a train is waiting on the other side */
-								if (!HasVehicleOnPos(o_tile, VEH_TRAIN, &exitdir, &CheckTrainAtSignal)) return false;
+								if (!HasVehicleOnPos(o_tile, VEH_TRAIN, [exitdir](const Vehicle *u) { return CheckTrainAtSignal(u, exitdir); })) return false;
 							}
 						}
 
@@ -6221,25 +6193,6 @@ static TrackBits GetTrackbitsFromCrashedVehicle(Train *t)
 	}
 }
 
-/**
- * Collect trackbits of all crashed train vehicles on a tile
- * @param v Vehicle passed from Find/HasVehicleOnPos()
- * @param data trackdirbits for the result
- * @return nullptr to iterate over all vehicles on the tile.
- */
-static Vehicle *CollectTrackbitsFromCrashedVehiclesEnum(Vehicle *v, void *data)
-{
-	TrackBits *trackbits = (TrackBits *)data;
-
-	if ((v->vehstatus & VS_CRASHED) != 0) {
-		if (Train::From(v)->track != TRACK_BIT_DEPOT) {
-			*trackbits |= GetTrackbitsFromCrashedVehicle(Train::From(v));
-		}
-	}
-
-	return nullptr;
-}
-
 static void SetSignalledBridgeTunnelGreenIfClear(TileIndex tile, TileIndex end)
 {
 	if (TunnelBridgeIsFree(tile, end, nullptr, TBIFM_ACROSS_ONLY).Succeeded()) {
@@ -6262,10 +6215,10 @@ static bool IsRailStationPlatformOccupied(TileIndex tile)
 	TileIndexDiff delta = (GetRailStationAxis(tile) == AXIS_X ? TileDiffXY(1, 0) : TileDiffXY(0, 1));
 
 	for (TileIndex t = tile; IsCompatibleTrainStationTile(t, tile); t -= delta) {
-		if (HasVehicleOnPos(t, VEH_TRAIN, nullptr, &TrainOnTileEnum)) return true;
+		if (!GetVehiclesOnTile(t, VEH_TRAIN).empty()) return true;
 	}
 	for (TileIndex t = tile + delta; IsCompatibleTrainStationTile(t, tile); t += delta) {
-		if (HasVehicleOnPos(t, VEH_TRAIN, nullptr, &TrainOnTileEnum)) return true;
+		if (!GetVehiclesOnTile(t, VEH_TRAIN).empty()) return true;
 	}
 
 	return false;
@@ -6315,7 +6268,11 @@ static void DeleteLastWagon(Train *v)
 
 		/* If there are still crashed vehicles on the tile, give the track reservation to them */
 		TrackBits remaining_trackbits = TRACK_BIT_NONE;
-		FindVehicleOnPos(tile, VEH_TRAIN, &remaining_trackbits, CollectTrackbitsFromCrashedVehiclesEnum);
+		FindVehicleOnPos(tile, VEH_TRAIN, [&remaining_trackbits](Vehicle *u) {
+			if ((u->vehstatus & VS_CRASHED) != 0 && Train::From(u)->track != TRACK_BIT_DEPOT) {
+				remaining_trackbits |= GetTrackbitsFromCrashedVehicle(Train::From(u));
+			}
+		});
 
 		/* It is important that these two are the first in the loop, as reservation cannot deal with every trackbit combination */
 		dbg_assert(TRACK_BEGIN == TRACK_X && TRACK_Y == TRACK_BEGIN + 1);
@@ -1044,6 +1044,21 @@ static void TileLoop_Trees(TileIndex tile)
 	MarkTileDirtyByTile(tile, VMDF_NOT_MAP_MODE_NON_VEG);
 }
 
+static bool TileLoopIdle_Trees(TileIndex tile)
+{
+	if (GetTreeGround(tile) == TREE_GROUND_SHORE) return false;
+
+	/* Desert and snow depend on neighbouring tiles */
+	if (_settings_game.game_creation.landscape == LT_TROPIC || _settings_game.game_creation.landscape == LT_ARCTIC) return false;
+
+	/* See TileLoop_Trees */
+	uint32_t cycle = (uint32_t)((tile % 31) + (_tick_counter >> 8));
+	if ((cycle & 7) == 7 && GetTreeGround(tile) == TREE_GROUND_GRASS && GetTreeDensity(tile) < 3) return false;
+	if ((cycle & 15) < 15) return true;
+
+	return _settings_game.construction.extra_tree_placement == ETP_NO_GROWTH_NO_SPREAD || _settings_game.construction.tree_growth_rate == 4;
+}
+
 /**
  * Decrement the tree tick counter.
  * The interval is scaled by map size to allow for the same density regardless of size.
@@ -1135,4 +1150,5 @@ extern const TileTypeProcs _tile_type_trees_procs = {
 	nullptr,                     // vehicle_enter_tile_proc
 	GetFoundation_Trees,      // get_foundation_proc
 	TerraformTile_Trees,      // terraform_tile_proc
+	TileLoopIdle_Trees,       // tile_loop_idle_proc
 };
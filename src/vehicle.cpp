@@ -489,124 +489,126 @@ Vehicle::Vehicle(VehicleType type)
 	this->vcache.cached_veh_flags = 0;
 }
 
-using VehicleTypeTileHash = robin_hood::unordered_map<TileIndex, VehicleID>;
-static std::array<VehicleTypeTileHash, 4> _vehicle_tile_hashes;
-
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
-{
-	VehicleTypeTileHash &vhash = _vehicle_tile_hashes[type];
-
-	for (int y = yl; ; y++) {
-		for (int x = xl; ; x++) {
-			auto iter = vhash.find(TileXY(x, y));
-			if (iter != vhash.end()) {
-				Vehicle *v = Vehicle::Get(iter->second);
-				do {
-					Vehicle *a = proc(v, data);
-					if (find_first && a != nullptr) return a;
-
-					v = v->hash_tile_next;
-				} while (v != nullptr);
-			}
-			if (x == xu) break;
-		}
-		if (y == yu) break;
-	}
-
-	return nullptr;
-}
-
-
 /**
- * Helper function for FindVehicleOnPos/HasVehicleOnPos.
- * @note Do not call this function directly!
- * @param x    The X location on the map
- * @param y    The Y location on the map
- * @param data Arbitrary data passed to proc
- * @param proc The proc that determines whether a vehicle will be "found".
- * @param find_first Whether to return on the first found or iterate over
- *                   all vehicles
- * @return the best matching or first vehicle (depending on find_first).
+ * Tile location hash of the vehicles of one type.
+ * The vehicles on each tile are stored contiguously in blocks of a shared slot array,
+ * the size of a block is a power of two. Freed blocks are reused for blocks of the same size.
  */
-Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
-{
-	const int COLL_DIST = 6;
-
-	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = (x - COLL_DIST) / TILE_SIZE;
-	int xu = (x + COLL_DIST) / TILE_SIZE;
-	int yl = (y - COLL_DIST) / TILE_SIZE;
-	int yu = (y + COLL_DIST) / TILE_SIZE;
+struct VehicleTypeTileHash {
+	/** Block of the vehicles on one tile. */
+	struct Bucket {
+		uint32_t offset;    ///< First slot of the block.
+		uint32_t count;     ///< Number of vehicles in the block.
+		uint8_t size_class; ///< Size of the block is 1 << size_class.
+	};
 
-	return VehicleFromTileHash(xl, yl, xu, yu, type, data, proc, find_first);
-}
+	robin_hood::unordered_flat_map<TileIndex, Bucket> buckets;
+	std::vector<Vehicle *> slots;
+	std::vector<uint32_t> free_blocks[32];
 
-/**
- * Helper function for FindVehicleOnPos/HasVehicleOnPos.
- * @note Do not call this function directly!
- * @param tile The location on the map
- * @param data Arbitrary data passed to \a proc.
- * @param proc The proc that determines whether a vehicle will be "found".
- * @param find_first Whether to return on the first found or iterate over
- *                   all vehicles
- * @return the best matching or first vehicle (depending on find_first).
- */
-Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
-{
-	VehicleTypeTileHash &vhash = _vehicle_tile_hashes[type];
+	uint32_t AllocateBlock(uint8_t size_class)
+	{
+		std::vector<uint32_t> &free = this->free_blocks[size_class];
+		if (!free.empty()) {
+			uint32_t offset = free.back();
+			free.pop_back();
+			return offset;
+		}
+		uint32_t offset = (uint32_t)this->slots.size();
+		this->slots.resize(this->slots.size() + (1 << size_class), nullptr);
+		return offset;
+	}
 
-	auto iter = vhash.find(tile);
-	if (iter != vhash.end()) {
-		Vehicle *v = Vehicle::Get(iter->second);
-		do {
-			Vehicle *a = proc(v, data);
-			if (find_first && a != nullptr) return a;
+	void Insert(TileIndex tile, Vehicle *v)
+	{
+		auto res = this->buckets.insert({ tile, Bucket{ 0, 0, 0 } });
+		Bucket &bucket = res.first->second;
+		if (res.second) {
+			bucket.offset = this->AllocateBlock(0);
+		} else if (bucket.count == (1U << bucket.size_class)) {
+			uint32_t offset = this->AllocateBlock(bucket.size_class + 1);
+			std::copy_n(this->slots.begin() + bucket.offset, bucket.count, this->slots.begin() + offset);
+			this->free_blocks[bucket.size_class].push_back(bucket.offset);
+			bucket.offset = offset;
+			bucket.size_class++;
+		}
+		v->hash_tile_slot = bucket.count;
+		this->slots[bucket.offset + bucket.count] = v;
+		bucket.count++;
+	}
 
-			v = v->hash_tile_next;
-		} while (v != nullptr);
+	void Remove(TileIndex tile, Vehicle *v)
+	{
+		auto iter = this->buckets.find(tile);
+		assert(iter != this->buckets.end());
+		Bucket &bucket = iter->second;
+		assert(this->slots[bucket.offset + v->hash_tile_slot] == v);
+
+		/* Move the last vehicle of the tile into the freed slot. */
+		bucket.count--;
+		Vehicle *last = this->slots[bucket.offset + bucket.count];
+		this->slots[bucket.offset + v->hash_tile_slot] = last;
+		last->hash_tile_slot = v->hash_tile_slot;
+		this->slots[bucket.offset + bucket.count] = nullptr;
+
+		if (bucket.count == 0) {
+			this->free_blocks[bucket.size_class].push_back(bucket.offset);
+			this->buckets.erase(iter);
+		}
 	}
 
-	return nullptr;
-}
+	std::span<Vehicle * const> Find(TileIndex tile) const
+	{
+		auto iter = this->buckets.find(tile);
+		if (iter == this->buckets.end()) return {};
+		return { this->slots.data() + iter->second.offset, iter->second.count };
+	}
 
-/**
- * Callback that returns 'real' vehicles lower or at height \c *(int*)data .
- * @param v Vehicle to examine.
- * @param data unused.
- * @return \a v if conditions are met, else \c nullptr.
- */
-static Vehicle *EnsureNoVehicleProc(Vehicle *v, void *data)
-{
-	return v;
-}
+	void Clear()
+	{
+		this->buckets.clear();
+		this->slots.clear();
+		for (std::vector<uint32_t> &free : this->free_blocks) {
+			free.clear();
+		}
+	}
+};
+static std::array<VehicleTypeTileHash, 4> _vehicle_tile_hashes;
 
 /**
- * Callback that returns 'real' train-collidable road vehicles lower or at height \c *(int*)data .
- * @param v Vehicle to examine.
- * @param data unused
- * @return \a v if conditions are met, else \c nullptr.
+ * Get the vehicles of a type whose location is a tile.
+ * @note The result is invalidated by #UpdateVehicleTileHash adding a vehicle of the type to any tile,
+ *       as that may reallocate the storage of all tiles, or removing a vehicle from this tile.
+ *       That is, when Vehicle::UpdatePosition moves a vehicle of the type to another tile, including its first placement, or a vehicle of the type is deleted.
+ *       Changing anything else of a vehicle, including its position within the tile, leaves the result valid.
+ * @param tile The location on the map.
+ * @param type The type of vehicles.
+ * @return The vehicles on the tile, in no particular order.
  */
-static Vehicle *EnsureNoTrainCollidableRoadVehicleProc(Vehicle *v, void *data)
+std::span<Vehicle * const> GetVehiclesOnTile(TileIndex tile, VehicleType type)
 {
-	if (HasBit(_roadtypes_non_train_colliding, RoadVehicle::From(v)->roadtype)) return nullptr;
-
-	return v;
+	return _vehicle_tile_hashes[type].Find(tile);
 }
 
 /**
- * Callback that returns 'real' vehicles lower or at height \c *(int*)data .
- * @param v Vehicle to examine.
- * @param data Pointer to height data.
- * @return \a v if conditions are met, else \c nullptr.
+ * Get the vehicles of a type on each of several tiles, with all the hash lookups done in one pass.
+ * @note The results are invalidated in the same cases as the result of #GetVehiclesOnTile.
+ * @param tiles The locations on the map.
+ * @param type The type of vehicles.
+ * @param results Output for the vehicles on each of \a tiles, at least as large as \a tiles.
+ * @return Whether any of the tiles has a vehicle.
  */
-static Vehicle *EnsureNoAircraftProcZ(Vehicle *v, void *data)
+bool GetVehiclesOnTiles(std::span<const TileIndex> tiles, VehicleType type, std::span<Vehicle * const> *results)
 {
-	int z = static_cast<int>(reinterpret_cast<intptr_t>(data));
+	const VehicleTypeTileHash &vhash = _vehicle_tile_hashes[type];
+	if (vhash.buckets.empty()) return false;
 
-	if (v->subtype == AIR_SHADOW) return nullptr;
-	if (v->z_pos > z) return nullptr;
-
-	return v;
+	bool found = false;
+	for (size_t i = 0; i < tiles.size(); i++) {
+		results[i] = vhash.Find(tiles[i]);
+		found |= !results[i].empty();
+	}
+	return found;
 }
 
 /**
@@ -618,24 +620,24 @@ CommandCost EnsureNoVehicleOnGround(TileIndex tile)
 {
 	if (IsAirportTile(tile)) {
 		int z = GetTileMaxPixelZ(tile);
-		if (VehicleFromPos(tile, VEH_AIRCRAFT, reinterpret_cast<void *>(static_cast<intptr_t>(z)), &EnsureNoAircraftProcZ, true) != nullptr) {
+		if (HasVehicleOnPos(tile, VEH_AIRCRAFT, [z](const Vehicle *v) { return v->subtype != AIR_SHADOW && v->z_pos <= z; })) {
 			return CommandCost(STR_ERROR_AIRCRAFT_IN_THE_WAY);
 		}
 		return CommandCost();
 	}
 
 	if (IsTileType(tile, MP_RAILWAY) || IsLevelCrossingTile(tile) || HasStationTileRail(tile) || IsRailTunnelBridgeTile(tile)) {
-		if (VehicleFromPos(tile, VEH_TRAIN, nullptr, &EnsureNoVehicleProc, true) != nullptr) {
+		if (!GetVehiclesOnTile(tile, VEH_TRAIN).empty()) {
 			return CommandCost(STR_ERROR_TRAIN_IN_THE_WAY);
 		}
 	}
 	if (IsTileType(tile, MP_ROAD) || IsAnyRoadStopTile(tile) || (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeTransportType(tile) == TRANSPORT_ROAD)) {
-		if (VehicleFromPos(tile, VEH_ROAD, nullptr, &EnsureNoVehicleProc, true) != nullptr) {
+		if (!GetVehiclesOnTile(tile, VEH_ROAD).empty()) {
 			return CommandCost(STR_ERROR_ROAD_VEHICLE_IN_THE_WAY);
 		}
 	}
 	if (HasTileWaterClass(tile) || (IsBridgeTile(tile) && GetTunnelBridgeTransportType(tile) == TRANSPORT_WATER)) {
-		if (VehicleFromPos(tile, VEH_SHIP, nullptr, &EnsureNoVehicleProc, true) != nullptr) {
+		if (!GetVehiclesOnTile(tile, VEH_SHIP).empty()) {
 			return CommandCost(STR_ERROR_SHIP_IN_THE_WAY);
 		}
 	}
@@ -645,30 +647,9 @@ CommandCost EnsureNoVehicleOnGround(TileIndex tile)
 
 bool IsTrainCollidableRoadVehicleOnGround(TileIndex tile)
 {
-	return VehicleFromPos(tile, VEH_ROAD, nullptr, &EnsureNoTrainCollidableRoadVehicleProc, true) != nullptr;
-}
-
-struct GetVehicleTunnelBridgeProcData {
-	const Vehicle *v;
-	TileIndex t;
-	TunnelBridgeIsFreeMode mode;
-};
-
-/** Procedure called for every vehicle found in tunnel/bridge in the hash map */
-static Vehicle *GetVehicleTunnelBridgeProc(Vehicle *v, void *data)
-{
-	const GetVehicleTunnelBridgeProcData *info = (GetVehicleTunnelBridgeProcData*) data;
-	if (v == info->v) return nullptr;
-
-	if (v->type == VEH_TRAIN && info->mode != TBIFM_ALL && IsBridge(info->t)) {
-		TrackBits vehicle_track = Train::From(v)->track;
-		if (!(vehicle_track & TRACK_BIT_WORMHOLE)) {
-			if (info->mode == TBIFM_ACROSS_ONLY && !(GetAcrossBridgePossibleTrackBits(info->t) & vehicle_track)) return nullptr;
-			if (info->mode == TBIFM_PRIMARY_ONLY && !(GetPrimaryTunnelBridgeTrackBits(info->t) & vehicle_track)) return nullptr;
-		}
-	}
-
-	return v;
+	return HasVehicleOnPos(tile, VEH_ROAD, [](const Vehicle *v) {
+		return !HasBit(_roadtypes_non_train_colliding, RoadVehicle::From(v)->roadtype);
+	});
 }
 
 /**
@@ -685,16 +666,23 @@ CommandCost TunnelBridgeIsFree(TileIndex tile, TileIndex endtile, const Vehicle
 	 * error message only (which may be different for different machines).
 	 * Such a message does not affect MP synchronisation.
 	 */
-	GetVehicleTunnelBridgeProcData data;
-	data.v = ignore;
-	data.t = tile;
-	data.mode = mode;
+	auto in_the_way = [ignore, mode](TileIndex t) {
+		return [ignore, mode, t](const Vehicle *v) -> bool {
+			if (v == ignore) return false;
+
+			if (v->type == VEH_TRAIN && mode != TBIFM_ALL && IsBridge(t)) {
+				TrackBits vehicle_track = Train::From(v)->track;
+				if (!(vehicle_track & TRACK_BIT_WORMHOLE)) {
+					if (mode == TBIFM_ACROSS_ONLY && !(GetAcrossBridgePossibleTrackBits(t) & vehicle_track)) return false;
+					if (mode == TBIFM_PRIMARY_ONLY && !(GetPrimaryTunnelBridgeTrackBits(t) & vehicle_track)) return false;
+				}
+			}
+			return true;
+		};
+	};
 	VehicleType type = static_cast<VehicleType>(GetTunnelBridgeTransportType(tile));
-	Vehicle *v = VehicleFromPos(tile, type, &data, &GetVehicleTunnelBridgeProc, true);
-	if (v == nullptr) {
-		data.t = endtile;
-		v = VehicleFromPos(endtile, type, &data, &GetVehicleTunnelBridgeProc, true);
-	}
+	Vehicle *v = GetVehicleOnPos(tile, type, in_the_way(tile));
+	if (v == nullptr) v = GetVehicleOnPos(endtile, type, in_the_way(endtile));
 
 	if (v != nullptr) return_cmd_error(STR_ERROR_TRAIN_IN_THE_WAY + v->type);
 	return CommandCost();
@@ -708,21 +696,19 @@ struct FindTrainClosestToTunnelBridgeEndInfo {
 	FindTrainClosestToTunnelBridgeEndInfo(DiagDirection direction) : best(nullptr), best_pos(INT32_MIN), direction(direction) {}
 };
 
-/** Callback for Has/FindVehicleOnPos to find a train in a signalled tunnel/bridge */
-static Vehicle *FindClosestTrainToTunnelBridgeEndEnum(Vehicle *v, void *data)
+/** Visit a vehicle found in a signalled tunnel/bridge, when looking for the closest train. */
+static void FindClosestTrainToTunnelBridgeEndEnum(Vehicle *v, FindTrainClosestToTunnelBridgeEndInfo *info)
 {
-	FindTrainClosestToTunnelBridgeEndInfo *info = (FindTrainClosestToTunnelBridgeEndInfo *)data;
-
 	/* Only look for train heads and tails. */
-	if (v->Previous() != nullptr && v->Next() != nullptr) return nullptr;
+	if (v->Previous() != nullptr && v->Next() != nullptr) return;
 
-	if ((v->vehstatus & VS_CRASHED)) return nullptr;
+	if ((v->vehstatus & VS_CRASHED)) return;
 
 	Train *t = Train::From(v);
 
 	if (!IsDiagonalDirection(t->direction)) {
 		/* Check for vehicles on non-across track pieces of custom bridge head */
-		if ((GetAcrossTunnelBridgeTrackBits(t->tile) & t->track & TRACK_BIT_ALL) == TRACK_BIT_NONE) return nullptr;
+		if ((GetAcrossTunnelBridgeTrackBits(t->tile) & t->track & TRACK_BIT_ALL) == TRACK_BIT_NONE) return;
 	}
 
 	int32_t pos;
@@ -739,15 +725,14 @@ static Vehicle *FindClosestTrainToTunnelBridgeEndEnum(Vehicle *v, void *data)
 		info->best = t->First();
 		info->best_pos = pos;
 	}
-
-	return t;
 }
 
 Train *GetTrainClosestToTunnelBridgeEnd(TileIndex tile, TileIndex other_tile)
 {
 	FindTrainClosestToTunnelBridgeEndInfo info(ReverseDiagDir(GetTunnelBridgeDirection(tile)));
-	FindVehicleOnPos(tile, VEH_TRAIN, &info, FindClosestTrainToTunnelBridgeEndEnum);
-	FindVehicleOnPos(other_tile, VEH_TRAIN, &info, FindClosestTrainToTunnelBridgeEndEnum);
+	auto visit = [&info](Vehicle *v) { FindClosestTrainToTunnelBridgeEndEnum(v, &info); };
+	FindVehicleOnPos(tile, VEH_TRAIN, visit);
+	FindVehicleOnPos(other_tile, VEH_TRAIN, visit);
 	return info.best;
 }
 
@@ -758,17 +743,16 @@ struct GetAvailableFreeTilesInSignalledTunnelBridgeChecker {
 	int lowest_seen;
 };
 
-static Vehicle *GetAvailableFreeTilesInSignalledTunnelBridgeEnum(Vehicle *v, void *data)
+static void GetAvailableFreeTilesInSignalledTunnelBridgeEnum(const Vehicle *v, GetAvailableFreeTilesInSignalledTunnelBridgeChecker *checker)
 {
 	/* Don't look at wagons between front and back of train. */
-	if ((v->Previous() != nullptr && v->Next() != nullptr)) return nullptr;
+	if ((v->Previous() != nullptr && v->Next() != nullptr)) return;
 
 	if (!IsDiagonalDirection(v->direction)) {
 		/* Check for vehicles on non-across track pieces of custom bridge head */
-		if ((GetAcrossTunnelBridgeTrackBits(v->tile) & Train::From(v)->track & TRACK_BIT_ALL) == TRACK_BIT_NONE) return nullptr;
+		if ((GetAcrossTunnelBridgeTrackBits(v->tile) & Train::From(v)->track & TRACK_BIT_ALL) == TRACK_BIT_NONE) return;
 	}
 
-	GetAvailableFreeTilesInSignalledTunnelBridgeChecker *checker = (GetAvailableFreeTilesInSignalledTunnelBridgeChecker*) data;
 	int v_pos;
 
 	switch (checker->direction) {
@@ -781,8 +765,6 @@ static Vehicle *GetAvailableFreeTilesInSignalledTunnelBridgeEnum(Vehicle *v, voi
 	if (v_pos > checker->pos && v_pos < checker->lowest_seen) {
 		checker->lowest_seen = v_pos;
 	}
-
-	return nullptr;
 }
 
 int GetAvailableFreeTilesInSignalledTunnelBridgeWithStartOffset(TileIndex entrance, TileIndex exit, int offset)
@@ -808,8 +790,9 @@ int GetAvailableFreeTilesInSignalledTunnelBridge(TileIndex entrance, TileIndex e
 		case DIAGDIR_NW: checker.pos = -(int)(TileY(tile) * TILE_SIZE); break;
 	}
 
-	FindVehicleOnPos(entrance, VEH_TRAIN, &checker, &GetAvailableFreeTilesInSignalledTunnelBridgeEnum);
-	FindVehicleOnPos(exit, VEH_TRAIN, &checker, &GetAvailableFreeTilesInSignalledTunnelBridgeEnum);
+	auto visit = [&checker](const Vehicle *v) { GetAvailableFreeTilesInSignalledTunnelBridgeEnum(v, &checker); };
+	FindVehicleOnPos(entrance, VEH_TRAIN, visit);
+	FindVehicleOnPos(exit, VEH_TRAIN, visit);
 
 	if (checker.lowest_seen == INT_MAX) {
 		/* Remainder of bridge/tunnel is clear */
@@ -819,20 +802,21 @@ int GetAvailableFreeTilesInSignalledTunnelBridge(TileIndex entrance, TileIndex e
 	return (checker.lowest_seen - checker.pos) / TILE_SIZE;
 }
 
-static Vehicle *EnsureNoTrainOnTrackProc(Vehicle *v, void *data)
+/**
+ * Tests if a train interacts with the specified track bits.
+ * @param t The train.
+ * @param rail_bits The track bits, #TRACK_BIT_WORMHOLE matches any train in the wormhole.
+ * @return Whether the train interacts with the track bits.
+ */
+static inline bool IsTrainOnTrackBits(const Train *t, TrackBits rail_bits)
 {
-	TrackBits rail_bits = *(TrackBits *)data;
-
-	Train *t = Train::From(v);
 	if (rail_bits & TRACK_BIT_WORMHOLE) {
-		if (t->track & TRACK_BIT_WORMHOLE) return v;
+		if (t->track & TRACK_BIT_WORMHOLE) return true;
 		rail_bits &= ~TRACK_BIT_WORMHOLE;
 	} else if (t->track & TRACK_BIT_WORMHOLE) {
-		return nullptr;
+		return false;
 	}
-	if ((t->track != rail_bits) && !TracksOverlap(t->track | rail_bits)) return nullptr;
-
-	return v;
+	return (t->track == rail_bits) || TracksOverlap(t->track | rail_bits);
 }
 
 /**
@@ -849,7 +833,7 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 	 * error message only (which may be different for different machines).
 	 * Such a message does not affect MP synchronisation.
 	 */
-	Vehicle *v = VehicleFromPos(tile, VEH_TRAIN, &track_bits, &EnsureNoTrainOnTrackProc, true);
+	Vehicle *v = GetVehicleOnPos(tile, VEH_TRAIN, [track_bits](const Vehicle *v) { return IsTrainOnTrackBits(Train::From(v), track_bits); });
 	if (v != nullptr) return_cmd_error(STR_ERROR_TRAIN_IN_THE_WAY + v->type);
 	return CommandCost();
 }
@@ -869,37 +853,8 @@ void UpdateVehicleTileHash(Vehicle *v, bool remove)
 
 	VehicleTypeTileHash &vhash = _vehicle_tile_hashes[v->type];
 
-	/* Remove from the old position in the hash table */
-	if (old_hash_tile != INVALID_TILE) {
-		if (v->hash_tile_next != nullptr) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
-		if (v->hash_tile_prev != nullptr) {
-			v->hash_tile_prev->hash_tile_next = v->hash_tile_next;
-		} else {
-			/* This was the first vehicle in the chain */
-			if (v->hash_tile_next != nullptr) {
-				vhash[old_hash_tile] = v->hash_tile_next->index;
-			} else {
-				vhash.erase(old_hash_tile);
-			}
-		}
-	}
-
-	/* Insert vehicle at beginning of the new position in the hash table */
-	if (new_hash_tile != INVALID_TILE) {
-		auto res = vhash.insert({ new_hash_tile, v->index });
-		if (res.second) {
-			/* Insert took place */
-			v->hash_tile_next = nullptr;
-			v->hash_tile_prev = nullptr;
-		} else {
-			/* Key already existed */
-			Vehicle *next = Vehicle::Get(res.first->second);
-			next->hash_tile_prev = v;
-			v->hash_tile_next = next;
-			v->hash_tile_prev = nullptr;
-			res.first->second = v->index;
-		}
-	}
+	if (old_hash_tile != INVALID_TILE) vhash.Remove(old_hash_tile, v);
+	if (new_hash_tile != INVALID_TILE) vhash.Insert(new_hash_tile, v);
 
 	/* Remember current hash tile */
 	v->hash_tile_current = new_hash_tile;
@@ -916,14 +871,8 @@ bool ValidateVehicleTileHash(const Vehicle *v)
 
 	if (v->hash_tile_current != v->tile) return false;
 
-	auto iter = _vehicle_tile_hashes[v->type].find(v->hash_tile_current);
-	if (iter == _vehicle_tile_hashes[v->type].end()) return false;
-
-	for (const Vehicle *u = Vehicle::GetIfValid(iter->second); u != nullptr; u = u->hash_tile_next) {
-		if (u == v) return true;
-	}
-
-	return false;
+	std::span<Vehicle * const> vehicles = _vehicle_tile_hashes[v->type].Find(v->hash_tile_current);
+	return v->hash_tile_slot < vehicles.size() && vehicles[v->hash_tile_slot] == v;
 }
 
 static Vehicle *_vehicle_viewport_hash[1 << (GEN_HASHX_BITS + GEN_HASHY_BITS)];
@@ -1000,13 +949,12 @@ static void ProcessDeferredUpdateVehicleViewportHashes()
 void ResetVehicleHash()
 {
 	for (Vehicle *v : Vehicle::Iterate()) {
-		v->hash_tile_next = nullptr;
-		v->hash_tile_prev = nullptr;
+		v->hash_tile_slot = 0;
 		v->hash_tile_current = INVALID_TILE;
 	}
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
 	for (VehicleTypeTileHash &vhash : _vehicle_tile_hashes) {
-		vhash.clear();
+		vhash.Clear();
 	}
 }
 
@@ -1659,6 +1607,10 @@ void CallVehicleTicks()
 	if (!_tick_effect_veh_cache.empty()) RecordSyncEvent(NSRE_VEH_EFFECT);
 	{
 		PerformanceMeasurer framerate(PFE_GL_TRAINS);
+		/* Trains are ticked serially, in tick cache order. The controller of a train reserves paths, changes signal
+		 * and level crossing states, moves vehicles in the position hashes and can crash other trains, and the
+		 * controllers of later trains read all of that. The per-part tail has to follow the train's own controller
+		 * directly, as a later controller can crash the train or change its speed. */
 		for (Train *front : _tick_train_front_cache) {
 			v = front;
 			if (!front->Train::Tick()) continue;
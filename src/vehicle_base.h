@@ -353,8 +353,7 @@ public:
 	Vehicle *hash_viewport_next;        ///< NOSAVE: Next vehicle in the visual location hash.
 	Vehicle **hash_viewport_prev;       ///< NOSAVE: Previous vehicle in the visual location hash.
 
-	Vehicle *hash_tile_next;            ///< NOSAVE: Next vehicle in the tile location hash.
-	Vehicle *hash_tile_prev;            ///< NOSAVE: Previous vehicle in the tile location hash.
+	uint32_t hash_tile_slot;            ///< NOSAVE: Index of the vehicle in the tile location hash block of #hash_tile_current.
 	TileIndex hash_tile_current = INVALID_TILE; ///< NOSAVE: current tile used for tile location hash.
 
 	byte breakdown_severity;            ///< severity of the breakdown. Note that lower means more severe
@@ -20,6 +20,8 @@
 #include "track_type.h"
 #include "livery.h"
 #include "cargo_type.h"
+#include "map_func.h"
+#include <span>
 #include <vector>
 
 #define is_custom_sprite(x) (x >= 0xFD)
@@ -45,6 +47,111 @@ typedef Vehicle *VehicleFromPosProc(Vehicle *v, void *data);
 void VehicleServiceInDepot(Vehicle *v);
 uint CountVehiclesInChain(const Vehicle *v);
 
+std::span<Vehicle * const> GetVehiclesOnTile(TileIndex tile, VehicleType type);
+bool GetVehiclesOnTiles(std::span<const TileIndex> tiles, VehicleType type, std::span<Vehicle * const> *results);
+
+/**
+ * Call a functor for all vehicles of a type whose location is a tile.
+ * YOU must make SURE that the result of the calls is ALWAYS the same
+ * regardless of the order in which the vehicles are visited!
+ * When you fail to do this properly you create an almost untraceable DESYNC!
+ * @note \a func must not move any vehicle of \a type to a different tile.
+ * @param tile The location on the map.
+ * @param type The type of vehicles.
+ * @param func Functor called with each vehicle, as Vehicle *.
+ */
+template <typename F>
+inline void FindVehicleOnPos(TileIndex tile, VehicleType type, F func)
+{
+	for (Vehicle *v : GetVehiclesOnTile(tile, type)) {
+		func(v);
+	}
+}
+
+/**
+ * Get a vehicle of a type whose location is a tile, and which matches a predicate.
+ * Which vehicle is returned when several match is unspecified, so use this only
+ * to test for presence, or when the choice does not affect the game state.
+ * @param tile The location on the map.
+ * @param type The type of vehicles.
+ * @param pred Predicate called with vehicles, as Vehicle *, until it returns true.
+ * @return The first vehicle for which \a pred returned true, or nullptr.
+ */
+template <typename F>
+inline Vehicle *GetVehicleOnPos(TileIndex tile, VehicleType type, F pred)
+{
+	for (Vehicle *v : GetVehiclesOnTile(tile, type)) {
+		if (pred(v)) return v;
+	}
+	return nullptr;
+}
+
+/**
+ * Checks whether a vehicle of a type whose location is a tile matches a predicate.
+ * @param tile The location on the map.
+ * @param type The type of vehicles.
+ * @param pred Predicate called with vehicles, as Vehicle *, until it returns true.
+ * @return True if \a pred returned true for any vehicle.
+ */
+template <typename F>
+inline bool HasVehicleOnPos(TileIndex tile, VehicleType type, F pred)
+{
+	return GetVehicleOnPos(tile, type, pred) != nullptr;
+}
+
+/**
+ * Checks whether a vehicle of a type whose location is any of several tiles matches a predicate.
+ * The hash lookups of the tiles are done in one pass before any vehicle is examined,
+ * which is cheaper than individual queries when most of the tiles have no vehicles.
+ * @param tiles The locations on the map.
+ * @param type The type of vehicles.
+ * @param pred Predicate called with vehicles, as Vehicle *, until it returns true.
+ * @return True if \a pred returned true for any vehicle.
+ */
+template <typename F>
+inline bool HasVehicleOnTiles(std::span<const TileIndex> tiles, VehicleType type, F pred)
+{
+	static const size_t BATCH = 32;
+	std::span<Vehicle * const> results[BATCH];
+	for (size_t begin = 0; begin < tiles.size(); begin += BATCH) {
+		std::span<const TileIndex> batch = tiles.subspan(begin, std::min(BATCH, tiles.size() - begin));
+		if (!GetVehiclesOnTiles(batch, type, results)) continue;
+		for (size_t i = 0; i < batch.size(); i++) {
+			for (Vehicle *v : results[i]) {
+				if (pred(v)) return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Call a functor for all vehicles of a type whose location is a tile which
+ * is close enough to a position to collide with a vehicle at that position.
+ * The same rules as for #FindVehicleOnPos apply.
+ * @param x    The X location on the map
+ * @param y    The Y location on the map
+ * @param type The type of vehicles.
+ * @param func Functor called with each vehicle, as Vehicle *.
+ */
+template <typename F>
+inline void FindVehicleOnPosXY(int x, int y, VehicleType type, F func)
+{
+	const int COLL_DIST = 6;
+
+	/* Hash area to scan is from xl,yl to xu,yu */
+	int xl = (x - COLL_DIST) / TILE_SIZE;
+	int xu = (x + COLL_DIST) / TILE_SIZE;
+	int yl = (y - COLL_DIST) / TILE_SIZE;
+	int yu = (y + COLL_DIST) / TILE_SIZE;
+
+	for (int ty = yl; ty <= yu; ty++) {
+		for (int tx = xl; tx <= xu; tx++) {
+			FindVehicleOnPos(TileXY(tx, ty), type, func);
+		}
+	}
+}
+
 /**
  * Find a vehicle from a specific location. It will call \a proc for ALL vehicles
  * on the tile and YOU must make SURE that the "best one" is stored in the
@@ -52,23 +159,20 @@ uint CountVehiclesInChain(const Vehicle *v);
  * where proc was called on!
  * When you fail to do this properly you create an almost untraceable DESYNC!
  * @note The return value of \a proc will be ignored.
- * @note Use this function when you have the intention that all vehicles
- *       should be iterated over.
+ * @note Prefer the overload taking a functor in new code.
  * @param tile The location on the map
  * @param data Arbitrary data passed to \a proc.
  * @param proc The proc that determines whether a vehicle will be "found".
  */
 inline void FindVehicleOnPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc)
 {
-	extern Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first);
-	VehicleFromPos(tile, type, data, proc, false);
+	FindVehicleOnPos(tile, type, [&](Vehicle *v) { proc(v, data); });
 }
 
 /**
  * Checks whether a vehicle is on a specific location. It will call \a proc for
  * vehicles until it returns non-nullptr.
- * @note Use #FindVehicleOnPos when you have the intention that all vehicles
- *       should be iterated over.
+ * @note Prefer the overload taking a predicate in new code.
  * @param tile The location on the map
  * @param data Arbitrary data passed to \a proc.
  * @param proc The \a proc that determines whether a vehicle will be "found".
@@ -76,8 +180,7 @@ inline void FindVehicleOnPos(TileIndex tile, VehicleType type, void *data, Vehic
  */
 inline bool HasVehicleOnPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc)
 {
-	extern Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first);
-	return VehicleFromPos(tile, type, data, proc, true) != nullptr;
+	return HasVehicleOnPos(tile, type, [&](Vehicle *v) { return proc(v, data) != nullptr; });
 }
 
 /**
@@ -87,8 +190,7 @@ inline bool HasVehicleOnPos(TileIndex tile, VehicleType type, void *data, Vehicl
  * where proc was called on!
  * When you fail to do this properly you create an almost untraceable DESYNC!
  * @note The return value of proc will be ignored.
- * @note Use this when you have the intention that all vehicles
- *       should be iterated over.
+ * @note Prefer the overload taking a functor in new code.
  * @param x    The X location on the map
  * @param y    The Y location on the map
  * @param data Arbitrary data passed to proc
@@ -96,25 +198,7 @@ inline bool HasVehicleOnPos(TileIndex tile, VehicleType type, void *data, Vehicl
  */
 inline void FindVehicleOnPosXY(int x, int y, VehicleType type, void *data, VehicleFromPosProc *proc)
 {
-	extern Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first);
-	VehicleFromPosXY(x, y, type, data, proc, false);
-}
-
-/**
- * Checks whether a vehicle in on a specific location. It will call proc for
- * vehicles until it returns non-nullptr.
- * @note Use FindVehicleOnPosXY when you have the intention that all vehicles
- *       should be iterated over.
- * @param x    The X location on the map
- * @param y    The Y location on the map
- * @param data Arbitrary data passed to proc
- * @param proc The proc that determines whether a vehicle will be "found".
- * @return True if proc returned non-nullptr.
- */
-inline bool HasVehicleOnPosXY(int x, int y, VehicleType type, void *data, VehicleFromPosProc *proc)
-{
-	extern Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first);
-	return VehicleFromPosXY(x, y, type, data, proc, true) != nullptr;
+	FindVehicleOnPosXY(x, y, type, [&](Vehicle *v) { proc(v, data); });
 }
 
 void CallVehicleTicks();
@@ -11,10 +11,17 @@
 #include "worker_thread.h"
 #include "thread.h"
 
+#include <chrono>
+
 #include "safeguards.h"
 
 WorkerThreadPool _general_worker_pool;
 
+/** Pool which the current thread is a worker of, if any. */
+static thread_local const WorkerThreadPool *_current_worker_pool = nullptr;
+/** Index of the queue owned by the current thread in #_current_worker_pool. */
+static thread_local uint _current_worker_queue = 0;
+
 void WorkerThreadPool::Start(const char *thread_name, uint max_workers)
 {
 	uint cpus = std::thread::hardware_concurrency();
@@ -22,16 +29,23 @@ void WorkerThreadPool::Start(const char *thread_name, uint max_workers)
 
 	std::lock_guard<std::mutex> lk(this->lock);
 
+	/* Queues can't be added while workers are using them */
+	if (this->workers > 0) return;
+
 	this->exit = false;
 
 	uint worker_target = std::min<uint>(max_workers, cpus);
-	if (this->workers >= worker_target) return;
+	if (worker_target == 0) return;
 
-	uint new_workers = worker_target - this->workers;
+	/* Queue 0 is for jobs queued by threads which are not workers */
+	this->queues.clear();
+	for (uint i = 0; i <= worker_target; i++) {
+		this->queues.push_back(std::make_unique<WorkerQueue>());
+	}
 
-	for (uint i = 0; i < new_workers; i++) {
+	for (uint i = 0; i < worker_target; i++) {
 		this->workers++;
-		if (!StartNewThread(nullptr, thread_name, &WorkerThreadPool::Run, this)) {
+		if (!StartNewThread(nullptr, thread_name, &WorkerThreadPool::Run, this, i + 1)) {
 			this->workers--;
 			return;
 		}
@@ -46,39 +60,215 @@ void WorkerThreadPool::Stop()
 	this->done_cv.wait(lk, [this]() { return this->workers == 0; });
 }
 
-void WorkerThreadPool::EnqueueJob(WorkerJobFunc *func, void *data1, void *data2, void *data3)
+/**
+ * Get the index of the queue owned by the current thread.
+ * @return Queue index, or 0 if the current thread is not a worker of this pool.
+ */
+uint WorkerThreadPool::GetCurrentQueueIndex() const
 {
-	std::unique_lock<std::mutex> lk(this->lock);
+	return (_current_worker_pool == this) ? _current_worker_queue : 0;
+}
+
+void WorkerThreadPool::PushJob(WorkerJobPriority priority, const WorkerJob &job)
+{
+	WorkerQueue &queue = *this->queues[this->GetCurrentQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lk(queue.lock);
+		queue.jobs[priority].push_back(job);
+	}
+
+	std::lock_guard<std::mutex> lk(this->lock);
+	this->pending_jobs++;
+	if (this->workers_waiting > 0) this->worker_wait_cv.notify_one();
+}
+
+/**
+ * Take a job to run.
+ * Higher priorities are always searched first. Within a priority the own queue is used first (newest job first),
+ * then the queue of jobs from non-worker threads, and then the oldest jobs of the other workers are stolen.
+ * @param self Queue index of the current thread.
+ * @param job Output for the job.
+ * @param group If not nullptr, only take jobs of this group.
+ * @return Whether a job was found.
+ */
+bool WorkerThreadPool::TryPopJob(uint self, WorkerJob &job, const WorkerTaskGroup *group)
+{
+	const uint queue_count = (uint)this->queues.size();
+	if (queue_count == 0) return false;
+
+	auto try_pop = [&](uint index, WorkerJobPriority priority, bool back) -> bool {
+		WorkerQueue &queue = *this->queues[index];
+		std::lock_guard<std::mutex> lk(queue.lock);
+		std::deque<WorkerJob> &jobs = queue.jobs[priority];
+		if (jobs.empty()) return false;
+		if (group == nullptr) {
+			if (back) {
+				job = jobs.back();
+				jobs.pop_back();
+			} else {
+				job = jobs.front();
+				jobs.pop_front();
+			}
+			return true;
+		}
+		for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+			if (it->group == group) {
+				job = *it;
+				jobs.erase(it);
+				return true;
+			}
+		}
+		return false;
+	};
+
+	for (WorkerJobPriority priority = WJP_HIGH; priority < WJP_END; priority = (WorkerJobPriority)(priority + 1)) {
+		uint source = UINT_MAX;
+		if (self != 0 && try_pop(self, priority, true)) {
+			source = self;
+		} else if (try_pop(0, priority, false)) {
+			source = 0;
+		} else {
+			for (uint i = 1; i < queue_count; i++) {
+				uint victim = ((self + i - 1) % (queue_count - 1)) + 1;
+				if (victim == self) continue;
+				if (try_pop(victim, priority, false)) {
+					source = victim;
+					break;
+				}
+			}
+		}
+		if (source == UINT_MAX) continue;
+
+		{
+			std::lock_guard<std::mutex> lk(this->lock);
+			this->pending_jobs--;
+		}
+		if (job.group != nullptr) job.group->OnJobPopped();
+		if (source != 0 && source != self) this->task_stats[job.task_class].stolen.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void WorkerThreadPool::ExecuteJob(const WorkerJob &job)
+{
+	using namespace std::chrono;
+	const auto start = steady_clock::now();
+	job.func(job.data1, job.data2, job.data3);
+	const uint64_t duration = (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+	TaskClassCounters &stats = this->task_stats[job.task_class];
+	stats.jobs.fetch_add(1, std::memory_order_relaxed);
+	stats.busy_us.fetch_add(duration, std::memory_order_relaxed);
+
+	if (job.group != nullptr) job.group->OnJobDone();
+}
+
+void WorkerThreadPool::EnqueueJob(WorkerJobPriority priority, WorkerTaskClass task_class, WorkerJobFunc *func, void *data1, void *data2, void *data3)
+{
+	WorkerJob job { func, data1, data2, data3, nullptr, task_class };
 	if (this->workers == 0) {
 		/* Just execute it here and now */
-		lk.unlock();
-		func(data1, data2, data3);
+		this->ExecuteJob(job);
 		return;
 	}
-	bool notify = this->jobs.size() < (size_t)this->workers_waiting;
-	this->jobs.push({ func, data1, data2, data3 });
-	lk.unlock();
-	if (notify) this->worker_wait_cv.notify_one();
+	this->PushJob(priority, job);
 }
 
-void WorkerThreadPool::Run(WorkerThreadPool *pool)
+/**
+ * Get the cumulative statistics of a class of jobs.
+ * @param task_class Class of jobs.
+ * @return Statistics since the game was started.
+ */
+WorkerTaskStats WorkerThreadPool::GetTaskStats(WorkerTaskClass task_class) const
 {
-	std::unique_lock<std::mutex> lk(pool->lock);
-	while (!pool->exit || !pool->jobs.empty()) {
-		if (pool->jobs.empty()) {
-			pool->workers_waiting++;
-			pool->worker_wait_cv.wait(lk);
-			pool->workers_waiting--;
-		} else {
-			WorkerJob job = pool->jobs.front();
-			pool->jobs.pop();
-			lk.unlock();
-			job.func(job.data1, job.data2, job.data3);
-			lk.lock();
+	const TaskClassCounters &stats = this->task_stats[task_class];
+	return { stats.jobs.load(std::memory_order_relaxed), stats.busy_us.load(std::memory_order_relaxed), stats.stolen.load(std::memory_order_relaxed) };
+}
+
+void WorkerThreadPool::Run(WorkerThreadPool *pool, uint queue_index)
+{
+	_current_worker_pool = pool;
+	_current_worker_queue = queue_index;
+
+	while (true) {
+		WorkerJob job;
+		if (pool->TryPopJob(queue_index, job, nullptr)) {
+			pool->ExecuteJob(job);
+			continue;
 		}
+
+		std::unique_lock<std::mutex> lk(pool->lock);
+		if (pool->pending_jobs > 0) continue;
+		if (pool->exit) break;
+		pool->workers_waiting++;
+		pool->worker_wait_cv.wait(lk);
+		pool->workers_waiting--;
 	}
+
+	std::lock_guard<std::mutex> lk(pool->lock);
 	pool->workers--;
 	if (pool->workers == 0) {
 		pool->done_cv.notify_all();
 	}
 }
+
+void WorkerTaskGroup::OnJobPopped()
+{
+	std::lock_guard<std::mutex> lk(this->lock);
+	this->queued--;
+}
+
+void WorkerTaskGroup::OnJobDone()
+{
+	std::lock_guard<std::mutex> lk(this->lock);
+	this->outstanding--;
+	if (this->outstanding == 0) this->cv.notify_all();
+}
+
+/**
+ * Queue a job in this group.
+ * If the pool has no workers, the job is run immediately.
+ */
+void WorkerTaskGroup::EnqueueJob(WorkerJobFunc *func, void *data1, void *data2, void *data3)
+{
+	WorkerThreadPool::WorkerJob job { func, data1, data2, data3, this, this->task_class };
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		this->outstanding++;
+		if (this->pool.workers != 0) {
+			this->queued++;
+			this->enqueued++;
+			this->cv.notify_all();
+		}
+	}
+
+	if (this->pool.workers == 0) {
+		this->pool.ExecuteJob(job);
+		return;
+	}
+	this->pool.PushJob(this->priority, job);
+}
+
+/** Wait for all jobs of the group to complete, running queued jobs of this group on the current thread meanwhile. */
+void WorkerTaskGroup::Join()
+{
+	const uint self = this->pool.GetCurrentQueueIndex();
+	std::unique_lock<std::mutex> lk(this->lock);
+	while (this->outstanding > 0) {
+		if (this->queued > 0) {
+			const uint seen = this->enqueued;
+			lk.unlock();
+			WorkerThreadPool::WorkerJob job;
+			const bool found = this->pool.TryPopJob(self, job, this);
+			if (found) this->pool.ExecuteJob(job);
+			lk.lock();
+
+			/* The queued jobs have been taken by other threads, or are not in a queue yet.
+			 * Wait until all jobs have completed or further jobs have been queued, instead of spinning. */
+			if (!found) this->cv.wait(lk, [&]() { return this->outstanding == 0 || this->enqueued != seen; });
+		} else {
+			this->cv.wait(lk);
+		}
+	}
+}
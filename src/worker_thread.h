@@ -10,36 +10,104 @@
 #ifndef WORKER_THREAD_H
 #define WORKER_THREAD_H
 
-#include "core/ring_buffer_queue.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 typedef void WorkerJobFunc(void *, void *, void *);
 
+/** Priority of a worker job, jobs of a higher priority are always started first. */
+enum WorkerJobPriority : uint8_t {
+	WJP_HIGH,                ///< Jobs which drawing or the game loop are waiting on
+	WJP_NORMAL,              ///< Default priority
+	WJP_LOW,                 ///< Background jobs which nothing is immediately waiting on
+	WJP_END,
+};
+
+/** Classes of worker jobs, for accounting of time spent in the worker pool. */
+enum WorkerTaskClass : uint8_t {
+	WTC_OTHER,               ///< Unclassified jobs
+	WTC_VIEWPORT,            ///< Viewport rendering
+	WTC_VEHICLE_TICK,        ///< Vehicle tick phases
+	WTC_LANDSCAPE,           ///< Tile loop
+	WTC_LINKGRAPH,           ///< Link graph job handlers
+	WTC_SAVELOAD,            ///< Savegame serialisation and compression
+	WTC_NEWGRF_MD5,          ///< NewGRF MD5 hashing
+	WTC_END,
+};
+
+/** Cumulative statistics of the jobs of one #WorkerTaskClass. */
+struct WorkerTaskStats {
+	uint64_t jobs;           ///< Number of jobs run
+	uint64_t busy_us;        ///< Total time spent running jobs, in microseconds
+	uint64_t stolen;         ///< Number of jobs run by a different worker than the one which queued them
+};
+
+class WorkerTaskGroup;
+
 struct WorkerThreadPool {
 private:
+	friend WorkerTaskGroup;
+
 	struct WorkerJob {
 		WorkerJobFunc *func;
 		void *data1;
 		void *data2;
 		void *data3;
+		WorkerTaskGroup *group;
+		WorkerTaskClass task_class;
+	};
+
+	/**
+	 * Job deques of one worker, the owner pushes and pops at the back, other workers steal from the front.
+	 * Queue 0 of the pool is not owned by a worker, this is where jobs from other threads are queued.
+	 */
+	struct WorkerQueue {
+		std::mutex lock;
+		std::deque<WorkerJob> jobs[WJP_END];
+	};
+
+	struct TaskClassCounters {
+		std::atomic<uint64_t> jobs;
+		std::atomic<uint64_t> busy_us;
+		std::atomic<uint64_t> stolen;
 	};
 
-	uint workers = 0;
+	std::atomic<uint> workers = 0;
 	uint workers_waiting = 0;
+	uint pending_jobs = 0;
 	bool exit = false;
 	std::mutex lock;
-	ring_buffer_queue<WorkerJob> jobs;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
 	std::condition_variable worker_wait_cv;
 	std::condition_variable done_cv;
+	TaskClassCounters task_stats[WTC_END] = {};
 
-	static void Run(WorkerThreadPool *pool);
+	static void Run(WorkerThreadPool *pool, uint queue_index);
+
+	uint GetCurrentQueueIndex() const;
+	void PushJob(WorkerJobPriority priority, const WorkerJob &job);
+	bool TryPopJob(uint self, WorkerJob &job, const WorkerTaskGroup *group);
+	void ExecuteJob(const WorkerJob &job);
 
 public:
 
 	void Start(const char *thread_name, uint max_workers);
 	void Stop();
-	void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr);
+	void EnqueueJob(WorkerJobPriority priority, WorkerTaskClass task_class, WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr);
+
+	void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr)
+	{
+		this->EnqueueJob(WJP_NORMAL, WTC_OTHER, func, data1, data2, data3);
+	}
+
+	/** Get the number of worker threads, not including any thread which is joining a task group. */
+	uint GetWorkerCount() const { return this->workers; }
+
+	WorkerTaskStats GetTaskStats(WorkerTaskClass task_class) const;
 
 	~WorkerThreadPool()
 	{
@@ -49,4 +117,98 @@ public:
 
 extern WorkerThreadPool _general_worker_pool;
 
+/**
+ * Group of jobs which can be joined as a whole.
+ * Jobs may themselves add further jobs to the group, the group is done when all of them have completed.
+ * A thread which joins the group helps by running queued jobs of the same group, so groups may be nested and joined from worker threads.
+ */
+class WorkerTaskGroup {
+	friend WorkerThreadPool;
+
+	WorkerThreadPool &pool;
+	const WorkerJobPriority priority;
+	const WorkerTaskClass task_class;
+	uint outstanding = 0; ///< Jobs which have been queued but not yet completed, protected by lock
+	uint queued = 0;      ///< Jobs which are still in a queue, protected by lock
+	uint enqueued = 0;    ///< Jobs which have been queued in total, protected by lock
+	std::mutex lock;
+	std::condition_variable cv;
+
+	void OnJobPopped();
+	void OnJobDone();
+
+	template <typename F>
+	static void RunFunctor(void *data1, void *, void *)
+	{
+		std::unique_ptr<F> func(static_cast<F *>(data1));
+		(*func)();
+	}
+
+public:
+	WorkerTaskGroup(WorkerTaskClass task_class, WorkerJobPriority priority = WJP_NORMAL, WorkerThreadPool &pool = _general_worker_pool)
+			: pool(pool), priority(priority), task_class(task_class) {}
+
+	~WorkerTaskGroup()
+	{
+		this->Join();
+	}
+
+	WorkerTaskGroup(const WorkerTaskGroup &) = delete;
+	WorkerTaskGroup &operator=(const WorkerTaskGroup &) = delete;
+
+	void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr);
+
+	/**
+	 * Queue a functor as a job of this group.
+	 * @param func Functor to call, with no arguments.
+	 */
+	template <typename F>
+	void Enqueue(F &&func)
+	{
+		using FT = std::decay_t<F>;
+		this->EnqueueJob(&WorkerTaskGroup::RunFunctor<FT>, new FT(std::forward<F>(func)));
+	}
+
+	void Join();
+
+	/** Get the number of worker threads which can run jobs of this group. */
+	uint GetWorkerCount() const { return this->pool.GetWorkerCount(); }
+
+	/**
+	 * Call a functor for all sub-ranges of [begin, end), and wait for all calls to complete.
+	 * The range is split recursively, so that idle workers can steal the upper halves of large ranges.
+	 * Sub-ranges are disjoint but are processed in an unspecified order, any reduction should be done by index afterwards to be deterministic.
+	 * @param begin Start of the range.
+	 * @param end End of the range (exclusive).
+	 * @param grain Maximum size of a sub-range passed to \a func.
+	 * @param func Functor to call with the (begin, end) of each sub-range.
+	 */
+	template <typename F>
+	void ParallelFor(size_t begin, size_t end, size_t grain, F &&func)
+	{
+		struct Splitter {
+			WorkerTaskGroup *group;
+			std::decay_t<F> *func;
+			size_t grain;
+
+			void operator()(size_t b, size_t e) const
+			{
+				while (e - b > this->grain) {
+					size_t mid = b + ((e - b) / 2);
+					Splitter split = *this;
+					this->group->Enqueue([split, mid, e]() { split(mid, e); });
+					e = mid;
+				}
+				if (b != e) (*this->func)(b, e);
+			}
+		};
+
+		std::decay_t<F> f(std::forward<F>(func));
+		if (grain == 0) grain = 1;
+		if (this->GetWorkerCount() == 0) grain = std::max<size_t>(grain, end - begin);
+		Splitter { this, &f, grain }(begin, end);
+		this->Join();
+	}
+};
+
 #endif /* WORKER_THREAD_H */